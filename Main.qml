@@ -4,6 +4,7 @@ import QtQuick.Layouts 1.15
 import SerialApp 1.0
 import QtLocation 5.15
 import QtPositioning 5.15
+import QtMultimedia
 import "view"
 import Qt.labs.settings
 
@@ -33,6 +34,12 @@ ApplicationWindow {
     property bool capturePanelVisible: false
     property bool visualizationPanelVisible: false
     property bool framesSwapped: false
+    property bool syncStreams: true
+    // Pairing only makes sense with both streams up, otherwise the surfaces show them as received
+    readonly property bool syncActive: syncStreams && cameraViewModel.streaming && thermalCameraViewModel.thermalStreaming
+    // Decode to YUV video frames shown by a VideoOutput, the GPU converts the colors.
+    // Stream sync and the detected object crop need RGB frames and are off meanwhile.
+    property bool yuvOutput: false
 
     SerialViewModel {
         id: viewModel
@@ -46,9 +53,22 @@ ApplicationWindow {
     }
     ThermalCameraViewModel {
         id: thermalCameraViewModel
+        thermalPrimaryDisplay: root.framesSwapped
+        thermalVideoSinkOutput: root.yuvOutput
+        thermalVideoSink: root.framesSwapped ? mainVideoOutput.videoSink : secondaryVideoOutput.videoSink
     }
     CameraViewModel {
         id: cameraViewModel
+        primaryDisplay: !root.framesSwapped
+        videoSinkOutput: root.yuvOutput
+        videoSink: root.framesSwapped ? secondaryVideoOutput.videoSink : mainVideoOutput.videoSink
+    }
+    // Visible and thermal frames paired by capture time, shown while syncActive
+    StreamSyncViewModel {
+        id: streamSyncViewModel
+        enabled: root.syncActive && !root.yuvOutput
+        visibleSource: cameraViewModel.frameSource
+        thermalSource: thermalCameraViewModel.thermalFrameSource
     }
 
     // Settings {
@@ -171,16 +191,24 @@ ApplicationWindow {
 
                             // Replace the existing camera Image and MouseArea section in your QML with this:
 
-                            Image {
+                            VideoSurface {
                                 id: cameraImage
                                 anchors.centerIn: parent
                                 width: cameraContainer.displayWidth
                                 height: cameraContainer.displayHeight
-                                fillMode: Image.PreserveAspectFit
-                                source: root.framesSwapped ? thermalCameraViewModel.currentThermalFrameUrl : cameraViewModel.currentFrameUrl
-                                cache: false
+                                fillMode: VideoSurface.PreserveAspectFit
+                                source: root.framesSwapped ? (root.syncActive && !root.yuvOutput ? streamSyncViewModel.thermalFrameSource : thermalCameraViewModel.thermalFrameSource)
+                                                           : (root.syncActive && !root.yuvOutput ? streamSyncViewModel.visibleFrameSource : cameraViewModel.frameSource)
                                 smooth: true
 
+                                // Shows the stream here while yuvOutput is set, see the view models' videoSink
+                                VideoOutput {
+                                    id: mainVideoOutput
+                                    anchors.fill: parent
+                                    fillMode: VideoOutput.PreserveAspectFit
+                                    visible: root.yuvOutput
+                                }
+
                                 // Constants for source frame dimensions
                                 readonly property int sourceFrameWidth:  viewModel.frameWidth  > 0 ? viewModel.frameWidth  : 1920
                                 readonly property int sourceFrameHeight: viewModel.frameHeight > 0 ? viewModel.frameHeight : 1080
@@ -306,12 +334,15 @@ ApplicationWindow {
 
                                     property real pressX: 0
                                     property real pressY: 0
+                                    property int pressFrameId: -1
                                     property bool isDragging: false
 
                                     onPressed: {
                                         if (mouse.button === Qt.LeftButton) {
                                             pressX = mouse.x
                                             pressY = mouse.y
+                                            // The frame on screen when the operator clicked, not the newest one
+                                            pressFrameId = cameraViewModel.presentedFrameId()
                                             isDragging = false
 
                                             // Convert to source coords to validate click is on the image
@@ -382,8 +413,8 @@ ApplicationWindow {
 
                                             console.log("Final source coordinates:", sourceX, sourceY, sourceW, sourceH)
 
-                                            // Get current frame ID from camera view model
-                                            var frameId = cameraViewModel.currentFrameId
+                                            // Frame the operator was looking at when pressing
+                                            var frameId = pressFrameId >= 0 ? pressFrameId : cameraViewModel.currentFrameId
                                             var centerX = sourceX + sourceW / 2
                                             var centerY = sourceY + sourceH / 2
                                             console.log("Sending target with frame ID:", frameId)
@@ -912,16 +943,23 @@ visible: root.controlsPanelVisible || root.telemetryPanelVisible || root.testPan
 
                         property real displayHeight: displayWidth / targetAspect
 
-                        Image {
+                        VideoSurface {
                             id: thermalImage
                             anchors.centerIn: parent
                             width: thermalContainer.displayWidth
                             height: thermalContainer.displayHeight
-                            fillMode: Image.PreserveAspectFit
-                            source: root.framesSwapped ? cameraViewModel.currentFrameUrl : thermalCameraViewModel.currentThermalFrameUrl
-                            cache: false
+                            fillMode: VideoSurface.PreserveAspectFit
+                            source: root.framesSwapped ? (root.syncActive && !root.yuvOutput ? streamSyncViewModel.visibleFrameSource : cameraViewModel.frameSource)
+                                                       : (root.syncActive && !root.yuvOutput ? streamSyncViewModel.thermalFrameSource : thermalCameraViewModel.thermalFrameSource)
                             smooth: true
 
+                            VideoOutput {
+                                id: secondaryVideoOutput
+                                anchors.fill: parent
+                                fillMode: VideoOutput.PreserveAspectFit
+                                visible: root.yuvOutput
+                            }
+
                             Rectangle {
                                 anchors.fill: parent
                                 color: "transparent"
@@ -971,6 +1009,60 @@ visible: root.controlsPanelVisible || root.telemetryPanelVisible || root.testPan
                                     color: root.framesSwapped ? "#00FF00" : "#FF6B35"
                                 }
                             }
+
+                            // Toggle for pairing the two streams by capture time
+                            Rectangle {
+                                anchors.top: parent.top
+                                anchors.left: parent.left
+                                anchors.margins: 10
+                                width: 80
+                                height: 25
+                                color: Qt.rgba(0, 0, 0, 0.7)
+                                radius: 12
+                                visible: thermalCameraViewModel.thermalStreaming && cameraViewModel.streaming && !root.yuvOutput
+
+                                Text {
+                                    anchors.centerIn: parent
+                                    text: !root.syncStreams ? "UNSYNCED"
+                                                            : streamSyncViewModel.synchronized ? "SYNC " + Math.round(streamSyncViewModel.skewMs) + " ms"
+                                                                                               : "SYNC ..."
+                                    font.pixelSize: 10
+                                    font.bold: true
+                                    color: root.syncStreams && streamSyncViewModel.synchronized ? successColor : "#888888"
+                                }
+
+                                MouseArea {
+                                    anchors.fill: parent
+                                    cursorShape: Qt.PointingHandCursor
+                                    onClicked: root.syncStreams = !root.syncStreams
+                                }
+                            }
+
+                            // Toggle between the RGB surfaces and YUV video output
+                            Rectangle {
+                                anchors.top: parent.top
+                                anchors.horizontalCenter: parent.horizontalCenter
+                                anchors.margins: 10
+                                width: 60
+                                height: 25
+                                color: Qt.rgba(0, 0, 0, 0.7)
+                                radius: 12
+                                visible: thermalCameraViewModel.thermalStreaming || cameraViewModel.streaming
+
+                                Text {
+                                    anchors.centerIn: parent
+                                    text: root.yuvOutput ? "YUV" : "RGB"
+                                    font.pixelSize: 10
+                                    font.bold: true
+                                    color: root.yuvOutput ? successColor : "#888888"
+                                }
+
+                                MouseArea {
+                                    anchors.fill: parent
+                                    cursorShape: Qt.PointingHandCursor
+                                    onClicked: root.yuvOutput = !root.yuvOutput
+                                }
+                            }
                         }
 
                         BusyIndicator {
@@ -1020,10 +1112,9 @@ visible: root.controlsPanelVisible || root.telemetryPanelVisible || root.testPan
                         readonly property real centerOffsetY: (height - cropDrawH) / 2
 
                         // Full-frame image, scaled then offset so only the crop shows inside the clipped Item
-                        Image {
+                        VideoSurface {
                             id: detectedImage
-                            source: cameraViewModel.currentFrameUrl
-                            cache: false
+                            source: cameraViewModel.frameSource
                             smooth: true
                             visible: (cx >= 0 && cy >= 0 && cropW > 1 && cropH > 1)
 
@@ -1035,7 +1126,7 @@ visible: root.controlsPanelVisible || root.telemetryPanelVisible || root.testPan
                             x: detectedObjectView.centerOffsetX - detectedObjectView.cropLeft * detectedObjectView.scale
                             y: detectedObjectView.centerOffsetY - detectedObjectView.cropTop  * detectedObjectView.scale
 
-                            fillMode: Image.Stretch  // we control sizing/positioning explicitly
+                            fillMode: VideoSurface.Stretch  // we control sizing/positioning explicitly
 
                             // nice border around the viewport
                             Rectangle {
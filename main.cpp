@@ -5,8 +5,10 @@
 #include "viewmodels/mediamanagerviewmodel.h"
 #include "viewmodels/mapviewmodel.h"
 #include "viewmodels/thermalcameraviewmodel.h"
+#include "viewmodels/streamsyncviewmodel.h"
 #include "models/joystickreceiver.h"
 #include "models/serialworker.h"
+#include "view/videosurface.h"
 int main(int argc, char *argv[])
 {
     QGuiApplication app(argc, argv);
@@ -26,14 +28,14 @@ int main(int argc, char *argv[])
     qmlRegisterType<MediaManagerViewModel>("SerialApp", 1, 0, "MediaManagerViewModel");
     qmlRegisterType<MapViewModel>("SerialApp", 1, 0, "MapViewModel");
     qmlRegisterType<ThermalCameraViewModel>("SerialApp", 1, 0, "ThermalCameraViewModel");
+    qmlRegisterType<StreamSyncViewModel>("SerialApp", 1, 0, "StreamSyncViewModel");
     qmlRegisterType<JoystickReceiver>("SerialApp", 1, 0, "JoystickReceiver");
+    qmlRegisterType<VideoSurface>("SerialApp", 1, 0, "VideoSurface");
+    qmlRegisterUncreatableType<VideoFrameSource>("SerialApp", 1, 0, "VideoFrameSource",
+                                                 "VideoFrameSource is provided by the camera view models");
 
     QQmlApplicationEngine engine;
 
-    // Register image providers
-    engine.addImageProvider("camera", new CameraImageProvider());
-    engine.addImageProvider("thermal", new ThermalImageProvider());
-
     QObject::connect(
         &engine,
         &QQmlApplicationEngine::objectCreationFailed,
@@ -2,6 +2,7 @@
 #include <QDebug>
 #include <QNetworkDatagram>
 #include<QtEndian>
+#include "partialjpeg.h"
 // JPEG markers
 const QByteArray CameraModel::JPEG_START_MARKER = QByteArray::fromHex("FFD8");
 const QByteArray CameraModel::JPEG_END_MARKER = QByteArray::fromHex("FFD9");
@@ -9,10 +10,21 @@ const QByteArray CameraModel::JPEG_END_MARKER = QByteArray::fromHex("FFD9");
 CameraModel::CameraModel(QObject *parent)
     : QObject(parent)
     , m_udpSocket(nullptr)
+    , m_batchReceiver(nullptr)
+    , m_reactorIngest(IngestReactor::isSupported())
+    , m_reactorStream(-1)
+    , m_replay(nullptr)
+    , m_batchedIngest(UdpBatchReceiver::isSupported())
     , m_processTimer(new QTimer(this))
+    , m_nackSocket(nullptr)
     , m_streaming(false)
     , m_fragmentTimeout(5000)
 // 5 second timeout for incomplete frames
+    , m_reassembler(m_fragmentTimeout)
+    , m_frameMailbox(nullptr)
+    , m_linkStatistics(nullptr)
+    , m_recorder(nullptr)
+    , m_progressiveDisplay(false)
 {
     // Timer to process buffer periodically
     m_processTimer->setInterval(16);
@@ -22,6 +34,18 @@ CameraModel::CameraModel(QObject *parent)
     m_cleanupTimer = new QTimer(this);
     m_cleanupTimer->setInterval(1000); // Check every second
     connect(m_cleanupTimer, &QTimer::timeout, this, &CameraModel::cleanupIncompleteFrames);
+
+    // Timer to request retransmission of missing fragments, only runs with NACKs enabled
+    m_nackTimer = new QTimer(this);
+    m_nackTimer->setInterval(5);
+    m_nackTimer->setTimerType(Qt::PreciseTimer);
+    connect(m_nackTimer, &QTimer::timeout, this, &CameraModel::sendNacks);
+
+    // Single shot timer armed for the next frame held by the jitter buffer
+    m_playoutTimer = new QTimer(this);
+    m_playoutTimer->setSingleShot(true);
+    m_playoutTimer->setTimerType(Qt::PreciseTimer);
+    connect(m_playoutTimer, &QTimer::timeout, this, &CameraModel::releaseDueFrames);
 }
 
 CameraModel::~CameraModel()
@@ -38,20 +62,67 @@ void CameraModel::startStreaming(const QString &ipAddress, int port)
     m_settings.ipAddress = ipAddress;
     m_settings.port = port;
 
-    // Create UDP socket
-    m_udpSocket = new QUdpSocket(this);
+    bool bound = false;
+
+    // The shared reactor serves every stream from one epoll thread, datagrams are handled
+    // on that thread; otherwise this model's thread receives with its own backend
+    if (m_reactorIngest && IngestReactor::isSupported()) {
+        QString error;
+        m_reactorStream = IngestReactor::instance()->addStream(quint16(port), m_multicastGroup, [this](const char *data, qsizetype size) {
+            ingestDatagram(data, size);
+        }, &error);
+        bound = m_reactorStream >= 0;
+        if (!bound) {
+            qDebug() << "Ingest reactor unavailable, falling back to a per stream receiver:" << error;
+        }
+    }
 
-    // Connect signals
-    connect(m_udpSocket, &QUdpSocket::readyRead, this, &CameraModel::readPendingDatagrams);
-    connect(m_udpSocket, QOverload<QAbstractSocket::SocketError>::of(&QUdpSocket::errorOccurred),
-            this, &CameraModel::onSocketError);
+    // Prefer the batched receive backend, fall back to QUdpSocket when it is unavailable
+    if (!bound && m_batchedIngest && UdpBatchReceiver::isSupported()) {
+        m_batchReceiver = new UdpBatchReceiver(this);
+        m_batchReceiver->setDatagramHandler([this](const char *data, qsizetype size) {
+            ingestDatagram(data, size);
+        });
+        connect(m_batchReceiver, &UdpBatchReceiver::errorOccurred, this, [this](const QString &error) {
+            emit errorOccurred("UDP Socket Error: " + error);
+        });
+
+        bound = m_batchReceiver->bind(quint16(port), m_multicastGroup);
+        if (!bound) {
+            qDebug() << "Batched receive unavailable, falling back to QUdpSocket:" << m_batchReceiver->errorString();
+            delete m_batchReceiver;
+            m_batchReceiver = nullptr;
+        }
+    }
 
-    // Bind to the specified port
-    if (m_udpSocket->bind(QHostAddress::AnyIPv4, port))
+    if (!bound) {
+        // Create UDP socket
+        m_udpSocket = new QUdpSocket(this);
+
+        // Connect signals
+        connect(m_udpSocket, &QUdpSocket::readyRead, this, &CameraModel::readPendingDatagrams);
+        connect(m_udpSocket, QOverload<QAbstractSocket::SocketError>::of(&QUdpSocket::errorOccurred),
+                this, &CameraModel::onSocketError);
+
+        // Bind to the specified port, shared with the other members of a multicast group
+        if (m_multicastGroup.isNull()) {
+            bound = m_udpSocket->bind(QHostAddress::AnyIPv4, port);
+        } else {
+            bound = m_udpSocket->bind(QHostAddress::AnyIPv4, port,
+                                      QUdpSocket::ShareAddress | QUdpSocket::ReuseAddressHint)
+                    && m_udpSocket->joinMulticastGroup(m_multicastGroup);
+        }
+    }
+
+    if (bound)
 
     {   m_streaming = true;
         m_processTimer->start();
         m_cleanupTimer->start();
+        if (m_reassembler.nackPolicy().enabled) {
+            m_nackSocket = new QUdpSocket(this);
+            m_nackTimer->start();
+        }
         emit streamingStatusChanged(true);
         emit connectionEstablished();
         qDebug() << "Started UDP streaming on port:" << port;
@@ -72,6 +143,31 @@ void CameraModel::stopStreaming()
 
     m_processTimer->stop();
     m_cleanupTimer->stop();
+    m_nackTimer->stop();
+    m_playoutTimer->stop();
+
+    if (m_nackSocket) {
+        m_nackSocket->close();
+        m_nackSocket->deleteLater();
+        m_nackSocket = nullptr;
+    }
+
+    if (m_reactorStream >= 0) {
+        IngestReactor::instance()->removeStream(m_reactorStream);
+        m_reactorStream = -1;
+    }
+
+    if (m_batchReceiver) {
+        m_batchReceiver->close();
+        m_batchReceiver->deleteLater();
+        m_batchReceiver = nullptr;
+    }
+
+    if (m_replay) {
+        m_replay->stop();
+        m_replay->deleteLater();
+        m_replay = nullptr;
+    }
 
     if (m_udpSocket) {
         m_udpSocket->close();
@@ -81,6 +177,10 @@ void CameraModel::stopStreaming()
 
     clearBuffer();
     clearIncompleteFrames();
+    if (m_linkStatistics) {
+        m_linkStatistics->resetSequence();
+    }
+    m_jitterBuffer.clear();
     m_streaming = false;
     emit streamingStatusChanged(false);
     qDebug() << "Stopped UDP streaming";
@@ -91,6 +191,118 @@ bool CameraModel::isStreaming() const
     return m_streaming;
 }
 
+void CameraModel::setBatchedIngest(bool enabled)
+{
+    // Takes effect the next time streaming starts
+    m_batchedIngest = enabled;
+}
+
+void CameraModel::setReactorIngest(bool enabled)
+{
+    // Takes effect the next time streaming starts
+    m_reactorIngest = enabled;
+}
+
+void CameraModel::setMulticastGroup(const QString &group)
+{
+    // Takes effect the next time streaming starts
+    const QHostAddress address(group.trimmed());
+    if (!group.trimmed().isEmpty() && !address.isMulticast()) {
+        emit errorOccurred(group + " is not a multicast group, receiving unicast");
+        m_multicastGroup.clear();
+        return;
+    }
+    m_multicastGroup = address;
+}
+
+void CameraModel::setRelayDestinations(const QStringList &destinations)
+{
+    QList<UdpRelay::Destination> parsed;
+    QString error;
+    if (!UdpRelay::parseDestinations(destinations, &parsed, &error) || !m_relay.setDestinations(parsed, &error)) {
+        emit errorOccurred("Relay: " + error);
+        m_relay.setDestinations({});
+    }
+}
+
+void CameraModel::setRelayOnly(bool enabled)
+{
+    m_relayOnly.store(enabled, std::memory_order_relaxed);
+}
+
+void CameraModel::setFrameExport(const QString &name)
+{
+    if (name.isEmpty()) {
+        m_frameExport.close();
+    } else if (!m_frameExport.open(name, FrameExportSlots, FrameExportSlotCapacity)) {
+        emit errorOccurred("Cannot export frames to shared memory " + name + ": " + m_frameExport.errorString());
+    }
+}
+
+void CameraModel::setProgressiveDisplay(bool enabled)
+{
+    QMutexLocker locker(&m_bufferMutex);
+    m_progressiveDisplay = enabled;
+}
+
+void CameraModel::postPartialFrame()
+{
+    // A frame waiting for playout must not be overtaken by the top of the next one
+    if (m_jitterBuffer.occupancy() > 0 || !m_frameMailbox) {
+        return;
+    }
+
+    FrameReassembler<>::Frame prefix;
+    if (!m_reassembler.takePrefix(PartialFrameSteps, &prefix)) {
+        return;
+    }
+
+    LatestFrameMailbox::Frame partial;
+    if (!PartialJpeg::truncateAtRestart(prefix.data, &partial.data, &partial.partialRows, &partial.partialHeight)) {
+        return;     // no restart interval, or no marker received yet
+    }
+    partial.frameId = prefix.frameId;
+
+    // Left out of the latency statistics, they describe complete frames
+    if (m_frameMailbox->post(std::move(partial))) {
+        emit framePending();
+    }
+}
+
+void CameraModel::setNackEnabled(bool enabled)
+{
+    QMutexLocker locker(&m_bufferMutex);
+    FrameReassembler<>::NackPolicy policy = m_reassembler.nackPolicy();
+    policy.enabled = enabled;
+    m_reassembler.setNackPolicy(policy);
+    locker.unlock();
+
+    if (!m_streaming) {
+        return;
+    }
+    if (enabled && !m_nackSocket) {
+        m_nackSocket = new QUdpSocket(this);
+        m_nackTimer->start();
+    } else if (!enabled && m_nackSocket) {
+        m_nackTimer->stop();
+        m_nackSocket->close();
+        m_nackSocket->deleteLater();
+        m_nackSocket = nullptr;
+    }
+}
+
+void CameraModel::setJitterBufferMode(int mode)
+{
+    QMutexLocker locker(&m_bufferMutex);
+    m_jitterBuffer.setMode(JitterBuffer::Mode(qBound(0, mode, int(JitterBuffer::Mode::Smooth))));
+}
+
+void CameraModel::setJitterBufferMaxDelay(int maxDelayMs)
+{
+    QMutexLocker locker(&m_bufferMutex);
+    m_jitterBuffer.setMaxDelay(maxDelayMs);
+}
+
 void CameraModel::readPendingDatagrams()
 {
     while (m_udpSocket && m_udpSocket->hasPendingDatagrams()) {
@@ -98,87 +310,204 @@ void CameraModel::readPendingDatagrams()
         QByteArray data = datagram.data();
 
         if (!data.isEmpty()) {
-            processFragmentedPacket(data);
+            ingestDatagram(data.constData(), data.size());
         }
     }
 }
 
-void CameraModel::processFragmentedPacket(const QByteArray &packet)
+void CameraModel::ingestDatagram(const char *packet, qsizetype size)
 {
-    // Check if packet has header (minimum 16 bytes for header)
-    // Check if packet has header (minimum 14 bytes for header)
-    if (packet.size() < 14) {
-        qDebug() << "Packet too small for header:" << packet.size();
+    // Downstream stations get the datagram before this station spends time on it
+    m_relay.forward(packet, size);
+
+    if (m_capturing.load(std::memory_order_relaxed) && size > 0) {
+        QMutexLocker locker(&m_captureMutex);
+        if (m_capture.isOpen() && !m_capture.write(packet, size, FrameTiming::now())) {
+            emit errorOccurred("Capture failed: " + m_capture.errorString());
+            m_capture.close();
+            m_capturing.store(false, std::memory_order_relaxed);
+            emit captureStatusChanged(false, QString());
+        }
+    }
+    if (!m_relayOnly.load(std::memory_order_relaxed)) {
+        processFragmentedPacket(packet, size);
+    }
+}
+
+void CameraModel::startCapture(const QString &filePath)
+{
+    stopCapture();
+
+    QMutexLocker locker(&m_captureMutex);
+    if (!m_capture.open(filePath)) {
+        emit errorOccurred("Cannot create capture " + filePath + ": " + m_capture.errorString());
+        return;
+    }
+    m_capturing.store(true, std::memory_order_relaxed);
+    qDebug() << "Capturing datagrams to:" << filePath;
+    emit captureStatusChanged(true, filePath);
+}
+
+void CameraModel::stopCapture()
+{
+    QMutexLocker locker(&m_captureMutex);
+    if (!m_capture.isOpen()) {
         return;
     }
+    m_capturing.store(false, std::memory_order_relaxed);
+    const quint64 datagrams = m_capture.datagrams();
+    m_capture.close();
+    qDebug() << "Capture closed, datagrams:" << datagrams;
+    emit captureStatusChanged(false, QString());
+}
 
-    // Parse header: frame_id(2) + total_fragments(4) + fragment_index(4) + fragment_size(4)
-    const char* data = packet.constData();
-    quint16 frameId = qFromBigEndian<quint16>(reinterpret_cast<const uchar*>(data));
-    quint32 totalFragments = qFromBigEndian<quint32>(reinterpret_cast<const uchar*>(data + 2));
-    quint32 fragmentIndex = qFromBigEndian<quint32>(reinterpret_cast<const uchar*>(data + 6));
-    quint32 fragmentSize = qFromBigEndian<quint32>(reinterpret_cast<const uchar*>(data + 10));
+void CameraModel::startReplay(const QString &filePath, bool realTime)
+{
+    if (m_streaming) {
+        stopStreaming();
+    }
 
-    // Validate header
-    if (fragmentIndex >= totalFragments || fragmentSize != (packet.size() - 14)) {
-        qDebug() << "Invalid fragment " << fragmentIndex
-                 << "Total:" << totalFragments << "Size:" << fragmentSize
-                 << "Actual:" << (packet.size() - 16);
+    // The replay takes the place of the socket, frames go through the normal ingest path
+    m_replay = new UdpCaptureReplay(this);
+    m_replay->setDatagramHandler([this](const char *data, qsizetype size) {
+        processFragmentedPacket(data, size);
+    });
+    connect(m_replay, &UdpCaptureReplay::finished, this, [this](quint64 datagrams) {
+        qDebug() << "Replay finished, datagrams:" << datagrams;
+        emit replayFinished(datagrams);
+        stopStreaming();
+    });
+
+    const UdpCaptureReplay::Pacing pacing = realTime ? UdpCaptureReplay::Pacing::RealTime
+                                                     : UdpCaptureReplay::Pacing::AsFastAsPossible;
+    if (!m_replay->start(filePath, pacing)) {
+        emit errorOccurred("Cannot replay " + filePath + ": " + m_replay->errorString());
+        delete m_replay;
+        m_replay = nullptr;
         return;
     }
 
-    // Extract fragment data
-    QByteArray fragmentData = packet.mid(14);
+    m_streaming = true;
+    m_processTimer->start();
+    m_cleanupTimer->start();
+    emit streamingStatusChanged(true);
+    qDebug() << "Replaying" << filePath << (realTime ? "at the original timing" : "as fast as possible");
+}
 
+void CameraModel::processFragmentedPacket(const char *packet, qsizetype size)
+{
+    // Taken first: with the ingest reactor this runs on the reactor's thread, and the
+    // link statistics are also written by cleanupIncompleteFrames() on this model's thread
     QMutexLocker locker(&m_bufferMutex);
 
-    // Initialize frame reassembly if this is the first fragment
-    if (!m_incompleteFrames.contains(frameId)) {
-        FrameAssembly assembly;
-        assembly.totalFragments = totalFragments;
-        assembly.receivedFragments = 0;
-        assembly.fragments.resize(totalFragments);
-        assembly.timestamp = QDateTime::currentMSecsSinceEpoch();
-        m_incompleteFrames[frameId] = assembly;
+    if (m_linkStatistics) {
+        m_linkStatistics->recordDatagram(size);
+    }
+
+    // Check if packet has header (minimum 14 bytes for header)
+    if (size < FragmentHeader::Size) {
+        if (m_linkStatistics) {
+            m_linkStatistics->recordMalformed();
+        }
+        qDebug() << "Packet too small for header:" << size;
+        return;
+    }
 
-        qDebug() << "Started reassembly for frame" << frameId << "with" << totalFragments << "fragments";
+    const qint64 arrivalTime = QDateTime::currentMSecsSinceEpoch();
+    FrameReassembler<>::Frame frame;
+    const FrameReassembler<>::Result result = m_reassembler.addFragment(packet, size, arrivalTime, &frame);
+    if (m_linkStatistics) {
+        if (result == FrameReassembler<>::Result::Malformed) {
+            m_linkStatistics->recordMalformed();
+        } else {
+            m_linkStatistics->recordFragment(m_reassembler.lastHeader(), arrivalTime);
+            if (result == FrameReassembler<>::Result::Duplicate) {
+                m_linkStatistics->recordDuplicate();
+            } else if (result == FrameReassembler<>::Result::Stale) {
+                m_linkStatistics->recordLate();
+            } else if (result == FrameReassembler<>::Result::Complete) {
+                m_linkStatistics->recordCompleted();
+            }
+        }
     }
 
-    FrameAssembly& assembly = m_incompleteFrames[frameId];
+    switch (result) {
+    case FrameReassembler<>::Result::Malformed: {
+        const FragmentHeader &header = m_reassembler.lastHeader();
+        qDebug() << "Invalid fragment " << header.fragmentIndex
+                 << "Total:" << header.totalFragments << "Size:" << header.fragmentSize
+                 << "Actual:" << (size - FragmentHeader::Size);
+        return;
+    }
+    case FrameReassembler<>::Result::Duplicate:
+        qDebug() << "Duplicate fragment" << m_reassembler.lastHeader().fragmentIndex
+                 << "for frame" << m_reassembler.lastHeader().frameId;
+        return;
+    case FrameReassembler<>::Result::Stale:
+        return;
+    case FrameReassembler<>::Result::Incomplete:
+        if (m_progressiveDisplay) {
+            postPartialFrame();
+        }
+        return;
+    case FrameReassembler<>::Result::Complete:
+        break;
+    }
+    const qint64 lastFragmentTime = FrameTiming::now();
 
-    // Check if we already have this fragment
-    if (!assembly.fragments[fragmentIndex].isEmpty()) {
-        qDebug() << "Duplicate fragment" << fragmentIndex << "for frame" << frameId;
+    // Validate the complete frame and hand it to the jitter buffer
+    if (!isValidJpegFrame(frame.data)) {
+        qDebug() << "Invalid complete frame for frame ID:" << frame.frameId;
         return;
     }
 
-    // Store the fragment
-    assembly.fragments[fragmentIndex] = fragmentData;
-    assembly.receivedFragments++;
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
+    JitterBuffer::Frame playoutFrame;
+    playoutFrame.timing.capture = FrameTiming::captureTimestamp(frame.data);
+    playoutFrame.timing.firstFragment = frame.firstFragmentTime * 1000;    // reassembler clock is in ms
+    playoutFrame.timing.lastFragment = lastFragmentTime;
+    if (m_recorder) {
+        // Recorded before playout so late drops do not leave holes in the file
+        m_recorder->addFrame(frame.data, playoutFrame.timing.capture ? playoutFrame.timing.capture : lastFragmentTime);
+    }
+    // Analytics get the frame without waiting for the jitter buffer's playout time
+    m_frameExport.publishJpeg(frame.data, frame.frameId, playoutFrame.timing);
+    playoutFrame.data = std::move(frame.data);
+    playoutFrame.frameId = frame.frameId;
+    playoutFrame.arrivalTime = now;
+    if (!m_jitterBuffer.push(std::move(playoutFrame), now)) {
+        return;     // late, counted in the jitter buffer's lateDrops
+    }
 
-    qDebug() << "Received fragment" << fragmentIndex << "/" << totalFragments
-             << "for frame" << frameId << "(" << assembly.receivedFragments << "/" << totalFragments << ")";
+    locker.unlock();
+    releaseDueFrames();
+}
 
-    // Check if frame is complete
-    if (assembly.receivedFragments == assembly.totalFragments) {
-        // Reassemble the complete frame
-        QByteArray completeFrame;
-        for (const QByteArray& fragment : assembly.fragments) {
-            completeFrame.append(fragment);
-        }
+void CameraModel::releaseDueFrames()
+{
+    QMutexLocker locker(&m_bufferMutex);
 
-        qDebug() << "Frame" << frameId << "complete, total size:" << completeFrame.size();
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
+    JitterBuffer::Frame frame;
+    while (m_jitterBuffer.pop(now, &frame)) {
+        // Only the newest frame is kept if the GUI thread falls behind
+        frame.timing.reassembled = FrameTiming::now();
+        m_reassembler.markDelivered(frame.frameId);     // older frames can no longer be shown
+        if (m_frameMailbox && m_frameMailbox->post(frame.data, frame.frameId, frame.timing)) {
+            emit framePending();
+        }
+    }
 
-        // Validate and emit the complete frame
-        if (isValidJpegFrame(completeFrame)) {
-            emit frameReceived(completeFrame, frameId);  // Pass frame ID
-            qDebug() << "Valid complete frame emitted for frame ID:" << frameId;
+    const qint64 nextDue = m_jitterBuffer.nextDueIn(now);
+    if (nextDue >= 0) {
+        if (QThread::currentThread() == thread()) {
+            m_playoutTimer->start(int(nextDue));
         } else {
-            qDebug() << "Invalid complete frame for frame ID:" << frameId;
+            // Called from the ingest reactor's thread, the timer belongs to this one
+            QMetaObject::invokeMethod(m_playoutTimer, [this, nextDue] {
+                m_playoutTimer->start(int(nextDue));
+            }, Qt::QueuedConnection);
         }
-
-        // Remove completed frame from incomplete frames
-        m_incompleteFrames.remove(frameId);
     }
 }
 
@@ -186,18 +515,41 @@ void CameraModel::cleanupIncompleteFrames()
 {
     QMutexLocker locker(&m_bufferMutex);
 
-    qint64 currentTime = QDateTime::currentMSecsSinceEpoch();
-    QList<quint16> framesToRemove;
+    const QList<quint16> expired = m_reassembler.expireFrames(QDateTime::currentMSecsSinceEpoch());
+    for (quint16 frameId : expired) {
+        qDebug() << "Removing incomplete frame" << frameId << "due to timeout";
+    }
+    if (m_linkStatistics && !expired.isEmpty()) {
+        m_linkStatistics->recordExpired(int(expired.size()));
+    }
+
+    emit fecStatisticsChanged(m_reassembler.recoveredFrames(), m_reassembler.unrecoverableFrames());
+    emit reassemblyStatisticsChanged(m_reassembler.bytesInUse(), m_reassembler.peakBytes(),
+                                     m_reassembler.evictedFrames());
+    emit relayStatisticsChanged(m_relay.forwardedDatagrams(), m_relay.droppedDatagrams());
+    emit frameExportStatisticsChanged(m_frameExport.publishedFrames(), m_frameExport.oversizedFrames());
+    emit nackStatisticsChanged(m_reassembler.nackRequests(), m_reassembler.nackedFragments());
+    emit jitterStatisticsChanged(m_jitterBuffer.occupancy(), m_jitterBuffer.lateDrops(),
+                                 int(m_jitterBuffer.targetDelay()));
+}
 
-    for (auto it = m_incompleteFrames.begin(); it != m_incompleteFrames.end(); ++it) {
-        if (currentTime - it.value().timestamp > m_fragmentTimeout) {
-            framesToRemove.append(it.key());
-        }
+void CameraModel::sendNacks()
+{
+    if (!m_nackSocket) {
+        return;
     }
 
-    for (quint16  frameId : framesToRemove) {
-        qDebug() << "Removing incomplete frame" << frameId << "due to timeout";
-        m_incompleteFrames.remove(frameId);
+    QList<NackPacket> requests;
+    {
+        QMutexLocker locker(&m_bufferMutex);
+        m_reassembler.collectNacks(QDateTime::currentMSecsSinceEpoch(), &requests);
+    }
+
+    // NACKs share the control channel with the tracking commands
+    const QHostAddress cameraAddress(m_settings.ipAddress);
+    const quint16 ctrlPort = quint16(m_settings.port + 100);
+    for (const NackPacket &nack : requests) {
+        m_nackSocket->writeDatagram(nack.encode(), cameraAddress, ctrlPort);
     }
 }
 
@@ -248,7 +600,7 @@ void CameraModel::clearBuffer()
 void CameraModel::clearIncompleteFrames()
 {
     QMutexLocker locker(&m_bufferMutex);
-    m_incompleteFrames.clear();
+    m_reassembler.clear();
     qDebug() << "Incomplete frames cleared";
 }
 
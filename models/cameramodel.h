@@ -11,6 +11,17 @@
 #include <QDateTime>
 #include <QMap>
 #include <QVector>
+#include <atomic>
+#include "framereassembler.h"
+#include "udpbatchreceiver.h"
+#include "ingestreactor.h"
+#include "jitterbuffer.h"
+#include "latestframemailbox.h"
+#include "linkstatistics.h"
+#include "streamrecorder.h"
+#include "udpcapture.h"
+#include "udprelay.h"
+#include "sharedframering.h"
 
 class CameraModel : public QObject
 {
@@ -20,55 +31,129 @@ public:
     explicit CameraModel(QObject *parent = nullptr);
     ~CameraModel();
 
+    // Frames are handed to the view model through this mailbox, set before the model
+    // is moved to its thread
+    void setFrameMailbox(LatestFrameMailbox *mailbox) { m_frameMailbox = mailbox; }
+
+    // Link quality counters; set before the move as well. Written from the ingest thread
+    // (the IngestReactor shard when reactorIngest is on, this model's thread otherwise)
+    // and from this model's cleanup timer, under m_bufferMutex or after ingest stopped,
+    // so there is only ever one writer at a time.
+    void setLinkStatistics(LinkStatistics *statistics) { m_linkStatistics = statistics; }
+
+    // Receives every complete, valid frame as it arrived; owned by the view model
+    void setStreamRecorder(StreamRecorder *recorder) { m_recorder = recorder; }
+
     struct CameraSettings {
         QString ipAddress;
         int port;
     };
 
-    // Structure for frame reassembly
-    struct FrameAssembly {
-        quint32 totalFragments;
-        quint32 receivedFragments;
-        QVector<QByteArray> fragments;
-        qint64 timestamp;
-    };
-
 public slots:
     void startStreaming(const QString &ipAddress, int port);
     void stopStreaming();
     bool isStreaming() const;
+    void setBatchedIngest(bool enabled);
+    void setReactorIngest(bool enabled);
+
+    // Multicast group to join instead of unicast reception, empty for unicast; applies
+    // the next time streaming starts
+    void setMulticastGroup(const QString &group);
+
+    // Forward every received datagram unmodified to these "host:port" stations, and
+    // optionally skip local reassembly and decoding altogether
+    void setRelayDestinations(const QStringList &destinations);
+    void setRelayOnly(bool enabled);
+
+    // Export every complete frame as received to the shared memory ring /name for local
+    // analytics processes, an empty name stops exporting
+    void setFrameExport(const QString &name);
+
+    // Raw datagram capture of the live stream, and replay of a capture in place of the
+    // socket (realTime keeps the original spacing, otherwise as fast as possible)
+    void startCapture(const QString &filePath);
+    void stopCapture();
+    void startReplay(const QString &filePath, bool realTime);
+    void setNackEnabled(bool enabled);
+    void setJitterBufferMode(int mode);
+    void setJitterBufferMaxDelay(int maxDelayMs);
+
+    // Post the received top rows of frames still in flight, cut at a JPEG restart marker
+    void setProgressiveDisplay(bool enabled);
 
 private slots:
     void readPendingDatagrams();
     void onSocketError();
     void processBuffer();
     void cleanupIncompleteFrames();
+    void sendNacks();
+    void releaseDueFrames();
 
 signals:
     void streamingStatusChanged(bool streaming);
-    void frameReceived(const QByteArray &frameData, quint16 frameId);  // Added frameId parameter
+    void framePending();    // the frame mailbox went from empty to full
     void errorOccurred(const QString &error);
+    void captureStatusChanged(bool capturing, const QString &filePath);
+    void replayFinished(quint64 datagrams);
     void connectionEstablished();
+    void fecStatisticsChanged(quint64 recoveredFrames, quint64 unrecoverableFrames);
+    void reassemblyStatisticsChanged(qint64 bytesInUse, qint64 peakBytes, quint64 evictedFrames);
+    void relayStatisticsChanged(quint64 forwardedDatagrams, quint64 droppedDatagrams);
+    void frameExportStatisticsChanged(quint64 exportedFrames, quint64 oversizedFrames);
+    void nackStatisticsChanged(quint64 requests, quint64 fragments);
+    void jitterStatisticsChanged(int occupancy, quint64 lateDrops, int targetDelayMs);
 
 private:
     QUdpSocket *m_udpSocket;
+    UdpBatchReceiver *m_batchReceiver;
+    bool m_reactorIngest;
+    int m_reactorStream;            // IngestReactor stream id, -1 when not used
+    UdpCaptureReplay *m_replay;     // stands in for the socket while replaying
+    UdpCaptureWriter m_capture;
+    QMutex m_captureMutex;          // the reactor writes captures from its own thread
+    std::atomic<bool> m_capturing{false};
+    QHostAddress m_multicastGroup;  // null for unicast
+    UdpRelay m_relay;               // fed from the ingest thread
+    std::atomic<bool> m_relayOnly{false};
+
+    // Shared memory export, written from the ingest thread
+    static constexpr int FrameExportSlots = 16;
+    static constexpr qsizetype FrameExportSlotCapacity = 2 * 1024 * 1024;
+    SharedFrameRing m_frameExport;
+
+    bool m_batchedIngest;
     QByteArray m_frameBuffer;
     QTimer *m_processTimer;
     QTimer *m_cleanupTimer;
+    QTimer *m_nackTimer;
+    QUdpSocket *m_nackSocket;   // sends NACKs to the camera control port (port + 100)
     bool m_streaming;
     CameraSettings m_settings;
     QMutex m_bufferMutex;
 
     // Fragment reassembly
-    QMap<quint16, FrameAssembly> m_incompleteFrames;
     qint64 m_fragmentTimeout;
+    FrameReassembler<> m_reassembler;
+
+    // Playout between reassembly and the view model
+    JitterBuffer m_jitterBuffer;
+    QTimer *m_playoutTimer;
+    LatestFrameMailbox *m_frameMailbox;
+    LinkStatistics *m_linkStatistics;
+    StreamRecorder *m_recorder;
+
+    // Progressive display, a frame is posted in at most this many parts before it completes
+    static constexpr int PartialFrameSteps = 4;
+    bool m_progressiveDisplay;
 
     // MJPEG parsing constants
     static const QByteArray JPEG_START_MARKER;
     static const QByteArray JPEG_END_MARKER;
 
     // Helper methods
-    void processFragmentedPacket(const QByteArray &packet);
+    void ingestDatagram(const char *packet, qsizetype size);
+    void processFragmentedPacket(const char *packet, qsizetype size);
+    void postPartialFrame();
     void extractFramesFromBuffer();
     bool isValidJpegFrame(const QByteArray &data);
     void clearBuffer();
@@ -0,0 +1,174 @@
+#include "decoderpool.h"
+#include "framedecoder.h"
+#include <QDebug>
+
+DecoderPool *DecoderPool::instance()
+{
+    static DecoderPool pool(defaultWorkerCount());
+    return &pool;
+}
+
+int DecoderPool::defaultWorkerCount()
+{
+    return qMax(1, QThread::idealThreadCount() - 2);
+}
+
+DecoderPool::DecoderPool(int workerCount)
+    : m_secondaryIntervalMs(100)
+    , m_stopping(false)
+{
+    m_clock.start();
+
+    for (int i = 0; i < qMax(1, workerCount); ++i) {
+        QThread *worker = QThread::create([this] { run(); });
+        worker->setObjectName(QString("DecoderPool worker %1").arg(i));
+        m_workers.append(worker);
+        worker->start();
+    }
+    qDebug() << "Decoder pool started with" << m_workers.size() << "workers";
+}
+
+DecoderPool::~DecoderPool()
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        m_stopping = true;
+        m_wake.wakeAll();
+    }
+    for (QThread *worker : std::as_const(m_workers)) {
+        worker->wait();
+        delete worker;
+    }
+}
+
+void DecoderPool::setSecondaryInterval(int intervalMs)
+{
+    QMutexLocker locker(&m_mutex);
+    m_secondaryIntervalMs = qMax(0, intervalMs);
+    m_wake.wakeAll();
+}
+
+int DecoderPool::secondaryInterval() const
+{
+    QMutexLocker locker(&m_mutex);
+    return int(m_secondaryIntervalMs);
+}
+
+void DecoderPool::addDecoder(FrameDecoder *decoder)
+{
+    QMutexLocker locker(&m_mutex);
+    if (indexOf(decoder) < 0) {
+        Job job;
+        job.decoder = decoder;
+        m_jobs.append(job);
+    }
+}
+
+void DecoderPool::removeDecoder(FrameDecoder *decoder)
+{
+    QMutexLocker locker(&m_mutex);
+    int index = indexOf(decoder);
+    while (index >= 0 && m_jobs.at(index).running) {
+        m_finished.wait(&m_mutex);
+        index = indexOf(decoder);
+    }
+    if (index >= 0) {
+        m_jobs.removeAt(index);
+    }
+}
+
+void DecoderPool::setPriority(FrameDecoder *decoder, Priority priority)
+{
+    QMutexLocker locker(&m_mutex);
+    const int index = indexOf(decoder);
+    if (index >= 0 && m_jobs.at(index).priority != priority) {
+        Job &job = m_jobs[index];
+        job.priority = priority;
+        job.notBefore = 0;
+        m_wake.wakeAll();
+    }
+}
+
+void DecoderPool::schedule(FrameDecoder *decoder)
+{
+    QMutexLocker locker(&m_mutex);
+    const int index = indexOf(decoder);
+    if (index < 0) {
+        return;
+    }
+
+    Job &job = m_jobs[index];
+    if (!job.pending) {
+        job.pending = true;
+        job.scheduledAt = m_clock.elapsed();
+    }
+    // A running job is picked up again by its worker when it returns
+    if (!job.running) {
+        m_wake.wakeOne();
+    }
+}
+
+int DecoderPool::indexOf(FrameDecoder *decoder) const
+{
+    for (int i = 0; i < m_jobs.size(); ++i) {
+        if (m_jobs.at(i).decoder == decoder) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+void DecoderPool::run()
+{
+    QMutexLocker locker(&m_mutex);
+    while (!m_stopping) {
+        const qint64 now = m_clock.elapsed();
+
+        // Highest priority ready job, oldest first within a priority
+        int next = -1;
+        qint64 wait = -1;
+        for (int i = 0; i < m_jobs.size(); ++i) {
+            const Job &job = m_jobs.at(i);
+            if (!job.pending || job.running) {
+                continue;
+            }
+            if (job.notBefore > now) {
+                const qint64 due = job.notBefore - now;
+                wait = wait < 0 ? due : qMin(wait, due);
+                continue;
+            }
+            if (next < 0 || job.priority < m_jobs.at(next).priority
+                || (job.priority == m_jobs.at(next).priority && job.scheduledAt < m_jobs.at(next).scheduledAt)) {
+                next = i;
+            }
+        }
+
+        if (next < 0) {
+            if (wait < 0) {
+                m_wake.wait(&m_mutex);
+            } else {
+                m_wake.wait(&m_mutex, QDeadlineTimer(wait));
+            }
+            continue;
+        }
+
+        Job &job = m_jobs[next];
+        FrameDecoder *decoder = job.decoder;
+        const qint64 queueWait = now - job.scheduledAt;
+        job.pending = false;
+        job.running = true;
+        if (job.priority == Priority::Secondary) {
+            job.notBefore = now + m_secondaryIntervalMs;
+        }
+
+        locker.unlock();
+        decoder->decodePending(queueWait);
+        locker.relock();
+
+        const int index = indexOf(decoder);
+        if (index >= 0) {
+            m_jobs[index].running = false;
+        }
+        m_finished.wakeAll();
+    }
+}
@@ -0,0 +1,76 @@
+#ifndef DECODERPOOL_H
+#define DECODERPOOL_H
+
+#include <QElapsedTimer>
+#include <QList>
+#include <QMutex>
+#include <QThread>
+#include <QWaitCondition>
+
+class FrameDecoder;
+
+// Worker threads shared by the FrameDecoders of all camera streams.
+//
+// A decoder is scheduled whenever its input mailbox receives a frame and is run by the
+// first free worker; a decoder never runs on two workers at once, so each stream is
+// still decoded in order. When several decoders are waiting, primary streams are
+// picked before secondary ones. A secondary stream (the swapped or picture-in-picture
+// view) is additionally limited to one decode per secondary interval: frames arriving
+// in between replace each other in its mailbox and only the newest one is decoded, so
+// the small view can never take the workers away from the main view.
+class DecoderPool
+{
+public:
+    enum class Priority {
+        Primary,
+        Secondary
+    };
+
+    // Process wide pool, sized by defaultWorkerCount()
+    static DecoderPool *instance();
+
+    // One worker per core, minus one core each for the ingest and GUI/render threads
+    static int defaultWorkerCount();
+
+    explicit DecoderPool(int workerCount);
+    ~DecoderPool();
+
+    int workerCount() const { return int(m_workers.size()); }
+
+    // Minimum spacing between two decodes of a secondary stream
+    void setSecondaryInterval(int intervalMs);
+    int secondaryInterval() const;
+
+    void addDecoder(FrameDecoder *decoder);
+    // Blocks until the decoder is no longer running on a worker
+    void removeDecoder(FrameDecoder *decoder);
+
+    void setPriority(FrameDecoder *decoder, Priority priority);
+
+    // Thread safe, called from the producer's thread when a frame is pending
+    void schedule(FrameDecoder *decoder);
+
+private:
+    struct Job {
+        FrameDecoder *decoder = nullptr;
+        Priority priority = Priority::Primary;
+        bool pending = false;
+        bool running = false;
+        qint64 scheduledAt = 0;     // first schedule() since the last decode
+        qint64 notBefore = 0;       // secondary rate limit
+    };
+
+    void run();
+    int indexOf(FrameDecoder *decoder) const;
+
+    mutable QMutex m_mutex;
+    QWaitCondition m_wake;          // a job became ready, or the pool is stopping
+    QWaitCondition m_finished;      // a running job returned
+    QList<Job> m_jobs;
+    QList<QThread *> m_workers;
+    QElapsedTimer m_clock;
+    qint64 m_secondaryIntervalMs;
+    bool m_stopping;
+};
+
+#endif // DECODERPOOL_H
@@ -0,0 +1,140 @@
+#ifndef FRAGMENTPROTOCOL_H
+#define FRAGMENTPROTOCOL_H
+
+#include <QtGlobal>
+#include <QtEndian>
+#include <QByteArray>
+#include <QList>
+
+// Frame ids are 16 bit and wrap about every 36 minutes at 30 fps, so they are compared
+// with serial number arithmetic (RFC 1982): distance(a, b) is the signed number of steps
+// from b to a, and a is newer than b when it is positive. A jump of MaxJump ids or more
+// in either direction is not reordering but a sender that restarted its counter.
+struct FrameIdSequence
+{
+    static constexpr int MaxJump = 1000;
+
+    static int distance(quint16 a, quint16 b) { return qint16(quint16(a - b)); }
+    static bool isNewer(quint16 a, quint16 b) { return distance(a, b) > 0; }
+    static bool isRestart(quint16 a, quint16 b) { return qAbs(distance(a, b)) >= MaxJump; }
+};
+
+// Header carried by every video datagram sent by the gimbal (visible and thermal):
+// frame_id(2) + total_fragments(4) + fragment_index(4) + fragment_size(4), big endian
+//
+// Optional forward error correction: a sender may add one XOR parity fragment per group
+// of groupSize consecutive data fragments. A parity fragment sets ParityFlag in
+// fragment_index, with the group size in bits 16..30 and the group number in bits 0..15.
+// Its payload is the XOR of the group's fragment sizes (4 bytes, big endian) followed by
+// the XOR of the group's payloads, each zero-padded to the stride. total_fragments only
+// counts data fragments, so receivers without FEC support reject parity as invalid.
+struct FragmentHeader
+{
+    static constexpr qsizetype Size = 14;
+    static constexpr quint32 ParityFlag = 0x80000000u;
+    static constexpr qsizetype ParityPrefixSize = 4;
+
+    quint16 frameId = 0;
+    quint32 totalFragments = 0;
+    quint32 fragmentIndex = 0;
+    quint32 fragmentSize = 0;
+
+    // Parses the header and checks it against the datagram size.
+    // Returns false for datagrams that cannot be a valid fragment.
+    static bool parse(const char *packet, qsizetype packetSize, FragmentHeader *header)
+    {
+        if (packetSize < Size) {
+            return false;
+        }
+
+        const uchar *data = reinterpret_cast<const uchar *>(packet);
+        header->frameId = qFromBigEndian<quint16>(data);
+        header->totalFragments = qFromBigEndian<quint32>(data + 2);
+        header->fragmentIndex = qFromBigEndian<quint32>(data + 6);
+        header->fragmentSize = qFromBigEndian<quint32>(data + 10);
+
+        if (header->fragmentSize != quint64(packetSize - Size)) {
+            return false;
+        }
+        if (header->isParity()) {
+            return header->parityGroupSize() > 0
+                   && header->fragmentSize > quint32(ParityPrefixSize)
+                   && quint64(header->parityGroup()) * header->parityGroupSize() < header->totalFragments;
+        }
+        return header->fragmentIndex < header->totalFragments;
+    }
+
+    bool isParity() const { return fragmentIndex & ParityFlag; }
+    quint32 parityGroupSize() const { return (fragmentIndex >> 16) & 0x7FFF; }
+    quint32 parityGroup() const { return fragmentIndex & 0xFFFF; }
+
+    static quint32 parityIndex(quint32 group, quint32 groupSize)
+    {
+        return ParityFlag | ((groupSize & 0x7FFF) << 16) | (group & 0xFFFF);
+    }
+
+    // Writes the header into the first Size bytes of out
+    void write(char *out) const
+    {
+        uchar *data = reinterpret_cast<uchar *>(out);
+        qToBigEndian<quint16>(frameId, data);
+        qToBigEndian<quint32>(totalFragments, data + 2);
+        qToBigEndian<quint32>(fragmentIndex, data + 6);
+        qToBigEndian<quint32>(fragmentSize, data + 10);
+    }
+
+    const char *payload(const char *packet) const { return packet + Size; }
+};
+
+// Selective retransmission request sent by the ground station on the control channel
+// (video port + 100), next to the text commands: "NK" + frame_id(2) + count(2) followed
+// by count fragment indices (4 bytes each), big endian. The sender retransmits the
+// listed fragments unchanged on the video port while the frame is still worth sending.
+struct NackPacket
+{
+    static constexpr qsizetype HeaderSize = 6;
+    static constexpr int MaxIndices = 256;
+
+    quint16 frameId = 0;
+    QList<quint32> fragmentIndices;
+
+    QByteArray encode() const
+    {
+        const qsizetype count = qMin<qsizetype>(fragmentIndices.size(), MaxIndices);
+        QByteArray packet(HeaderSize + count * 4, Qt::Uninitialized);
+        uchar *data = reinterpret_cast<uchar *>(packet.data());
+        data[0] = 'N';
+        data[1] = 'K';
+        qToBigEndian<quint16>(frameId, data + 2);
+        qToBigEndian<quint16>(quint16(count), data + 4);
+        for (qsizetype i = 0; i < count; ++i) {
+            qToBigEndian<quint32>(fragmentIndices.at(i), data + HeaderSize + i * 4);
+        }
+        return packet;
+    }
+
+    static bool isNack(const char *packet, qsizetype size)
+    {
+        return size >= HeaderSize && packet[0] == 'N' && packet[1] == 'K';
+    }
+
+    static bool decode(const char *packet, qsizetype size, NackPacket *nack)
+    {
+        if (!isNack(packet, size)) {
+            return false;
+        }
+        const uchar *data = reinterpret_cast<const uchar *>(packet);
+        const quint16 count = qFromBigEndian<quint16>(data + 4);
+        if (count > MaxIndices || size != HeaderSize + qsizetype(count) * 4) {
+            return false;
+        }
+        nack->frameId = qFromBigEndian<quint16>(data + 2);
+        nack->fragmentIndices.resize(count);
+        for (quint16 i = 0; i < count; ++i) {
+            nack->fragmentIndices[i] = qFromBigEndian<quint32>(data + HeaderSize + i * 4);
+        }
+        return true;
+    }
+};
+
+#endif // FRAGMENTPROTOCOL_H
@@ -0,0 +1,348 @@
+#include "framedecoder.h"
+#include <QBuffer>
+#include <QImageReader>
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QVideoFrameFormat>
+#include <cstring>
+
+#ifdef MARS_HAVE_TURBOJPEG
+#include <turbojpeg.h>
+
+namespace {
+
+// One decompressor per decode thread, creating it per frame costs more than the decode
+// of a small thumbnail
+struct TurboJpegDecompressor
+{
+    tjhandle handle = tjInitDecompress();
+    ~TurboJpegDecompressor()
+    {
+        if (handle) {
+            tjDestroy(handle);
+        }
+    }
+};
+
+tjhandle decompressor()
+{
+    thread_local TurboJpegDecompressor instance;
+    return instance.handle;
+}
+
+}
+#endif
+
+FrameDecoder::FrameDecoder(LatestFrameMailbox *input, LatestFrameMailbox *output, QObject *parent)
+    : QObject(parent)
+    , m_input(input)
+    , m_output(output)
+    , m_pool(DecoderPool::instance())
+    , m_videoFrameOutput(false)
+    , m_progressiveOutput(false)
+    , m_decodedFrames(0)
+    , m_failedFrames(0)
+    , m_queuedFrames(0)
+    , m_peakQueuedFrames(0)
+    , m_decodeTimeSum(0)
+    , m_queueWaitSum(0)
+    , m_timedDecodes(0)
+{
+    m_pool->addDecoder(this);
+}
+
+FrameDecoder::~FrameDecoder()
+{
+    m_pool->removeDecoder(this);
+}
+
+int FrameDecoder::scaleDenominator(const QSize &imageSize, const QSize &targetSize)
+{
+    if (targetSize.isEmpty() || imageSize.isEmpty()) {
+        return 1;
+    }
+    for (int denominator = 8; denominator > 1; denominator /= 2) {
+        if (imageSize.width() / denominator >= targetSize.width()
+            && imageSize.height() / denominator >= targetSize.height()) {
+            return denominator;
+        }
+    }
+    return 1;
+}
+
+QImage FrameDecoder::decode(const QByteArray &jpegData, const QSize &targetSize)
+{
+    QBuffer buffer;
+    buffer.setData(jpegData);
+    buffer.open(QIODevice::ReadOnly);
+    QImageReader reader(&buffer, "JPEG");
+
+    // The JPEG handler maps a scaled size of exactly 1/denominator of the image onto
+    // libjpeg's DCT scaling, without a separate resample pass
+    const int denominator = scaleDenominator(reader.size(), targetSize);
+    if (denominator > 1) {
+        const QSize imageSize = reader.size();
+        reader.setScaledSize(QSize((imageSize.width() + denominator - 1) / denominator,
+                                   (imageSize.height() + denominator - 1) / denominator));
+    }
+
+    QImage image;
+    if (!reader.read(&image)) {
+        return QImage();
+    }
+
+    // Upload friendly format, avoids a conversion on the render thread
+    if (image.format() != QImage::Format_RGB32 && image.format() != QImage::Format_ARGB32_Premultiplied) {
+        image.convertTo(QImage::Format_RGB32);
+    }
+    return image;
+}
+
+bool FrameDecoder::hasYuvDecoder()
+{
+#ifdef MARS_HAVE_TURBOJPEG
+    return true;
+#else
+    return false;
+#endif
+}
+
+QVideoFrame FrameDecoder::decodeYuv(const QByteArray &jpegData, const QSize &targetSize)
+{
+#ifdef MARS_HAVE_TURBOJPEG
+    tjhandle handle = decompressor();
+    if (!handle) {
+        return QVideoFrame();
+    }
+
+    const auto *jpeg = reinterpret_cast<const unsigned char *>(jpegData.constData());
+    const unsigned long jpegSize = static_cast<unsigned long>(jpegData.size());
+    int width = 0;
+    int height = 0;
+    int subsampling = 0;
+    int colorspace = 0;
+    if (tjDecompressHeader3(handle, jpeg, jpegSize, &width, &height, &subsampling, &colorspace) != 0) {
+        return QVideoFrame();
+    }
+
+    // Only the layouts QVideoFrame has a planar format for, the rest take the RGB path
+    QVideoFrameFormat::PixelFormat pixelFormat;
+    if (subsampling == TJSAMP_420 && colorspace == TJCS_YCbCr) {
+        pixelFormat = QVideoFrameFormat::Format_YUV420P;
+    } else if (subsampling == TJSAMP_422 && colorspace == TJCS_YCbCr) {
+        pixelFormat = QVideoFrameFormat::Format_YUV422P;
+    } else if (subsampling == TJSAMP_GRAY) {
+        pixelFormat = QVideoFrameFormat::Format_Y8;
+    } else {
+        return QVideoFrame();
+    }
+
+    // Same DCT scaling as the RGB path, libjpeg-turbo picks 1/denominator from the size
+    const int denominator = scaleDenominator(QSize(width, height), targetSize);
+    const QSize scaledSize((width + denominator - 1) / denominator,
+                           (height + denominator - 1) / denominator);
+
+    // Chroma planes are allocated for even dimensions, the viewport hides the padding
+    QSize frameSize = scaledSize;
+    if (pixelFormat != QVideoFrameFormat::Format_Y8) {
+        frameSize.rwidth() += frameSize.width() % 2;
+        if (pixelFormat == QVideoFrameFormat::Format_YUV420P) {
+            frameSize.rheight() += frameSize.height() % 2;
+        }
+    }
+
+    QVideoFrameFormat format(frameSize, pixelFormat);
+    format.setViewport(QRect(QPoint(0, 0), scaledSize));
+    format.setColorSpace(QVideoFrameFormat::ColorSpace_BT601);
+    format.setColorRange(QVideoFrameFormat::ColorRange_Full);   // JFIF samples use the full range
+
+    QVideoFrame frame(format);
+    if (!frame.map(QVideoFrame::WriteOnly)) {
+        return QVideoFrame();
+    }
+
+    unsigned char *planes[3] = { nullptr, nullptr, nullptr };
+    int strides[3] = { 0, 0, 0 };
+    for (int plane = 0; plane < frame.planeCount(); ++plane) {
+        planes[plane] = frame.bits(plane);
+        strides[plane] = frame.bytesPerLine(plane);
+    }
+
+    const int result = tjDecompressToYUVPlanes(handle, jpeg, jpegSize, planes,
+                                               scaledSize.width(), strides, scaledSize.height(), 0);
+    frame.unmap();
+
+    // Warnings (e.g. a truncated scan) still leave a displayable frame
+    if (result != 0 && tjGetErrorCode(handle) == TJERR_FATAL) {
+        return QVideoFrame();
+    }
+    return frame;
+#else
+    Q_UNUSED(jpegData)
+    Q_UNUSED(targetSize)
+    return QVideoFrame();
+#endif
+}
+
+void FrameDecoder::setPriority(DecoderPool::Priority priority)
+{
+    m_pool->setPriority(this, priority);
+}
+
+FrameDecoder::Statistics FrameDecoder::takeStatistics()
+{
+    QMutexLocker locker(&m_mutex);
+    Statistics statistics;
+    statistics.decodedFrames = m_decodedFrames;
+    statistics.failedFrames = m_failedFrames;
+    if (m_timedDecodes > 0) {
+        statistics.decodeTimeMs = m_decodeTimeSum / 1000.0 / m_timedDecodes;
+        statistics.queueWaitMs = double(m_queueWaitSum) / m_timedDecodes;
+    }
+    // Frames still waiting count too, a starved stream has no decodes to report
+    statistics.queueDepth = qMax(m_peakQueuedFrames, m_queuedFrames);
+
+    m_peakQueuedFrames = m_queuedFrames;
+    m_decodeTimeSum = 0;
+    m_queueWaitSum = 0;
+    m_timedDecodes = 0;
+    return statistics;
+}
+
+void FrameDecoder::schedule()
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        m_queuedFrames++;
+        m_peakQueuedFrames = qMax(m_peakQueuedFrames, m_queuedFrames);
+    }
+    m_pool->schedule(this);
+}
+
+void FrameDecoder::setVideoFrameOutput(bool enabled)
+{
+    QMutexLocker locker(&m_mutex);
+    if (m_videoFrameOutput != enabled) {
+        m_videoFrameOutput = enabled;
+        qDebug() << "Decoder output:" << (enabled ? (hasYuvDecoder() ? "YUV video frames" : "RGB video frames")
+                                                  : "images");
+    }
+}
+
+void FrameDecoder::setProgressiveOutput(bool enabled)
+{
+    QMutexLocker locker(&m_mutex);
+    if (m_progressiveOutput != enabled) {
+        m_progressiveOutput = enabled;
+        qDebug() << "Decoder progressive output:" << enabled;
+    }
+}
+
+void FrameDecoder::setFrameExport(const QString &name)
+{
+    if (name.isEmpty()) {
+        m_frameExport.close();
+    } else if (!m_frameExport.open(name, FrameExportSlots, FrameExportSlotCapacity)) {
+        qDebug() << "Cannot export decoded frames to shared memory" << name << m_frameExport.errorString();
+    }
+}
+
+void FrameDecoder::setTargetSize(const QSize &targetSize)
+{
+    QMutexLocker locker(&m_mutex);
+    if (m_targetSize != targetSize) {
+        m_targetSize = targetSize;
+        qDebug() << "Decoder target size:" << targetSize;
+    }
+}
+
+void FrameDecoder::fillFromPrevious(QImage *image, const LatestFrameMailbox::Frame &frame) const
+{
+    if (m_previousImage.size() != image->size() || m_previousImage.format() != image->format()
+        || frame.partialHeight <= 0) {
+        return;     // nothing to fill in with, the missing rows stay gray
+    }
+
+    // Rows are counted at full resolution, the image may be DCT scaled
+    const int validRows = int(qint64(frame.partialRows) * image->height() / frame.partialHeight);
+    const qsizetype rowBytes = image->bytesPerLine();
+    for (int y = validRows; y < image->height(); ++y) {
+        std::memcpy(image->scanLine(y), m_previousImage.constScanLine(y), size_t(rowBytes));
+    }
+}
+
+void FrameDecoder::decodePending(qint64 queueWaitMs)
+{
+    QSize targetSize;
+    bool videoFrameOutput;
+    bool progressiveOutput;
+    {
+        QMutexLocker locker(&m_mutex);
+        m_queuedFrames = 0;
+        targetSize = m_targetSize;
+        videoFrameOutput = m_videoFrameOutput;
+        progressiveOutput = m_progressiveOutput;
+    }
+
+    LatestFrameMailbox::Frame frame;
+    if (!m_input->take(&frame)) {
+        return;
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+
+    bool decoded;
+    if (progressiveOutput || frame.isPartial()) {
+        frame.image = decode(frame.data, targetSize);
+        decoded = !frame.image.isNull();
+        if (decoded) {
+            if (frame.isPartial()) {
+                fillFromPrevious(&frame.image, frame);
+            }
+            m_previousImage = frame.image;
+            if (videoFrameOutput) {
+                frame.videoFrame = QVideoFrame(frame.image);
+                frame.image = QImage();
+            }
+        }
+    } else if (videoFrameOutput) {
+        frame.videoFrame = decodeYuv(frame.data, targetSize);
+        if (!frame.videoFrame.isValid()) {
+            const QImage image = decode(frame.data, targetSize);
+            if (!image.isNull()) {
+                frame.videoFrame = QVideoFrame(image);
+            }
+        }
+        decoded = frame.videoFrame.isValid();
+    } else {
+        frame.image = decode(frame.data, targetSize);
+        decoded = !frame.image.isNull();
+    }
+
+    {
+        QMutexLocker locker(&m_mutex);
+        m_decodeTimeSum += timer.nsecsElapsed() / 1000;
+        m_queueWaitSum += queueWaitMs;
+        m_timedDecodes++;
+        if (decoded) {
+            m_decodedFrames++;
+        } else {
+            m_failedFrames++;
+        }
+    }
+
+    if (!decoded) {
+        qDebug() << "Failed to decode JPEG frame" << frame.frameId << "size:" << frame.data.size();
+        emit decodeFailed(frame.frameId);
+        return;
+    }
+
+    frame.timing.decoded = FrameTiming::now();
+    if (!frame.isPartial() && !frame.image.isNull()) {
+        m_frameExport.publishImage(frame.image, frame.frameId, frame.timing);
+    }
+    if (m_output->post(std::move(frame))) {
+        emit framePending();
+    }
+}
@@ -0,0 +1,116 @@
+#ifndef FRAMEDECODER_H
+#define FRAMEDECODER_H
+
+#include <QObject>
+#include <QImage>
+#include <QSize>
+#include <QVideoFrame>
+#include <QMutex>
+#include "latestframemailbox.h"
+#include "decoderpool.h"
+#include "sharedframering.h"
+
+// Decodes the JPEG frames of one stream on the shared DecoderPool so neither the ingest
+// thread nor the GUI thread pays for it. Encoded frames are taken from the input mailbox,
+// only the newest one is decoded, and the resulting QImage is posted to the output
+// mailbox for the view model. framePending and decodeFailed are emitted from a pool
+// worker thread.
+//
+// With a target size set, frames are decoded at 1/2, 1/4 or 1/8 scale in the DCT domain
+// (libjpeg scale_denom) whenever the smaller image still covers the target, so views
+// smaller than the stream never pay for a full decode plus resample.
+//
+// In video frame mode the decoder produces a QVideoFrame for a QVideoSink instead. Built
+// with libjpeg-turbo, the JPEG's YCbCr planes are decoded straight into a YUV420P,
+// YUV422P or Y8 frame and the color conversion is left to VideoOutput's shader; without
+// it, or for subsamplings QVideoFrame has no planar format for, the RGB32 image is wrapped.
+//
+// Partial frames (see PartialJpeg) are completed with the rows of the previously decoded
+// image below the part that arrived. With progressive output enabled every frame takes
+// the RGB path, so the previous image is always at hand; video frames wrap the image.
+class FrameDecoder : public QObject
+{
+    Q_OBJECT
+
+public:
+    // Per stream counters, the timings and the queue depth cover the time since the
+    // previous takeStatistics()
+    struct Statistics {
+        quint64 decodedFrames = 0;
+        quint64 failedFrames = 0;
+        double decodeTimeMs = 0.0;      // mean decode time
+        double queueWaitMs = 0.0;       // mean time a frame waited for a worker
+        int queueDepth = 0;             // most frames that arrived while waiting for a worker
+    };
+
+    FrameDecoder(LatestFrameMailbox *input, LatestFrameMailbox *output, QObject *parent = nullptr);
+    ~FrameDecoder();
+
+    static QImage decode(const QByteArray &jpegData, const QSize &targetSize = QSize());
+
+    // Largest of 1, 2, 4, 8 that keeps the decoded image at least targetSize
+    static int scaleDenominator(const QSize &imageSize, const QSize &targetSize);
+
+    // Planar YCbCr decode, invalid frame when the JPEG cannot be decoded that way
+    static QVideoFrame decodeYuv(const QByteArray &jpegData, const QSize &targetSize = QSize());
+    static bool hasYuvDecoder();
+
+    // Thread safe
+    void setPriority(DecoderPool::Priority priority);
+    Statistics takeStatistics();
+
+public slots:
+    // Pixel size the decoded frames are displayed at, empty for full resolution
+    void setTargetSize(const QSize &targetSize);
+
+    // Produce QVideoFrames instead of QImages
+    void setVideoFrameOutput(bool enabled);
+
+    // The input carries partial frames
+    void setProgressiveOutput(bool enabled);
+
+    // Export the complete frames decoded as images to the shared memory ring /name, an
+    // empty name stops exporting. Frames are exported as decoded for display, at the
+    // target size; frames decoded to YUV video frames are not exported.
+    void setFrameExport(const QString &name);
+
+    // Connected to the producer's framePending signal with Qt::DirectConnection,
+    // queues this stream on the pool from the producer's thread
+    void schedule();
+
+signals:
+    void framePending();    // the output mailbox went from empty to full
+    void decodeFailed(quint16 frameId);
+
+private:
+    friend class DecoderPool;
+
+    // Runs on a pool worker
+    void decodePending(qint64 queueWaitMs);
+    void fillFromPrevious(QImage *image, const LatestFrameMailbox::Frame &frame) const;
+
+    LatestFrameMailbox *m_input;
+    LatestFrameMailbox *m_output;
+    DecoderPool *m_pool;
+
+    QMutex m_mutex;                 // settings and statistics, shared with the pool worker
+    QSize m_targetSize;
+    bool m_videoFrameOutput;
+    bool m_progressiveOutput;
+    quint64 m_decodedFrames;
+    quint64 m_failedFrames;
+    int m_queuedFrames;             // frames scheduled since the last decode started
+    int m_peakQueuedFrames;
+    qint64 m_decodeTimeSum;         // microseconds, since the last takeStatistics()
+    qint64 m_queueWaitSum;          // milliseconds
+    int m_timedDecodes;
+
+    QImage m_previousImage;         // pool worker only, a decoder never runs on two at once
+
+    // Decoded frames are far larger than JPEGs: a few slots of up to 1080p
+    static constexpr int FrameExportSlots = 4;
+    static constexpr qsizetype FrameExportSlotCapacity = 1920 * 1080 * 4;
+    SharedFrameRing m_frameExport;
+};
+
+#endif // FRAMEDECODER_H
@@ -0,0 +1,99 @@
+#include "framehistory.h"
+
+FrameHistory::FrameHistory(int capacity, int decodedEntries)
+    : m_entries(qMax(1, capacity))
+    , m_decodedEntries(qMax(1, decodedEntries))
+    , m_presentedFrameId(-1)
+{
+}
+
+void FrameHistory::add(const LatestFrameMailbox::Frame &frame)
+{
+    QMutexLocker locker(&m_mutex);
+    Slot &slot = m_entries[frame.frameId % m_entries.size()];
+    slot.entry.frameId = frame.frameId;
+    slot.entry.data = frame.data;
+    slot.entry.image = frame.image;
+    slot.entry.videoFrame = frame.videoFrame;
+    slot.entry.timing = frame.timing;
+    slot.entry.presented = 0;
+    slot.valid = true;
+
+    // Let go of the pixels of older frames, their JPEG is enough to decode them again
+    m_decodedFrameIds.append(frame.frameId);
+    while (m_decodedFrameIds.size() > m_decodedEntries) {
+        const quint16 frameId = m_decodedFrameIds.takeFirst();
+        Slot &old = m_entries[frameId % m_entries.size()];
+        if (old.entry.frameId == frameId && frameId != frame.frameId) {
+            old.entry.image = QImage();
+            old.entry.videoFrame = QVideoFrame();
+        }
+    }
+}
+
+void FrameHistory::markPresented(quint16 frameId)
+{
+    QMutexLocker locker(&m_mutex);
+    Slot &slot = m_entries[frameId % m_entries.size()];
+    if (!slot.valid || slot.entry.frameId != frameId) {
+        return;
+    }
+    if (slot.entry.presented == 0) {
+        slot.entry.presented = FrameTiming::now();
+    }
+    m_presentedFrameId = frameId;
+}
+
+int FrameHistory::presentedFrameId() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_presentedFrameId;
+}
+
+bool FrameHistory::find(quint16 frameId, Entry *entry) const
+{
+    QMutexLocker locker(&m_mutex);
+    const Slot &slot = m_entries.at(frameId % m_entries.size());
+    if (!slot.valid || slot.entry.frameId != frameId) {
+        return false;
+    }
+    *entry = slot.entry;
+    return true;
+}
+
+bool FrameHistory::presentedFrame(Entry *entry) const
+{
+    QMutexLocker locker(&m_mutex);
+    if (m_presentedFrameId < 0) {
+        return false;
+    }
+    const Slot &slot = m_entries.at(m_presentedFrameId % m_entries.size());
+    if (!slot.valid || slot.entry.frameId != m_presentedFrameId) {
+        return false;
+    }
+    *entry = slot.entry;
+    return true;
+}
+
+QList<FrameHistory::Entry> FrameHistory::entries() const
+{
+    QMutexLocker locker(&m_mutex);
+    QList<Entry> entries;
+    entries.reserve(m_entries.size());
+    for (const Slot &slot : m_entries) {
+        if (slot.valid) {
+            entries.append(slot.entry);
+        }
+    }
+    return entries;
+}
+
+void FrameHistory::clear()
+{
+    QMutexLocker locker(&m_mutex);
+    for (Slot &slot : m_entries) {
+        slot = Slot();
+    }
+    m_decodedFrameIds.clear();
+    m_presentedFrameId = -1;
+}
@@ -0,0 +1,75 @@
+#ifndef FRAMEHISTORY_H
+#define FRAMEHISTORY_H
+
+#include <QByteArray>
+#include <QImage>
+#include <QList>
+#include <QMutex>
+#include <QVideoFrame>
+#include "frametiming.h"
+#include "latestframemailbox.h"
+
+// The last frames a stream handed to the screen, by frame id.
+//
+// An input on the video (a target click, a snapshot, a tracker seed) refers to the frame
+// the operator saw, which by the time the input is handled may no longer be the newest
+// one. The view model adds every complete frame it displays, the surface that shows it
+// reports it presented, and the frame behind the input is then looked up by id. Entries
+// hold the encoded JPEG, implicitly shared with the display path. Only the last
+// decodedEntries frames added also keep their decoded image or video frame: a decoded
+// 1080p frame is 8 MB, and video frames held here are not returned to the decoder's or
+// the sink's pool. Older entries have a null image and video frame, decode data if the
+// pixels are needed.
+//
+// Entries live in a ring of capacity slots indexed by frameId % capacity; a frame
+// overwrites the one capacity ids older. Thread safe: frames are added on the GUI
+// thread, markPresented() is called from the render thread.
+class FrameHistory
+{
+public:
+    struct Entry {
+        quint16 frameId = 0;
+        QByteArray data;            // encoded frame as received
+        QImage image;               // decoded frame, null when shown as a video frame or no longer kept
+        QVideoFrame videoFrame;
+        FrameTiming timing;
+        qint64 presented = 0;       // FrameTiming clock, 0 until shown
+    };
+
+    explicit FrameHistory(int capacity = 32, int decodedEntries = 4);
+
+    FrameHistory(const FrameHistory &) = delete;
+    FrameHistory &operator=(const FrameHistory &) = delete;
+
+    int capacity() const { return int(m_entries.size()); }
+
+    void add(const LatestFrameMailbox::Frame &frame);
+
+    // The frame was shown on screen, ignored for ids not in the history
+    void markPresented(quint16 frameId);
+
+    // Frame presented last, -1 before the first one
+    int presentedFrameId() const;
+
+    bool find(quint16 frameId, Entry *entry) const;
+    bool presentedFrame(Entry *entry) const;
+
+    // Every frame held, in no particular order
+    QList<Entry> entries() const;
+
+    void clear();
+
+private:
+    struct Slot {
+        Entry entry;
+        bool valid = false;
+    };
+
+    mutable QMutex m_mutex;
+    QList<Slot> m_entries;
+    QList<quint16> m_decodedFrameIds;   // entries holding pixels, oldest first
+    int m_decodedEntries;
+    int m_presentedFrameId;
+};
+
+#endif // FRAMEHISTORY_H
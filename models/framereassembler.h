@@ -0,0 +1,691 @@
+#ifndef FRAMEREASSEMBLER_H
+#define FRAMEREASSEMBLER_H
+
+#include <QByteArray>
+#include <QList>
+#include <QtEndian>
+#include <array>
+#include <cstring>
+#include <vector>
+#include "fragmentprotocol.h"
+
+// Reassembles fragmented video frames shared by CameraModel and ThermalCameraModel.
+//
+// Every fragment except the last carries the same payload size (the stride), so a
+// fragment's final position in the frame is fragmentIndex * stride. Fragments are
+// copied once, straight from the datagram into a contiguous frame buffer, and the
+// completed frame is handed out as that same buffer, no copy. The consumers keep frames
+// for a while (history, jitter buffer, recorder), so the buffer goes with the frame and
+// every frame allocates one new buffer of its size; the buffer of a frame that is
+// dropped incomplete is freed at once.
+//
+// Frames in flight live in a fixed ring of SlotCount slots indexed by frameId % SlotCount.
+// A slot keeps its bitmap capacity when it is recycled. A frame that lands on a slot
+// still holding an older frame evicts it.
+//
+// When the sender adds XOR parity fragments (see FragmentHeader), a group missing a
+// single data fragment is rebuilt in place as soon as the parity and the rest of the
+// group are present.
+//
+// Frame ids are ordered with FrameIdSequence, so wraparound is harmless. Only frames
+// within the reorder window behind the newest frame are assembled: a fragment of an
+// older frame, or of a frame not newer than the last one the consumer delivered (see
+// markDelivered()), is rejected as Stale before it can take a slot, and frames that
+// fall out of the window are dropped as soon as a newer frame starts. The window is
+// smaller than SlotCount, so two frames in flight never share a slot. A jump of
+// FrameIdSequence::MaxJump ids restarts the sequence, but only once RestartConfirmFragments
+// fragments in a row land in the new id region: until then they are rejected as Stale,
+// so a stray or replayed datagram cannot wipe the frames in flight.
+//
+// Memory is bounded by a MemoryBudget instead of trusting the header: a frame announcing
+// more than maxFragments fragments is rejected before anything is allocated, and the
+// frame and parity buffers of all frames in flight never exceed maxBytes. A frame that
+// needs room evicts the oldest incomplete frames; one that cannot fit even alone is
+// rejected. Completed frames are not counted, they belong to the consumer.
+//
+// takePrefix() hands out the contiguous start of a frame still in flight, for
+// progressive display of the rows that already arrived (see PartialJpeg).
+//
+// With a NackPolicy enabled, collectNacks() turns fragment gaps into retransmission
+// requests: gaps below the highest fragment seen once they outlive the reorder grace
+// time, and the missing tail of a frame once a newer frame has started.
+template <typename Header = FragmentHeader, int SlotCount = 16>
+class FrameReassembler
+{
+public:
+    enum class Result {
+        Incomplete,     // fragment stored, frame still missing fragments
+        Complete,       // fragment completed the frame, see Frame
+        Duplicate,      // fragment already received, or its frame was already completed
+        Stale,          // frame behind the reorder window or the last delivered frame
+        Malformed       // header invalid or inconsistent with the frame
+    };
+
+    struct Frame {
+        QByteArray data;
+        quint16 frameId = 0;
+        qint64 firstFragmentTime = 0;
+        quint32 recoveredFragments = 0;     // fragments rebuilt from parity
+    };
+
+    struct NackPolicy {
+        bool enabled = false;
+        qint64 reorderGraceMs = 3;      // a gap younger than this may just be reordering
+        qint64 retryIntervalMs = 20;    // between two requests for the same frame
+        qint64 latencyBudgetMs = 150;   // frames older than this are not worth asking for
+        int maxRetries = 3;
+    };
+
+    struct MemoryBudget {
+        quint32 maxFragments = 4096;                // per frame
+        qsizetype maxBytes = 32 * 1024 * 1024;      // over all frames in flight
+    };
+
+    explicit FrameReassembler(qint64 timeoutMs = 5000)
+        : m_timeoutMs(timeoutMs)
+    {
+    }
+
+    // Header of the last fragment passed to addFragment(), valid unless Malformed
+    const Header &lastHeader() const { return m_header; }
+
+    Result addFragment(const char *packet, qsizetype size, qint64 now, Frame *frame)
+    {
+        if (!Header::parse(packet, size, &m_header)) {
+            return Result::Malformed;
+        }
+
+        if (m_hasNewestFrame && FrameIdSequence::isRestart(m_header.frameId, m_newestFrameId)) {
+            if (!confirmRestart(m_header.frameId)) {
+                m_staleFragments++;
+                return Result::Stale;
+            }
+            restartSequence();
+        } else {
+            m_restartFragments = 0;
+        }
+        if (isStale(m_header.frameId)) {
+            m_staleFragments++;
+            return Result::Stale;
+        }
+        if (m_header.totalFragments > m_budget.maxFragments) {
+            m_oversizedFragments++;
+            return Result::Malformed;
+        }
+
+        Assembly &assembly = m_slots[m_header.frameId % SlotCount];
+        if (assembly.frameId == m_header.frameId && assembly.state == SlotState::Completed) {
+            return Result::Duplicate;
+        }
+        if (assembly.state != SlotState::Assembling || assembly.frameId != m_header.frameId) {
+            if (assembly.state == SlotState::Assembling) {
+                m_evictedFrames++;
+                dropAssembly(assembly);
+            }
+            startAssembly(assembly, now);
+        }
+
+        if (assembly.totalFragments != m_header.totalFragments) {
+            return Result::Malformed;
+        }
+
+        const char *payload = m_header.payload(packet);
+        quint32 group = 0;
+
+        if (m_header.isParity()) {
+            const Result result = storeParity(assembly, payload);
+            if (result != Result::Incomplete) {
+                return result;
+            }
+            group = m_header.parityGroup();
+        } else {
+            if (assembly.hasFragment(m_header.fragmentIndex)) {
+                return Result::Duplicate;
+            }
+
+            const bool lastFragment = m_header.fragmentIndex + 1 == m_header.totalFragments;
+            if (lastFragment && assembly.stride == 0 && assembly.totalFragments > 1) {
+                // The offset of the last fragment is unknown until another fragment
+                // tells us the stride, keep it aside until then
+                assembly.pendingTail.resize(m_header.fragmentSize);
+                std::memcpy(assembly.pendingTail.data(), payload, m_header.fragmentSize);
+            } else {
+                if ((!lastFragment || assembly.totalFragments == 1)
+                    && !setStride(assembly, m_header.fragmentSize)) {
+                    return Result::Malformed;
+                }
+                if (!place(assembly, m_header.fragmentIndex, payload, m_header.fragmentSize)) {
+                    return Result::Malformed;
+                }
+            }
+
+            assembly.setFragment(m_header.fragmentIndex);
+            assembly.receivedFragments++;
+            advanceContiguous(assembly);
+            assembly.lastFragmentTime = now;
+            if (qint64(m_header.fragmentIndex) > assembly.highestIndex) {
+                if (qint64(m_header.fragmentIndex) > assembly.highestIndex + 1 && assembly.gapSince < 0) {
+                    assembly.gapSince = now;
+                }
+                assembly.highestIndex = m_header.fragmentIndex;
+            }
+            group = assembly.groupSize ? m_header.fragmentIndex / assembly.groupSize : 0;
+        }
+
+        if (assembly.groupSize > 0 && assembly.receivedFragments < assembly.totalFragments) {
+            recoverGroup(assembly, group);
+        }
+
+        if (assembly.receivedFragments < assembly.totalFragments) {
+            return Result::Incomplete;
+        }
+
+        assembly.buffer.resize(assembly.frameSize);
+        frame->frameId = m_header.frameId;
+        frame->firstFragmentTime = assembly.timestamp;
+        frame->recoveredFragments = assembly.recoveredFragments;
+        frame->data = std::move(assembly.buffer);
+        assembly.buffer = QByteArray();
+        if (assembly.recoveredFragments > 0) {
+            m_recoveredFrames++;
+        }
+        releaseReservation(assembly);
+        assembly.state = SlotState::Completed;
+        return Result::Complete;
+    }
+
+    // Copies the contiguous start of the frame of the last fragment, when that frame is
+    // still incomplete and its start grew by 1/steps of the frame since the last copy
+    bool takePrefix(int steps, Frame *frame)
+    {
+        Assembly &assembly = m_slots[m_header.frameId % SlotCount];
+        if (assembly.state != SlotState::Assembling || assembly.frameId != m_header.frameId
+            || assembly.stride == 0) {
+            return false;
+        }
+
+        const qsizetype prefix = qsizetype(assembly.contiguousFragments) * assembly.stride;
+        const quint32 stepFragments = qMax<quint32>(1, assembly.totalFragments / quint32(qMax(1, steps)));
+        if (prefix - assembly.releasedPrefix < qsizetype(stepFragments) * assembly.stride) {
+            return false;
+        }
+
+        assembly.releasedPrefix = prefix;
+        frame->data = QByteArray(assembly.buffer.constData(), prefix);
+        frame->frameId = assembly.frameId;
+        frame->firstFragmentTime = assembly.timestamp;
+        frame->recoveredFragments = assembly.recoveredFragments;
+        return true;
+    }
+
+    // Drops frames whose first fragment is older than the timeout, returns their ids
+    QList<quint16> expireFrames(qint64 now)
+    {
+        QList<quint16> expired;
+        for (Assembly &assembly : m_slots) {
+            if (assembly.state == SlotState::Assembling && now - assembly.timestamp > m_timeoutMs) {
+                expired.append(assembly.frameId);
+                if (assembly.groupSize > 0) {
+                    m_unrecoverableFrames++;
+                }
+                dropAssembly(assembly);
+            }
+        }
+        return expired;
+    }
+
+    void clear()
+    {
+        for (Assembly &assembly : m_slots) {
+            assembly = Assembly();
+        }
+        m_hasNewestFrame = false;
+        m_hasDeliveredFrame = false;
+        m_restartFragments = 0;
+        m_bytesInUse = 0;
+    }
+
+    void setMemoryBudget(const MemoryBudget &budget) { m_budget = budget; }
+    const MemoryBudget &memoryBudget() const { return m_budget; }
+
+    // Buffer bytes held by frames in flight, now and at most since construction
+    qsizetype bytesInUse() const { return m_bytesInUse; }
+    qsizetype peakBytes() const { return m_peakBytes; }
+
+    // Incomplete frames evicted to stay within maxBytes, also counted in evictedFrames()
+    quint64 budgetEvictions() const { return m_budgetEvictions; }
+    // Fragments rejected as Malformed because their frame exceeds the budget on its own
+    quint64 oversizedFragments() const { return m_oversizedFragments; }
+
+    // Frames this many ids behind the newest one are still assembled, at most SlotCount - 1
+    void setReorderWindow(int frames) { m_reorderWindow = qBound(0, frames, SlotCount - 1); }
+    int reorderWindow() const { return m_reorderWindow; }
+
+    // The consumer showed frameId: older frames are dropped now and rejected from here on
+    void markDelivered(quint16 frameId)
+    {
+        if (m_hasDeliveredFrame && !FrameIdSequence::isNewer(frameId, m_deliveredFrameId)
+            && !FrameIdSequence::isRestart(frameId, m_deliveredFrameId)) {
+            return;
+        }
+        m_deliveredFrameId = frameId;
+        m_hasDeliveredFrame = true;
+        for (Assembly &assembly : m_slots) {
+            if (assembly.state == SlotState::Assembling && isStale(assembly.frameId)) {
+                m_evictedFrames++;
+                dropAssembly(assembly);
+            }
+        }
+    }
+
+    // Fragments rejected as Stale
+    quint64 staleFragments() const { return m_staleFragments; }
+
+    int pendingFrames() const
+    {
+        int pending = 0;
+        for (const Assembly &assembly : m_slots) {
+            pending += assembly.state == SlotState::Assembling ? 1 : 0;
+        }
+        return pending;
+    }
+
+    // Incomplete frames pushed out of their slot by a newer frame, the window or the budget
+    quint64 evictedFrames() const { return m_evictedFrames; }
+
+    void setNackPolicy(const NackPolicy &policy) { m_nackPolicy = policy; }
+    const NackPolicy &nackPolicy() const { return m_nackPolicy; }
+
+    // Appends a retransmission request for every frame whose gaps are due one
+    void collectNacks(qint64 now, QList<NackPacket> *requests)
+    {
+        if (!m_nackPolicy.enabled) {
+            return;
+        }
+
+        for (Assembly &assembly : m_slots) {
+            if (assembly.state != SlotState::Assembling
+                || assembly.nackCount >= m_nackPolicy.maxRetries
+                || now - assembly.timestamp > m_nackPolicy.latencyBudgetMs
+                || (assembly.nackCount > 0 && now - assembly.lastNackTime < m_nackPolicy.retryIntervalMs)) {
+                continue;
+            }
+
+            const bool superseded = assembly.frameId != m_newestFrameId;
+            const bool gapDue = assembly.gapSince >= 0 && now - assembly.gapSince >= m_nackPolicy.reorderGraceMs;
+            const bool tailDue = superseded && now - assembly.lastFragmentTime >= m_nackPolicy.reorderGraceMs;
+            if (!gapDue && !tailDue) {
+                continue;
+            }
+
+            NackPacket nack;
+            nack.frameId = assembly.frameId;
+            const quint32 end = superseded ? assembly.totalFragments : quint32(assembly.highestIndex + 1);
+            for (quint32 index = 0; index < end && nack.fragmentIndices.size() < NackPacket::MaxIndices; ++index) {
+                if (!assembly.hasFragment(index)) {
+                    nack.fragmentIndices.append(index);
+                }
+            }
+            if (nack.fragmentIndices.isEmpty()) {
+                continue;
+            }
+
+            assembly.nackCount++;
+            assembly.lastNackTime = now;
+            m_nackRequests++;
+            m_nackedFragments += quint64(nack.fragmentIndices.size());
+            requests->append(nack);
+        }
+    }
+
+    quint64 nackRequests() const { return m_nackRequests; }
+    quint64 nackedFragments() const { return m_nackedFragments; }
+
+    // Frames completed thanks to parity, and frames that expired incomplete although
+    // parity was received
+    quint64 recoveredFrames() const { return m_recoveredFrames; }
+    quint64 unrecoverableFrames() const { return m_unrecoverableFrames; }
+
+    // Consecutive fragments far from the newest frame needed to accept a sender restart
+    static constexpr int RestartConfirmFragments = 8;
+
+private:
+    enum class SlotState {
+        Idle,
+        Assembling,
+        Completed       // kept so late fragments and parity of a delivered frame are ignored
+    };
+
+    struct Assembly {
+        SlotState state = SlotState::Idle;
+        quint16 frameId = 0;
+        quint32 totalFragments = 0;
+        quint32 receivedFragments = 0;
+        quint32 recoveredFragments = 0;
+        quint32 stride = 0;             // payload size of every fragment but the last
+        quint32 groupSize = 0;          // data fragments per parity group, 0 without FEC
+        quint32 groupCount = 0;
+        qsizetype frameSize = 0;        // bytes of the complete frame, known with the last fragment
+        qint64 highestIndex = -1;       // highest data fragment received
+        qint64 gapSince = -1;           // when a gap below highestIndex first appeared
+        qint64 lastFragmentTime = 0;
+        qint64 lastNackTime = 0;
+        int nackCount = 0;
+        std::vector<quint64> received;  // one bit per fragment, capacity kept across frames
+        std::vector<quint64> parityReceived;
+        QByteArray buffer;
+        QByteArray parity;              // groupCount parity payloads of ParityPrefixSize + stride bytes
+        QByteArray pendingTail;         // last fragment received before the stride was known
+        qint64 timestamp = 0;
+        qsizetype reservedBytes = 0;    // counted against the memory budget
+        quint32 contiguousFragments = 0;    // fragments 0..n-1 all present
+        qsizetype releasedPrefix = 0;   // bytes already handed out by takePrefix()
+        bool parityReserved = false;
+
+        bool hasFragment(quint32 index) const { return received[index >> 6] & (quint64(1) << (index & 63)); }
+        void setFragment(quint32 index) { received[index >> 6] |= quint64(1) << (index & 63); }
+        void clearFragment(quint32 index) { received[index >> 6] &= ~(quint64(1) << (index & 63)); }
+        bool hasParity(quint32 group) const { return parityReceived[group >> 6] & (quint64(1) << (group & 63)); }
+        void setParity(quint32 group) { parityReceived[group >> 6] |= quint64(1) << (group & 63); }
+        qsizetype paritySize() const { return Header::ParityPrefixSize + stride; }
+    };
+
+    void startAssembly(Assembly &assembly, qint64 now)
+    {
+        releaseReservation(assembly);
+        assembly.buffer = QByteArray();
+        assembly.state = SlotState::Assembling;
+        assembly.frameId = m_header.frameId;
+        assembly.totalFragments = m_header.totalFragments;
+        assembly.receivedFragments = 0;
+        assembly.recoveredFragments = 0;
+        assembly.stride = 0;
+        assembly.groupSize = 0;
+        assembly.groupCount = 0;
+        assembly.frameSize = 0;
+        assembly.highestIndex = -1;
+        assembly.gapSince = -1;
+        assembly.lastFragmentTime = now;
+        assembly.lastNackTime = 0;
+        assembly.nackCount = 0;
+        assembly.received.assign((size_t(m_header.totalFragments) + 63) / 64, 0);
+        assembly.parityReceived.clear();
+        assembly.pendingTail.resize(0);
+        assembly.timestamp = now;
+        assembly.parityReserved = false;
+        assembly.contiguousFragments = 0;
+        assembly.releasedPrefix = 0;
+
+        if (!m_hasNewestFrame || FrameIdSequence::isNewer(m_header.frameId, m_newestFrameId)) {
+            m_newestFrameId = m_header.frameId;
+            m_hasNewestFrame = true;
+
+            // Frames that fell out of the window cannot complete in time, free them now
+            for (Assembly &other : m_slots) {
+                if (other.state == SlotState::Assembling && &other != &assembly && isStale(other.frameId)) {
+                    m_evictedFrames++;
+                    dropAssembly(other);
+                }
+            }
+        }
+    }
+
+    bool isStale(quint16 frameId) const
+    {
+        if (m_hasNewestFrame && FrameIdSequence::distance(frameId, m_newestFrameId) < -m_reorderWindow) {
+            return true;
+        }
+        return m_hasDeliveredFrame && !FrameIdSequence::isNewer(frameId, m_deliveredFrameId);
+    }
+
+    // Counts a fragment MaxJump ids or more away from the newest frame, true once enough
+    // of them arrived in a row, close to each other, to be a restarted sender
+    bool confirmRestart(quint16 frameId)
+    {
+        if (m_restartFragments == 0 || FrameIdSequence::isRestart(frameId, m_restartFrameId)) {
+            m_restartFrameId = frameId;
+            m_restartFragments = 0;
+        }
+        if (++m_restartFragments < RestartConfirmFragments) {
+            return false;
+        }
+        m_restartFragments = 0;
+        return true;
+    }
+
+    // The sender restarted its frame counter, nothing in flight belongs to the new sequence
+    void restartSequence()
+    {
+        for (Assembly &assembly : m_slots) {
+            if (assembly.state == SlotState::Assembling) {
+                m_evictedFrames++;
+                dropAssembly(assembly);
+            }
+            assembly.state = SlotState::Idle;
+        }
+        m_hasNewestFrame = false;
+        m_hasDeliveredFrame = false;
+    }
+
+    // Evictions and restarts are counted by the caller, they are not FEC failures
+    void dropAssembly(Assembly &assembly)
+    {
+        releaseReservation(assembly);
+        assembly.buffer = QByteArray();
+        assembly.state = SlotState::Idle;
+    }
+
+    // Counts bytes more against the budget, evicting the oldest frames in flight until
+    // they fit. Fails, dropping the frame, when it cannot fit alone or is the oldest itself.
+    bool reserve(Assembly &assembly, qsizetype bytes)
+    {
+        if (assembly.reservedBytes + bytes > m_budget.maxBytes) {
+            m_oversizedFragments++;
+            dropAssembly(assembly);
+            return false;
+        }
+        while (m_bytesInUse + bytes > m_budget.maxBytes) {
+            Assembly *oldest = &assembly;
+            for (Assembly &other : m_slots) {
+                if (other.state == SlotState::Assembling && other.reservedBytes > 0
+                    && FrameIdSequence::isNewer(oldest->frameId, other.frameId)) {
+                    oldest = &other;
+                }
+            }
+            m_evictedFrames++;
+            m_budgetEvictions++;
+            dropAssembly(*oldest);
+            if (oldest == &assembly) {
+                return false;
+            }
+        }
+
+        assembly.reservedBytes += bytes;
+        m_bytesInUse += bytes;
+        m_peakBytes = qMax(m_peakBytes, m_bytesInUse);
+        return true;
+    }
+
+    static void advanceContiguous(Assembly &assembly)
+    {
+        while (assembly.contiguousFragments < assembly.totalFragments
+               && assembly.hasFragment(assembly.contiguousFragments)) {
+            assembly.contiguousFragments++;
+        }
+    }
+
+    void releaseReservation(Assembly &assembly)
+    {
+        m_bytesInUse -= assembly.reservedBytes;
+        assembly.reservedBytes = 0;
+    }
+
+    // Fixes the stride of a frame, allocating its buffer and placing a held back last fragment.
+    // False when the stride is invalid or does not fit the budget.
+    bool setStride(Assembly &assembly, quint32 stride)
+    {
+        if (assembly.stride != 0) {
+            return assembly.stride == stride;
+        }
+        if (stride == 0) {
+            return false;
+        }
+
+        if (!reserve(assembly, qsizetype(stride) * assembly.totalFragments)) {
+            return false;
+        }
+        assembly.stride = stride;
+        assembly.buffer = QByteArray(qsizetype(stride) * assembly.totalFragments, Qt::Uninitialized);
+        if (!assembly.pendingTail.isEmpty()) {
+            const quint32 tail = assembly.totalFragments - 1;
+            if (!place(assembly, tail, assembly.pendingTail.constData(), assembly.pendingTail.size())) {
+                // The tail is longer than a stride, so it was bogus. Forget it, and a
+                // retransmitted tail is taken instead of being rejected as a duplicate.
+                assembly.clearFragment(tail);
+                assembly.receivedFragments--;
+            }
+            assembly.pendingTail.resize(0);
+        }
+        return true;
+    }
+
+    bool place(Assembly &assembly, quint32 index, const char *payload, qsizetype size)
+    {
+        if (size > qsizetype(assembly.stride)) {
+            return false;
+        }
+        const qsizetype offset = qsizetype(index) * assembly.stride;
+        std::memcpy(assembly.buffer.data() + offset, payload, size_t(size));
+        if (index + 1 == assembly.totalFragments) {
+            assembly.frameSize = offset + size;
+        }
+        return true;
+    }
+
+    Result storeParity(Assembly &assembly, const char *payload)
+    {
+        const quint32 groupSize = m_header.parityGroupSize();
+        const quint32 group = m_header.parityGroup();
+
+        if (assembly.groupSize == 0) {
+            assembly.groupSize = groupSize;
+            assembly.groupCount = (assembly.totalFragments + groupSize - 1) / groupSize;
+            assembly.parityReceived.assign((size_t(assembly.groupCount) + 63) / 64, 0);
+        } else if (assembly.groupSize != groupSize) {
+            return Result::Malformed;
+        }
+
+        // The parity payload is one stride wide, so it also tells us the stride
+        if (!setStride(assembly, m_header.fragmentSize - quint32(Header::ParityPrefixSize))) {
+            return Result::Malformed;
+        }
+        if (assembly.hasParity(group)) {
+            return Result::Duplicate;
+        }
+
+        const qsizetype paritySize = assembly.paritySize();
+        if (!assembly.parityReserved) {
+            if (!reserve(assembly, paritySize * assembly.groupCount)) {
+                return Result::Malformed;
+            }
+            assembly.parityReserved = true;
+        }
+        if (assembly.parity.size() != paritySize * assembly.groupCount) {
+            assembly.parity.resize(paritySize * assembly.groupCount);
+        }
+        std::memcpy(assembly.parity.data() + group * paritySize, payload, size_t(paritySize));
+        assembly.setParity(group);
+        return Result::Incomplete;
+    }
+
+    // Rebuilds the only missing data fragment of a group from its parity
+    void recoverGroup(Assembly &assembly, quint32 group)
+    {
+        if (group >= assembly.groupCount || !assembly.hasParity(group)) {
+            return;
+        }
+
+        const quint32 first = group * assembly.groupSize;
+        const quint32 end = qMin(first + assembly.groupSize, assembly.totalFragments);
+        quint32 missing = end;
+        for (quint32 index = first; index < end; ++index) {
+            if (!assembly.hasFragment(index)) {
+                if (missing != end) {
+                    return;
+                }
+                missing = index;
+            }
+        }
+        if (missing == end) {
+            return;
+        }
+
+        const qsizetype stride = assembly.stride;
+        const char *parity = assembly.parity.constData() + group * assembly.paritySize();
+        quint32 size = qFromBigEndian<quint32>(reinterpret_cast<const uchar *>(parity));
+        char *target = assembly.buffer.data() + qsizetype(missing) * stride;
+        std::memcpy(target, parity + Header::ParityPrefixSize, size_t(stride));
+
+        for (quint32 index = first; index < end; ++index) {
+            if (index == missing) {
+                continue;
+            }
+            const qsizetype offset = qsizetype(index) * stride;
+            const qsizetype fragmentSize = index + 1 == assembly.totalFragments ? assembly.frameSize - offset : stride;
+            size ^= quint32(fragmentSize);
+            xorInto(target, assembly.buffer.constData() + offset, fragmentSize);
+        }
+
+        if (size == 0 || size > quint32(stride)) {
+            return;     // parity inconsistent with the data, leave the gap
+        }
+        if (missing + 1 == assembly.totalFragments) {
+            assembly.frameSize = qsizetype(missing) * stride + size;
+        }
+        assembly.setFragment(missing);
+        assembly.receivedFragments++;
+        assembly.recoveredFragments++;
+        advanceContiguous(assembly);
+    }
+
+    static void xorInto(char *target, const char *source, qsizetype size)
+    {
+        qsizetype i = 0;
+        for (; i + 8 <= size; i += 8) {
+            quint64 a;
+            quint64 b;
+            std::memcpy(&a, target + i, 8);
+            std::memcpy(&b, source + i, 8);
+            a ^= b;
+            std::memcpy(target + i, &a, 8);
+        }
+        for (; i < size; ++i) {
+            target[i] ^= source[i];
+        }
+    }
+
+    std::array<Assembly, SlotCount> m_slots;
+    Header m_header;
+    qint64 m_timeoutMs;
+    quint64 m_evictedFrames = 0;
+    quint64 m_recoveredFrames = 0;
+    quint64 m_unrecoverableFrames = 0;
+    NackPolicy m_nackPolicy;
+    quint16 m_newestFrameId = 0;
+    bool m_hasNewestFrame = false;
+    quint16 m_deliveredFrameId = 0;
+    bool m_hasDeliveredFrame = false;
+    int m_reorderWindow = SlotCount / 2;
+    quint16 m_restartFrameId = 0;
+    int m_restartFragments = 0;     // consecutive fragments around m_restartFrameId
+    quint64 m_staleFragments = 0;
+    MemoryBudget m_budget;
+    qsizetype m_bytesInUse = 0;
+    qsizetype m_peakBytes = 0;
+    quint64 m_budgetEvictions = 0;
+    quint64 m_oversizedFragments = 0;
+    quint64 m_nackRequests = 0;
+    quint64 m_nackedFragments = 0;
+};
+
+#endif // FRAMEREASSEMBLER_H
@@ -0,0 +1,64 @@
+#ifndef FRAMETIMING_H
+#define FRAMETIMING_H
+
+#include <QByteArray>
+#include <QtEndian>
+#include <chrono>
+#include <cstring>
+
+// Timestamps of one video frame on its way from the sensor to the screen, in
+// microseconds since the Unix epoch, 0 for a stage the frame did not go through.
+//
+// Wall clock time is used on purpose: a sender whose clock is synchronised with the
+// ground station (NTP/PTP) can embed its capture time in the JPEG, and the glass-to-
+// glass figure then includes encoding and the first network hop.
+struct FrameTiming
+{
+    qint64 capture = 0;             // sender capture time, embedded in the JPEG
+    qint64 firstFragment = 0;       // first datagram of the frame received
+    qint64 lastFragment = 0;        // datagram completing the frame received
+    qint64 reassembled = 0;         // validated frame released to the decoder
+    qint64 decoded = 0;             // decoded image posted to the view model
+    qint64 uploaded = 0;            // texture upload recorded on the render thread
+    qint64 presented = 0;           // afterFrameEnd of the window frame showing it
+
+    static qint64 now()
+    {
+        using namespace std::chrono;
+        return duration_cast<microseconds>(system_clock::now().time_since_epoch()).count();
+    }
+
+    // Capture time embedded by the sender, 0 when the frame carries none.
+    //
+    // The sender adds an APP15 segment before the scan: FF EF, length(2) = 18,
+    // "MARSCAP\0", capture time in microseconds since the epoch (8 bytes), big endian.
+    // Decoders skip unknown APPn segments, so the frame stays a plain JPEG.
+    static qint64 captureTimestamp(const QByteArray &jpeg)
+    {
+        static constexpr char Identifier[8] = { 'M', 'A', 'R', 'S', 'C', 'A', 'P', '\0' };
+        static constexpr qsizetype SegmentLength = 2 + sizeof(Identifier) + 8;
+
+        const uchar *data = reinterpret_cast<const uchar *>(jpeg.constData());
+        const qsizetype size = jpeg.size();
+        qsizetype offset = 2;   // after SOI
+
+        while (offset + 4 <= size && data[offset] == 0xFF) {
+            const uchar marker = data[offset + 1];
+            if (marker == 0xDA || marker == 0xD9) {
+                break;      // start of scan or end of image, no more headers
+            }
+            const qsizetype length = qFromBigEndian<quint16>(data + offset + 2);
+            if (length < 2 || offset + 2 + length > size) {
+                break;
+            }
+            if (marker == 0xEF && length == SegmentLength
+                && std::memcmp(data + offset + 4, Identifier, sizeof(Identifier)) == 0) {
+                return qFromBigEndian<qint64>(data + offset + 4 + sizeof(Identifier));
+            }
+            offset += 2 + length;
+        }
+        return 0;
+    }
+};
+
+#endif // FRAMETIMING_H
@@ -0,0 +1,325 @@
+#include "ingestreactor.h"
+#include "udpbatchreceiver.h"
+#include <QByteArray>
+#include <QDebug>
+#include <QThread>
+#include <atomic>
+#include <vector>
+
+#ifdef Q_OS_LINUX
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <netinet/in.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+#endif
+
+namespace {
+
+constexpr quint64 WakeToken = ~quint64(0);     // epoll data of the shard's eventfd
+constexpr int MaxEvents = 16;
+constexpr int MaxBatchesPerWakeup = 4;
+
+}
+
+struct IngestReactor::Shard
+{
+    int epollFd = -1;
+    int wakeFd = -1;                // eventfd, signalled to stop the thread
+    QThread *thread = nullptr;
+    QMutex mutex;                   // held while dispatching, guards streams
+    QHash<int, Stream> streams;
+    std::atomic<bool> stopping{false};
+    std::atomic<quint64> wakeups{0};
+    std::atomic<quint64> datagrams{0};
+
+    // recvmmsg() buffers, reused for every stream of the shard
+    QByteArray storage;
+#ifdef Q_OS_LINUX
+    std::vector<mmsghdr> messages;
+    std::vector<iovec> iovecs;
+#endif
+};
+
+IngestReactor *IngestReactor::instance()
+{
+    static IngestReactor reactor;
+    return &reactor;
+}
+
+bool IngestReactor::isSupported()
+{
+#ifdef Q_OS_LINUX
+    return true;
+#else
+    return false;
+#endif
+}
+
+IngestReactor::IngestReactor(int threadCount, int batchSize, int maxDatagramSize)
+    : m_threadCount(qMax(1, threadCount))
+    , m_batchSize(qMax(1, batchSize))
+    , m_maxDatagramSize(maxDatagramSize)
+    , m_nextStreamId(1)
+{
+}
+
+IngestReactor::~IngestReactor()
+{
+#ifdef Q_OS_LINUX
+    for (Shard *shard : std::as_const(m_shards)) {
+        shard->stopping.store(true);
+        const quint64 one = 1;
+        ::write(shard->wakeFd, &one, sizeof(one));
+        shard->thread->wait();
+        delete shard->thread;
+
+        for (const Stream &stream : std::as_const(shard->streams)) {
+            ::close(stream.fd);
+        }
+        ::close(shard->wakeFd);
+        ::close(shard->epollFd);
+        delete shard;
+    }
+#endif
+}
+
+void IngestReactor::setThreadCount(int count)
+{
+    QMutexLocker locker(&m_mutex);
+    m_threadCount = qMax(1, count);
+}
+
+int IngestReactor::threadCount() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_threadCount;
+}
+
+IngestReactor::Shard *IngestReactor::createShard(int index, QString *error)
+{
+#ifdef Q_OS_LINUX
+    Shard *shard = new Shard;
+    shard->epollFd = ::epoll_create1(EPOLL_CLOEXEC);
+    shard->wakeFd = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    epoll_event event;
+    std::memset(&event, 0, sizeof(event));
+    event.events = EPOLLIN;
+    event.data.u64 = WakeToken;
+    if (shard->epollFd < 0 || shard->wakeFd < 0
+        || ::epoll_ctl(shard->epollFd, EPOLL_CTL_ADD, shard->wakeFd, &event) < 0) {
+        if (error) {
+            *error = QString::fromLocal8Bit(strerror(errno));
+        }
+        if (shard->wakeFd >= 0) {
+            ::close(shard->wakeFd);
+        }
+        if (shard->epollFd >= 0) {
+            ::close(shard->epollFd);
+        }
+        delete shard;
+        return nullptr;
+    }
+
+    shard->storage.resize(qsizetype(m_batchSize) * m_maxDatagramSize);
+    shard->messages.assign(size_t(m_batchSize), mmsghdr());
+    shard->iovecs.assign(size_t(m_batchSize), iovec());
+    for (int i = 0; i < m_batchSize; ++i) {
+        shard->iovecs[i].iov_base = shard->storage.data() + qsizetype(i) * m_maxDatagramSize;
+        shard->iovecs[i].iov_len = size_t(m_maxDatagramSize);
+        shard->messages[i].msg_hdr.msg_iov = &shard->iovecs[i];
+        shard->messages[i].msg_hdr.msg_iovlen = 1;
+    }
+
+    shard->thread = QThread::create([this, shard] { run(shard); });
+    shard->thread->setObjectName(QString("IngestReactor shard %1").arg(index));
+    shard->thread->start(QThread::HighPriority);
+    qDebug() << "Ingest reactor shard" << index << "started";
+    return shard;
+#else
+    Q_UNUSED(index);
+    if (error) {
+        *error = QStringLiteral("The ingest reactor is not supported on this platform");
+    }
+    return nullptr;
+#endif
+}
+
+int IngestReactor::addStream(quint16 port, const QHostAddress &multicastGroup, DatagramHandler handler,
+                             QString *error)
+{
+#ifdef Q_OS_LINUX
+    QMutexLocker locker(&m_mutex);
+
+    // Least loaded of the first m_threadCount shards, started on first use
+    Shard *target = nullptr;
+    for (int i = 0; i < m_threadCount; ++i) {
+        if (i == m_shards.size()) {
+            Shard *shard = createShard(i, error);
+            if (!shard) {
+                break;
+            }
+            m_shards.append(shard);
+        }
+        Shard *shard = m_shards.at(i);
+        QMutexLocker shardLocker(&shard->mutex);
+        if (!target || shard->streams.size() < target->streams.size()) {
+            target = shard;
+        }
+    }
+    if (!target) {
+        return -1;
+    }
+
+    const int fd = UdpBatchReceiver::openSocket(port, multicastGroup, error);
+    if (fd < 0) {
+        return -1;
+    }
+
+    const int streamId = m_nextStreamId++;
+    Stream stream;
+    stream.fd = fd;
+    stream.port = port;
+    stream.handler = std::move(handler);
+
+    QMutexLocker shardLocker(&target->mutex);
+    target->streams.insert(streamId, std::move(stream));
+
+    epoll_event event;
+    std::memset(&event, 0, sizeof(event));
+    event.events = EPOLLIN;
+    event.data.u64 = quint64(streamId);
+    if (::epoll_ctl(target->epollFd, EPOLL_CTL_ADD, fd, &event) < 0) {
+        if (error) {
+            *error = QString::fromLocal8Bit(strerror(errno));
+        }
+        target->streams.remove(streamId);
+        ::close(fd);
+        return -1;
+    }
+    m_streamShards.insert(streamId, target);
+
+    qDebug() << "Ingest reactor stream" << streamId << "bound to port" << port
+             << (multicastGroup.isNull() ? QString() : "group " + multicastGroup.toString())
+             << "on shard" << m_shards.indexOf(target);
+    return streamId;
+#else
+    Q_UNUSED(port);
+    Q_UNUSED(multicastGroup);
+    Q_UNUSED(handler);
+    if (error) {
+        *error = QStringLiteral("The ingest reactor is not supported on this platform");
+    }
+    return -1;
+#endif
+}
+
+void IngestReactor::removeStream(int streamId)
+{
+#ifdef Q_OS_LINUX
+    QMutexLocker locker(&m_mutex);
+    Shard *shard = m_streamShards.take(streamId);
+    if (!shard) {
+        return;
+    }
+
+    // The shard holds its lock while dispatching, so the handler has returned once we own it
+    QMutexLocker shardLocker(&shard->mutex);
+    const Stream stream = shard->streams.take(streamId);
+    ::epoll_ctl(shard->epollFd, EPOLL_CTL_DEL, stream.fd, nullptr);
+    ::close(stream.fd);
+#else
+    Q_UNUSED(streamId);
+#endif
+}
+
+IngestReactor::Statistics IngestReactor::statistics() const
+{
+    QMutexLocker locker(&m_mutex);
+    Statistics statistics;
+    statistics.threads = int(m_shards.size());
+    statistics.streams = int(m_streamShards.size());
+    for (const Shard *shard : m_shards) {
+        statistics.wakeups += shard->wakeups.load(std::memory_order_relaxed);
+        statistics.datagrams += shard->datagrams.load(std::memory_order_relaxed);
+    }
+    return statistics;
+}
+
+void IngestReactor::run(Shard *shard)
+{
+#ifdef Q_OS_LINUX
+    epoll_event events[MaxEvents];
+
+    while (!shard->stopping.load()) {
+        const int ready = ::epoll_wait(shard->epollFd, events, MaxEvents, -1);
+        if (ready < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            qWarning() << "Ingest reactor epoll_wait failed:" << strerror(errno);
+            break;
+        }
+        shard->wakeups.fetch_add(1, std::memory_order_relaxed);
+
+        for (int i = 0; i < ready; ++i) {
+            if (events[i].data.u64 == WakeToken) {
+                quint64 value;
+                ::read(shard->wakeFd, &value, sizeof(value));
+                continue;
+            }
+
+            QMutexLocker locker(&shard->mutex);
+            auto it = shard->streams.find(int(events[i].data.u64));
+            if (it != shard->streams.end()) {
+                drain(shard, it.value());   // removed streams are simply skipped
+            }
+        }
+    }
+#else
+    Q_UNUSED(shard);
+#endif
+}
+
+void IngestReactor::drain(Shard *shard, Stream &stream)
+{
+#ifdef Q_OS_LINUX
+    // Level triggered: whatever is left after a few batches is reported again by the
+    // next epoll_wait(), after the other ready streams had their turn
+    for (int batch = 0; batch < MaxBatchesPerWakeup; ++batch) {
+        const int received = ::recvmmsg(stream.fd, shard->messages.data(), unsigned(m_batchSize), MSG_DONTWAIT, nullptr);
+        if (received < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                qWarning() << "Ingest reactor receive on port" << stream.port << "failed:" << strerror(errno);
+            }
+            return;
+        }
+
+        for (int i = 0; i < received; ++i) {
+            const mmsghdr &message = shard->messages[size_t(i)];
+            if (message.msg_hdr.msg_flags & MSG_TRUNC) {
+                qDebug() << "Dropping truncated datagram larger than" << m_maxDatagramSize << "bytes";
+                continue;
+            }
+            if (message.msg_len > 0 && stream.handler) {
+                stream.handler(static_cast<const char *>(shard->iovecs[size_t(i)].iov_base),
+                               qsizetype(message.msg_len));
+            }
+        }
+        shard->datagrams.fetch_add(quint64(received), std::memory_order_relaxed);
+
+        if (received < m_batchSize) {
+            return;
+        }
+    }
+#else
+    Q_UNUSED(shard);
+    Q_UNUSED(stream);
+#endif
+}
@@ -0,0 +1,81 @@
+#ifndef INGESTREACTOR_H
+#define INGESTREACTOR_H
+
+#include <QHash>
+#include <QHostAddress>
+#include <QList>
+#include <QMutex>
+#include <QString>
+#include <functional>
+
+// epoll based receive loop shared by the video streams of all cameras.
+//
+// Every stream is a UDP socket registered with one shard: a thread blocked in
+// epoll_wait() on the sockets of all its streams, which drains a readable socket with
+// recvmmsg() and hands each datagram to the stream's handler on that thread. One shard
+// serves any number of streams, so adding a sensor adds a socket instead of a thread
+// with its own event loop and wakeups. With a thread count above one, new streams go
+// to the shard with the fewest streams, which spreads the ingest of busy streams over
+// several cores. A readable socket is drained a few batches at a time, so one flooded
+// stream cannot starve the others on its shard.
+//
+// Handlers run with the shard's lock held and must not add or remove streams; the
+// datagram pointer is only valid for the duration of the call. Linux only, elsewhere
+// isSupported() returns false and callers keep their per stream receivers.
+class IngestReactor
+{
+public:
+    using DatagramHandler = std::function<void(const char *data, qsizetype size)>;
+
+    struct Statistics {
+        int threads = 0;
+        int streams = 0;
+        quint64 wakeups = 0;        // epoll_wait() returns, over all shards
+        quint64 datagrams = 0;
+    };
+
+    // Process wide reactor, one thread until setThreadCount() asks for more
+    static IngestReactor *instance();
+    static bool isSupported();
+
+    explicit IngestReactor(int threadCount = 1, int batchSize = 32, int maxDatagramSize = 65536);
+    ~IngestReactor();
+
+    IngestReactor(const IngestReactor &) = delete;
+    IngestReactor &operator=(const IngestReactor &) = delete;
+
+    // Applies to streams added afterwards, running streams stay on their shard
+    void setThreadCount(int count);
+    int threadCount() const;
+
+    // Binds port, joining multicastGroup unless it is null, and dispatches its datagrams
+    // to handler; returns the stream id or -1
+    int addStream(quint16 port, const QHostAddress &multicastGroup, DatagramHandler handler,
+                  QString *error = nullptr);
+    // Blocks until the stream's handler is no longer running, then closes its socket
+    void removeStream(int streamId);
+
+    Statistics statistics() const;
+
+private:
+    struct Stream {
+        int fd = -1;
+        quint16 port = 0;
+        DatagramHandler handler;
+    };
+    struct Shard;
+
+    Shard *createShard(int index, QString *error);
+    void run(Shard *shard);
+    void drain(Shard *shard, Stream &stream);
+
+    mutable QMutex m_mutex;         // shard list and stream placement
+    QList<Shard *> m_shards;
+    QHash<int, Shard *> m_streamShards;
+    int m_threadCount;
+    int m_batchSize;
+    int m_maxDatagramSize;
+    int m_nextStreamId;
+};
+
+#endif // INGESTREACTOR_H
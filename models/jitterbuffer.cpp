@@ -0,0 +1,200 @@
+#include "jitterbuffer.h"
+#include <QtMath>
+#include "fragmentprotocol.h"
+
+namespace {
+// A clock offset larger than this is treated as a stream restart, like an id jump
+constexpr double MaxClockSkewMs = 1000.0;
+}
+
+JitterBuffer::JitterBuffer(int capacity)
+    : m_capacity(capacity)
+    , m_mode(Mode::LowestLatency)
+    , m_maxDelayMs(200)
+{
+    clear();
+}
+
+void JitterBuffer::clear()
+{
+    m_frames.clear();
+    resetClock();
+    m_hasReleased = false;
+    m_lastReleasedId = 0;
+    m_lateDrops = 0;
+    m_overflowReleases = 0;
+}
+
+void JitterBuffer::resetClock()
+{
+    m_hasClock = false;
+    m_anchorId = 0;
+    m_anchorTime = 0.0;
+    m_frameInterval = 0.0;
+    m_jitter = 0.0;
+    m_hasPrevious = false;
+    m_previousId = 0;
+    m_previousArrival = 0;
+}
+
+qint64 JitterBuffer::targetDelay() const
+{
+    double target = 0.0;
+    switch (m_mode) {
+    case Mode::LowestLatency:
+        return 0;
+    case Mode::Balanced:
+        target = 2.0 * m_jitter;
+        break;
+    case Mode::Smooth:
+        target = 4.0 * m_jitter + m_frameInterval;
+        break;
+    }
+    return qMin(m_maxDelayMs, qint64(qCeil(target)));
+}
+
+bool JitterBuffer::push(Frame frame, qint64 now)
+{
+    if (m_hasReleased) {
+        const int distance = FrameIdSequence::distance(frame.frameId, m_lastReleasedId);
+        if (distance <= 0 && distance > -FrameIdSequence::MaxJump) {
+            m_lateDrops++;
+            return false;
+        }
+        if (FrameIdSequence::isRestart(frame.frameId, m_lastReleasedId)) {
+            // The sender restarted its frame counter, start over
+            m_hasReleased = false;
+            resetClock();
+        }
+    }
+
+    updateClock(frame.frameId, frame.arrivalTime);
+
+    qsizetype position = m_frames.size();
+    while (position > 0) {
+        const int distance = FrameIdSequence::distance(frame.frameId, m_frames.at(position - 1).frame.frameId);
+        if (distance == 0) {
+            return false;
+        }
+        if (distance > 0) {
+            break;
+        }
+        position--;
+    }
+
+    Entry entry;
+    entry.dueTime = dueTime(frame.frameId, frame.arrivalTime);
+    entry.frame = std::move(frame);
+    m_frames.insert(position, std::move(entry));
+
+    // Too many frames held back, release the oldest right away
+    if (m_frames.size() > m_capacity) {
+        m_frames.first().dueTime = now;
+        m_overflowReleases++;
+    }
+    return true;
+}
+
+bool JitterBuffer::pop(qint64 now, Frame *frame)
+{
+    if (m_frames.isEmpty()) {
+        return false;
+    }
+
+    // Due times follow frame ids except where the maxDelay cap kicks in, so release the
+    // oldest frame as soon as any queued frame is due to keep the output in order
+    bool due = false;
+    for (const Entry &entry : m_frames) {
+        if (entry.dueTime <= now) {
+            due = true;
+            break;
+        }
+    }
+    if (!due) {
+        return false;
+    }
+
+    *frame = std::move(m_frames.first().frame);
+    m_frames.removeFirst();
+    m_hasReleased = true;
+    m_lastReleasedId = frame->frameId;
+    return true;
+}
+
+qint64 JitterBuffer::nextDueIn(qint64 now) const
+{
+    if (m_frames.isEmpty()) {
+        return -1;
+    }
+    qint64 next = m_frames.first().dueTime;
+    for (const Entry &entry : m_frames) {
+        next = qMin(next, entry.dueTime);
+    }
+    return qMax<qint64>(0, next - now);
+}
+
+void JitterBuffer::updateClock(quint16 frameId, qint64 arrivalTime)
+{
+    // Inter-arrival jitter: deviation of the arrival spacing from the frame spacing
+    if (m_hasPrevious) {
+        const int idStep = FrameIdSequence::distance(frameId, m_previousId);
+        const double arrivalStep = double(arrivalTime - m_previousArrival);
+        if (idStep > 0 && idStep <= 4) {
+            const double interval = arrivalStep / idStep;
+            if (m_frameInterval <= 0.0) {
+                m_frameInterval = interval;
+            } else {
+                m_frameInterval += (interval - m_frameInterval) / 16.0;
+            }
+        }
+        if (m_frameInterval > 0.0 && qAbs(idStep) < FrameIdSequence::MaxJump) {
+            const double deviation = qAbs(arrivalStep - idStep * m_frameInterval);
+            m_jitter += (qMin(deviation, MaxClockSkewMs) - m_jitter) / 16.0;
+        }
+    }
+    if (!m_hasPrevious || FrameIdSequence::distance(frameId, m_previousId) > 0) {
+        m_previousId = frameId;
+        m_previousArrival = arrivalTime;
+        m_hasPrevious = true;
+    }
+
+    if (!m_hasClock) {
+        m_anchorId = frameId;
+        m_anchorTime = double(arrivalTime);
+        m_hasClock = true;
+        return;
+    }
+
+    const int distance = FrameIdSequence::distance(frameId, m_anchorId);
+    const double expected = m_anchorTime + distance * m_frameInterval;
+    const double offset = double(arrivalTime) - expected;
+    if (qAbs(distance) >= FrameIdSequence::MaxJump || qAbs(offset) > MaxClockSkewMs) {
+        m_anchorId = frameId;
+        m_anchorTime = double(arrivalTime);
+        return;
+    }
+
+    // Follow the earliest arrivals immediately and drift slowly towards later ones,
+    // so the clock tracks the fast path and absorbs small interval estimate errors
+    if (offset < 0.0) {
+        m_anchorTime += offset;
+    } else {
+        m_anchorTime += offset / 32.0;
+    }
+
+    // Keep the anchor close to the newest frame so id distances never wrap
+    if (distance > 0) {
+        m_anchorTime += distance * m_frameInterval;
+        m_anchorId = frameId;
+    }
+}
+
+qint64 JitterBuffer::dueTime(quint16 frameId, qint64 arrivalTime) const
+{
+    if (m_mode == Mode::LowestLatency || m_frameInterval <= 0.0) {
+        return arrivalTime + targetDelay();
+    }
+    const double expected = m_anchorTime + FrameIdSequence::distance(frameId, m_anchorId) * m_frameInterval;
+    const qint64 due = qint64(qCeil(expected)) + targetDelay();
+    return qBound(arrivalTime, due, arrivalTime + m_maxDelayMs);
+}
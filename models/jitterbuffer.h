@@ -0,0 +1,91 @@
+#ifndef JITTERBUFFER_H
+#define JITTERBUFFER_H
+
+#include <QByteArray>
+#include <QList>
+#include "frametiming.h"
+
+// Playout stage between the reassembler and the display.
+//
+// Frames are released in frame id order. Each frame is scheduled against a playout
+// clock that maps frame ids to their expected arrival time: the clock is anchored on
+// the earliest arrivals seen and advances one estimated frame interval per id, so a
+// frame that arrives late or out of order is still released at its regular slot plus
+// the target delay. The target delay follows the measured inter-arrival jitter
+// (RFC 3550 style estimator) scaled by the selected mode and capped by maxDelay.
+// A frame whose id is not newer than the last released one is dropped as late.
+class JitterBuffer
+{
+public:
+    enum class Mode {
+        LowestLatency,  // release on arrival, only late frames are dropped
+        Balanced,       // absorb typical jitter
+        Smooth          // absorb jitter peaks, trades latency for even pacing
+    };
+
+    struct Frame {
+        QByteArray data;
+        quint16 frameId = 0;
+        qint64 arrivalTime = 0;
+        FrameTiming timing;     // carried through untouched
+    };
+
+    explicit JitterBuffer(int capacity = 16);
+
+    void setMode(Mode mode) { m_mode = mode; }
+    Mode mode() const { return m_mode; }
+
+    // Upper bound of the target delay in milliseconds
+    void setMaxDelay(qint64 maxDelayMs) { m_maxDelayMs = qMax<qint64>(0, maxDelayMs); }
+    qint64 maxDelay() const { return m_maxDelayMs; }
+
+    // Queues a frame, returns false if it was dropped as late or duplicate
+    bool push(Frame frame, qint64 now);
+
+    // Takes the next frame if it is due at now
+    bool pop(qint64 now, Frame *frame);
+
+    // Milliseconds until the next frame is due, -1 when empty
+    qint64 nextDueIn(qint64 now) const;
+
+    void clear();
+
+    int occupancy() const { return int(m_frames.size()); }
+    quint64 lateDrops() const { return m_lateDrops; }
+    quint64 overflowReleases() const { return m_overflowReleases; }   // frames released early, buffer full
+    qint64 targetDelay() const;
+    double jitter() const { return m_jitter; }
+    double frameInterval() const { return m_frameInterval; }
+
+private:
+    struct Entry {
+        Frame frame;
+        qint64 dueTime = 0;
+    };
+
+    void updateClock(quint16 frameId, qint64 arrivalTime);
+    qint64 dueTime(quint16 frameId, qint64 arrivalTime) const;
+    void resetClock();
+
+    QList<Entry> m_frames;          // ordered by frame id
+    int m_capacity;
+    Mode m_mode;
+    qint64 m_maxDelayMs;
+
+    // Playout clock
+    bool m_hasClock;
+    quint16 m_anchorId;
+    double m_anchorTime;
+    double m_frameInterval;         // estimated ms between consecutive frame ids
+    double m_jitter;                // smoothed inter-arrival deviation in ms
+    bool m_hasPrevious;
+    quint16 m_previousId;
+    qint64 m_previousArrival;
+
+    bool m_hasReleased;
+    quint16 m_lastReleasedId;
+    quint64 m_lateDrops;
+    quint64 m_overflowReleases;
+};
+
+#endif // JITTERBUFFER_H
@@ -0,0 +1,109 @@
+#include "latencystatistics.h"
+#include <algorithm>
+
+namespace {
+
+double percentile(const std::vector<qint64> &sorted, double fraction)
+{
+    const size_t index = qMin(sorted.size() - 1, size_t(fraction * double(sorted.size())));
+    return sorted[index] / 1000.0;
+}
+
+}
+
+QString LatencyStatistics::stageName(Stage stage)
+{
+    switch (stage) {
+    case Sender:
+        return "Sender";
+    case Transfer:
+        return "Transfer";
+    case Playout:
+        return "Playout";
+    case Decode:
+        return "Decode";
+    case Handoff:
+        return "Handoff";
+    case Present:
+        return "Present";
+    case Total:
+        return "Total";
+    case StageCount:
+        break;
+    }
+    return QString();
+}
+
+void LatencyStatistics::record(const FrameTiming &timing, quint64 serial)
+{
+    QMutexLocker locker(&m_mutex);
+    if (serial <= m_lastSerial) {
+        return;
+    }
+    m_lastSerial = serial;
+
+    add(Sender, timing.capture, timing.firstFragment);
+    add(Transfer, timing.firstFragment, timing.lastFragment);
+    add(Playout, timing.lastFragment, timing.reassembled);
+    add(Decode, timing.reassembled, timing.decoded);
+    add(Handoff, timing.decoded, timing.uploaded);
+    add(Present, timing.uploaded, timing.presented);
+    add(Total, timing.capture ? timing.capture : timing.firstFragment, timing.presented);
+
+    if (timing.capture) {
+        m_hasCaptureTime = true;
+    }
+}
+
+void LatencyStatistics::add(Stage stage, qint64 from, qint64 to)
+{
+    if (from == 0 || to == 0) {
+        return;
+    }
+
+    // Clock steps and unsynchronised senders can make a stage negative, clamp it
+    Window &window = m_windows[stage];
+    const qint64 sample = qMax<qint64>(0, to - from);
+    if (int(window.samples.size()) < WindowSize) {
+        window.samples.push_back(sample);
+    } else {
+        window.samples[window.next] = sample;
+    }
+    window.next = (window.next + 1) % WindowSize;
+}
+
+std::array<LatencyStatistics::Percentiles, LatencyStatistics::StageCount> LatencyStatistics::snapshot() const
+{
+    std::array<Percentiles, StageCount> result;
+
+    QMutexLocker locker(&m_mutex);
+    for (int stage = 0; stage < StageCount; ++stage) {
+        std::vector<qint64> sorted = m_windows[stage].samples;
+        if (sorted.empty()) {
+            continue;
+        }
+        std::sort(sorted.begin(), sorted.end());
+        result[stage].p50 = percentile(sorted, 0.50);
+        result[stage].p95 = percentile(sorted, 0.95);
+        result[stage].p99 = percentile(sorted, 0.99);
+        result[stage].samples = int(sorted.size());
+    }
+    return result;
+}
+
+bool LatencyStatistics::hasCaptureTime() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_hasCaptureTime;
+}
+
+void LatencyStatistics::clear()
+{
+    QMutexLocker locker(&m_mutex);
+    for (Window &window : m_windows) {
+        window.samples.clear();
+        window.next = 0;
+    }
+    m_lastSerial = 0;
+    m_hasCaptureTime = false;
+}
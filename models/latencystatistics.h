@@ -0,0 +1,68 @@
+#ifndef LATENCYSTATISTICS_H
+#define LATENCYSTATISTICS_H
+
+#include <QList>
+#include <QMutex>
+#include <QString>
+#include <array>
+#include <vector>
+#include "frametiming.h"
+
+// Rolling latency percentiles of one video stream, per pipeline stage.
+//
+// Every presented frame contributes the time spent between consecutive FrameTiming
+// stamps; stages a frame skipped (no sender capture time, or a QVideoSink instead of a
+// VideoSurface) are left out for that frame. Each stage keeps its last WindowSize
+// samples and percentiles are computed over that window when a snapshot is taken, so
+// recording stays cheap enough for the render thread. Thread safe.
+class LatencyStatistics
+{
+public:
+    enum Stage {
+        Sender,         // capture -> first fragment, encoding and network
+        Transfer,       // first -> last fragment
+        Playout,        // last fragment -> released to the decoder, validation and jitter buffer
+        Decode,         // released -> decoded, decoder queue and decode
+        Handoff,        // decoded -> texture upload, GUI handoff and scene graph sync
+        Present,        // texture upload -> end of the window frame
+        Total,          // capture (or first fragment) -> presented
+        StageCount
+    };
+
+    struct Percentiles {
+        double p50 = 0.0;   // milliseconds
+        double p95 = 0.0;
+        double p99 = 0.0;
+        int samples = 0;
+    };
+
+    static constexpr int WindowSize = 300;
+
+    static QString stageName(Stage stage);
+
+    // Adds the stages of a presented frame. serial identifies the frame, a frame shown
+    // by several surfaces is only counted once.
+    void record(const FrameTiming &timing, quint64 serial);
+
+    std::array<Percentiles, StageCount> snapshot() const;
+
+    // True once a frame carrying a sender capture time was recorded
+    bool hasCaptureTime() const;
+
+    void clear();
+
+private:
+    struct Window {
+        std::vector<qint64> samples;    // microseconds, ring of WindowSize
+        int next = 0;
+    };
+
+    void add(Stage stage, qint64 from, qint64 to);
+
+    mutable QMutex m_mutex;
+    std::array<Window, StageCount> m_windows;
+    quint64 m_lastSerial = 0;
+    bool m_hasCaptureTime = false;
+};
+
+#endif // LATENCYSTATISTICS_H
@@ -0,0 +1,108 @@
+#ifndef LATESTFRAMEMAILBOX_H
+#define LATESTFRAMEMAILBOX_H
+
+#include <QByteArray>
+#include <QImage>
+#include <QVideoFrame>
+#include <atomic>
+#include "frametiming.h"
+
+// Single slot, lock-free handoff of frames between threads: complete JPEG frames from
+// the ingest thread to the decoder, decoded images from the decoder to the GUI.
+//
+// The producer swaps its frame into the slot, the consumer swaps the slot out, so only
+// the newest frame is ever kept. A complete frame replaced before the consumer got to
+// it is counted as dropped; a partial frame is only a preview and is replaced freely.
+// post() reports when the slot went from empty to full: that is the only time the
+// consumer needs a wake-up, so a stalled GUI thread has at most one pending
+// notification per mailbox instead of a queue of frames.
+//
+// A partial frame never replaces a complete frame still waiting in the slot: the top
+// rows of the next frame would hide a finished one. The slot tags partial frames in the
+// low bit of the pointer, so the check and the swap are one compare-exchange.
+class LatestFrameMailbox
+{
+public:
+    struct Frame {
+        QByteArray data;    // encoded frame
+        QImage image;       // decoded frame, null until decoded
+        QVideoFrame videoFrame;     // decoded frame when the decoder feeds a QVideoSink
+        quint16 frameId = 0;
+        FrameTiming timing;
+
+        // Partial frame: only the top partialRows of partialHeight rows (full resolution)
+        // come from this frame, the decoder keeps the previous frame's rows below them
+        int partialRows = -1;
+        int partialHeight = 0;
+
+        bool isPartial() const { return partialRows >= 0; }
+    };
+
+    LatestFrameMailbox() = default;
+    LatestFrameMailbox(const LatestFrameMailbox &) = delete;
+    LatestFrameMailbox &operator=(const LatestFrameMailbox &) = delete;
+
+    ~LatestFrameMailbox()
+    {
+        delete untag(m_slot.exchange(0));
+    }
+
+    // Producer side. Returns true when the consumer has to be woken up.
+    bool post(const QByteArray &data, quint16 frameId, const FrameTiming &timing = FrameTiming())
+    {
+        Frame frame;
+        frame.data = data;
+        frame.frameId = frameId;
+        frame.timing = timing;
+        return post(std::move(frame));
+    }
+
+    bool post(Frame &&value)
+    {
+        const bool partial = value.isPartial();
+        Frame *frame = new Frame(std::move(value));
+        const quintptr tagged = quintptr(frame) | (partial ? PartialTag : 0);
+
+        quintptr previous = m_slot.load(std::memory_order_acquire);
+        do {
+            if (partial && previous && !(previous & PartialTag)) {
+                delete frame;   // not dropped, it was never shown in place of anything
+                return false;
+            }
+        } while (!m_slot.compare_exchange_weak(previous, tagged, std::memory_order_acq_rel,
+                                               std::memory_order_acquire));
+        if (previous) {
+            delete untag(previous);
+            if (!(previous & PartialTag)) {
+                m_droppedFrames.fetch_add(1, std::memory_order_relaxed);
+            }
+            return false;
+        }
+        return true;
+    }
+
+    // Consumer side. Takes the newest frame, returns false when there is none.
+    bool take(Frame *frame)
+    {
+        Frame *latest = untag(m_slot.exchange(0, std::memory_order_acq_rel));
+        if (!latest) {
+            return false;
+        }
+        *frame = std::move(*latest);
+        delete latest;
+        return true;
+    }
+
+    quint64 droppedFrames() const { return m_droppedFrames.load(std::memory_order_relaxed); }
+
+private:
+    static constexpr quintptr PartialTag = 1;
+    static_assert(alignof(Frame) > 1, "the low pointer bit tags partial frames");
+
+    static Frame *untag(quintptr slot) { return reinterpret_cast<Frame *>(slot & ~PartialTag); }
+
+    std::atomic<quintptr> m_slot{0};
+    std::atomic<quint64> m_droppedFrames{0};
+};
+
+#endif // LATESTFRAMEMAILBOX_H
@@ -0,0 +1,175 @@
+#ifndef LINKSTATISTICS_H
+#define LINKSTATISTICS_H
+
+#include <QtGlobal>
+#include <atomic>
+#include "fragmentprotocol.h"
+
+// Quality counters of one video link, written by the camera model and read by the GUI.
+//
+// The model writes from the ingest thread (an IngestReactor shard or its own thread)
+// and from its cleanup timer, always under its buffer mutex or once ingest has stopped,
+// so there is one writer at a time and the mutex orders the writes. Every counter is
+// therefore a relaxed atomic that is loaded and stored rather than incremented with a
+// locked read-modify-write; readers take a snapshot() at any time and derive rates
+// from two snapshots. A data fragment is out of order when it arrives after one that
+// comes later in (frame id, fragment index) order. Late fragments belong to a frame
+// the reassembler already gave up on as Stale.
+// The jitter is the RFC 3550 style smoothed deviation of frame inter-arrival times,
+// taken at the first fragment of every new frame.
+class LinkStatistics
+{
+public:
+    struct Snapshot {
+        quint64 fragments = 0;
+        quint64 bytes = 0;
+        quint64 duplicates = 0;
+        quint64 outOfOrder = 0;
+        quint64 malformed = 0;
+        quint64 late = 0;
+        quint64 framesCompleted = 0;
+        quint64 framesExpired = 0;
+        double jitterMs = 0.0;
+    };
+
+    struct Rates {
+        double fragmentsPerSecond = 0.0;
+        double bytesPerSecond = 0.0;
+        double framesPerSecond = 0.0;
+        double duplicatesPerSecond = 0.0;
+        double outOfOrderPerSecond = 0.0;
+        double malformedPerSecond = 0.0;
+        double latePerSecond = 0.0;
+        double expiredPerSecond = 0.0;
+    };
+
+    LinkStatistics() = default;
+    LinkStatistics(const LinkStatistics &) = delete;
+    LinkStatistics &operator=(const LinkStatistics &) = delete;
+
+    // Writer side, one writer at a time
+
+    // Every datagram received on the video port, before it is parsed
+    void recordDatagram(qsizetype size)
+    {
+        bump(m_fragments);
+        m_bytes.store(m_bytes.load(std::memory_order_relaxed) + quint64(size), std::memory_order_relaxed);
+    }
+
+    // A fragment whose header parsed, arrived at now (ms). Parity fragments are sent
+    // after their group and do not take part in the ordering.
+    void recordFragment(const FragmentHeader &header, qint64 now)
+    {
+        if (header.isParity()) {
+            return;
+        }
+
+        const quint32 index = header.fragmentIndex;
+        if (m_hasPrevious) {
+            const int frameDistance = FrameIdSequence::distance(header.frameId, m_previousFrameId);
+            if (frameDistance < 0 || (frameDistance == 0 && index < m_previousIndex)) {
+                bump(m_outOfOrder);
+            }
+            if (frameDistance > 0) {
+                updateJitter(now);
+            }
+        } else {
+            m_previousFrameStart = now;
+        }
+        if (!m_hasPrevious || FrameIdSequence::distance(header.frameId, m_previousFrameId) >= 0) {
+            m_hasPrevious = true;
+            m_previousFrameId = header.frameId;
+            m_previousIndex = index;
+        }
+    }
+
+    void recordDuplicate() { bump(m_duplicates); }
+    void recordMalformed() { bump(m_malformed); }
+    void recordLate() { bump(m_late); }
+    void recordCompleted() { bump(m_framesCompleted); }
+    void recordExpired(int frames)
+    {
+        m_framesExpired.store(m_framesExpired.load(std::memory_order_relaxed) + quint64(frames),
+                              std::memory_order_relaxed);
+    }
+
+    // Stream restarted, the ordering and jitter state start over; counters are kept
+    void resetSequence()
+    {
+        m_hasPrevious = false;
+        m_previousInterval = 0.0;
+    }
+
+    // Any thread
+
+    Snapshot snapshot() const
+    {
+        Snapshot snapshot;
+        snapshot.fragments = m_fragments.load(std::memory_order_relaxed);
+        snapshot.bytes = m_bytes.load(std::memory_order_relaxed);
+        snapshot.duplicates = m_duplicates.load(std::memory_order_relaxed);
+        snapshot.outOfOrder = m_outOfOrder.load(std::memory_order_relaxed);
+        snapshot.malformed = m_malformed.load(std::memory_order_relaxed);
+        snapshot.late = m_late.load(std::memory_order_relaxed);
+        snapshot.framesCompleted = m_framesCompleted.load(std::memory_order_relaxed);
+        snapshot.framesExpired = m_framesExpired.load(std::memory_order_relaxed);
+        snapshot.jitterMs = m_jitterUs.load(std::memory_order_relaxed) / 1000.0;
+        return snapshot;
+    }
+
+    static Rates rates(const Snapshot &previous, const Snapshot &current, qint64 elapsedMs)
+    {
+        Rates rates;
+        if (elapsedMs <= 0) {
+            return rates;
+        }
+        const double seconds = elapsedMs / 1000.0;
+        rates.fragmentsPerSecond = (current.fragments - previous.fragments) / seconds;
+        rates.bytesPerSecond = (current.bytes - previous.bytes) / seconds;
+        rates.framesPerSecond = (current.framesCompleted - previous.framesCompleted) / seconds;
+        rates.duplicatesPerSecond = (current.duplicates - previous.duplicates) / seconds;
+        rates.outOfOrderPerSecond = (current.outOfOrder - previous.outOfOrder) / seconds;
+        rates.malformedPerSecond = (current.malformed - previous.malformed) / seconds;
+        rates.latePerSecond = (current.late - previous.late) / seconds;
+        rates.expiredPerSecond = (current.framesExpired - previous.framesExpired) / seconds;
+        return rates;
+    }
+
+private:
+    static void bump(std::atomic<quint64> &counter)
+    {
+        counter.store(counter.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+
+    void updateJitter(qint64 now)
+    {
+        const double interval = double(now - m_previousFrameStart);
+        m_previousFrameStart = now;
+        if (m_previousInterval > 0.0) {
+            const double deviation = qAbs(interval - m_previousInterval);
+            m_jitter += (deviation - m_jitter) / 16.0;
+            m_jitterUs.store(qint64(m_jitter * 1000.0), std::memory_order_relaxed);
+        }
+        m_previousInterval = interval;
+    }
+
+    std::atomic<quint64> m_fragments{0};
+    std::atomic<quint64> m_bytes{0};
+    std::atomic<quint64> m_duplicates{0};
+    std::atomic<quint64> m_outOfOrder{0};
+    std::atomic<quint64> m_malformed{0};
+    std::atomic<quint64> m_late{0};
+    std::atomic<quint64> m_framesCompleted{0};
+    std::atomic<quint64> m_framesExpired{0};
+    std::atomic<qint64> m_jitterUs{0};
+
+    // Ingest thread only
+    bool m_hasPrevious = false;
+    quint16 m_previousFrameId = 0;
+    quint32 m_previousIndex = 0;
+    qint64 m_previousFrameStart = 0;
+    double m_previousInterval = 0.0;
+    double m_jitter = 0.0;
+};
+
+#endif // LINKSTATISTICS_H
@@ -0,0 +1,247 @@
+#include "matroskawriter.h"
+#include <QtEndian>
+
+namespace {
+
+// EBML element ids used by the writer
+constexpr quint32 EbmlHeader = 0x1A45DFA3;
+constexpr quint32 EbmlVersion = 0x4286;
+constexpr quint32 EbmlReadVersion = 0x42F7;
+constexpr quint32 EbmlMaxIdLength = 0x42F2;
+constexpr quint32 EbmlMaxSizeLength = 0x42F3;
+constexpr quint32 DocType = 0x4282;
+constexpr quint32 DocTypeVersion = 0x4287;
+constexpr quint32 DocTypeReadVersion = 0x4285;
+constexpr quint32 Segment = 0x18538067;
+constexpr quint32 Info = 0x1549A966;
+constexpr quint32 TimestampScale = 0x2AD7B1;
+constexpr quint32 MuxingApp = 0x4D80;
+constexpr quint32 WritingApp = 0x5741;
+constexpr quint32 Tracks = 0x1654AE6B;
+constexpr quint32 TrackEntry = 0xAE;
+constexpr quint32 TrackNumber = 0xD7;
+constexpr quint32 TrackUid = 0x73C5;
+constexpr quint32 TrackType = 0x83;
+constexpr quint32 FlagLacing = 0x9C;
+constexpr quint32 CodecId = 0x86;
+constexpr quint32 Video = 0xE0;
+constexpr quint32 PixelWidth = 0xB0;
+constexpr quint32 PixelHeight = 0xBA;
+constexpr quint32 Cluster = 0x1F43B675;
+constexpr quint32 ClusterTimestamp = 0xE7;
+constexpr quint32 SimpleBlock = 0xA3;
+
+constexpr qint64 MaxClusterDurationMs = 1000;
+constexpr qsizetype MaxClusterBytes = 8 * 1024 * 1024;
+
+void appendId(QByteArray *out, quint32 id)
+{
+    int bytes = 4;
+    while (bytes > 1 && (id >> ((bytes - 1) * 8)) == 0) {
+        bytes--;
+    }
+    for (int i = bytes - 1; i >= 0; --i) {
+        out->append(char((id >> (i * 8)) & 0xFF));
+    }
+}
+
+// EBML variable length size, shortest encoding unless a width is forced
+void appendSize(QByteArray *out, quint64 size, int width = 0)
+{
+    if (width == 0) {
+        width = 1;
+        while (width < 8 && size >= (quint64(1) << (7 * width)) - 1) {
+            width++;
+        }
+    }
+    const quint64 value = size | (quint64(1) << (7 * width));
+    for (int i = width - 1; i >= 0; --i) {
+        out->append(char((value >> (i * 8)) & 0xFF));
+    }
+}
+
+void appendElement(QByteArray *out, quint32 id, const QByteArray &payload)
+{
+    appendId(out, id);
+    appendSize(out, quint64(payload.size()));
+    out->append(payload);
+}
+
+void appendUInt(QByteArray *out, quint32 id, quint64 value)
+{
+    QByteArray payload;
+    int bytes = 8;
+    while (bytes > 1 && (value >> ((bytes - 1) * 8)) == 0) {
+        bytes--;
+    }
+    for (int i = bytes - 1; i >= 0; --i) {
+        payload.append(char((value >> (i * 8)) & 0xFF));
+    }
+    appendElement(out, id, payload);
+}
+
+}
+
+MatroskaWriter::~MatroskaWriter()
+{
+    close();
+}
+
+QSize MatroskaWriter::jpegSize(const QByteArray &jpeg)
+{
+    const uchar *data = reinterpret_cast<const uchar *>(jpeg.constData());
+    const qsizetype size = jpeg.size();
+    qsizetype offset = 2;   // after SOI
+
+    while (offset + 4 <= size && data[offset] == 0xFF) {
+        const uchar marker = data[offset + 1];
+        const qsizetype length = qFromBigEndian<quint16>(data + offset + 2);
+        // SOF0..SOF15, except DHT (C4), JPG (C8) and DAC (CC)
+        if (marker >= 0xC0 && marker <= 0xCF && marker != 0xC4 && marker != 0xC8 && marker != 0xCC) {
+            if (offset + 9 > size) {
+                break;
+            }
+            return QSize(qFromBigEndian<quint16>(data + offset + 7), qFromBigEndian<quint16>(data + offset + 5));
+        }
+        if (marker == 0xDA || length < 2) {
+            break;
+        }
+        offset += 2 + length;
+    }
+    return QSize();
+}
+
+bool MatroskaWriter::open(const QString &filePath, const QSize &frameSize)
+{
+    close();
+
+    m_file.setFileName(filePath);
+    if (!m_file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        return false;
+    }
+
+    QByteArray ebml;
+    appendUInt(&ebml, EbmlVersion, 1);
+    appendUInt(&ebml, EbmlReadVersion, 1);
+    appendUInt(&ebml, EbmlMaxIdLength, 4);
+    appendUInt(&ebml, EbmlMaxSizeLength, 8);
+    appendElement(&ebml, DocType, "matroska");
+    appendUInt(&ebml, DocTypeVersion, 4);
+    appendUInt(&ebml, DocTypeReadVersion, 2);
+
+    QByteArray header;
+    appendElement(&header, EbmlHeader, ebml);
+
+    // Segment of unknown size until close()
+    appendId(&header, Segment);
+    m_segmentSizePosition = header.size();
+    header.append(QByteArray::fromHex("01FFFFFFFFFFFFFF"));
+    m_segmentDataStart = header.size();
+
+    QByteArray info;
+    appendUInt(&info, TimestampScale, 1000000);     // timestamps in milliseconds
+    appendElement(&info, MuxingApp, "MARS ground station");
+    appendElement(&info, WritingApp, "MARS ground station");
+    appendElement(&header, Info, info);
+
+    QByteArray video;
+    appendUInt(&video, PixelWidth, quint64(qMax(1, frameSize.width())));
+    appendUInt(&video, PixelHeight, quint64(qMax(1, frameSize.height())));
+
+    QByteArray track;
+    appendUInt(&track, TrackNumber, 1);
+    appendUInt(&track, TrackUid, 1);
+    appendUInt(&track, TrackType, 1);   // video
+    appendUInt(&track, FlagLacing, 0);
+    appendElement(&track, CodecId, "V_MJPEG");
+    appendElement(&track, Video, video);
+
+    QByteArray tracks;
+    appendElement(&tracks, TrackEntry, track);
+    appendElement(&header, Tracks, tracks);
+
+    if (m_file.write(header) != header.size()) {
+        m_file.close();
+        return false;
+    }
+
+    m_firstTimestampUs = -1;
+    m_clusterTimestampMs = 0;
+    m_cluster.clear();
+    m_framesWritten = 0;
+    return true;
+}
+
+bool MatroskaWriter::writeFrame(const QByteArray &jpeg, qint64 timestampUs)
+{
+    if (!m_file.isOpen()) {
+        return false;
+    }
+
+    if (m_firstTimestampUs < 0) {
+        m_firstTimestampUs = timestampUs;
+    }
+    // Timestamps never go backwards within the file, a clock step reuses the last one
+    qint64 timestampMs = qMax<qint64>(0, (timestampUs - m_firstTimestampUs) / 1000);
+
+    if (!m_cluster.isEmpty()) {
+        timestampMs = qMax(timestampMs, m_clusterTimestampMs);
+        if (timestampMs - m_clusterTimestampMs >= MaxClusterDurationMs || m_cluster.size() >= MaxClusterBytes) {
+            if (!flushCluster()) {
+                return false;
+            }
+        }
+    }
+    if (m_cluster.isEmpty()) {
+        m_clusterTimestampMs = timestampMs;
+    }
+
+    const qint16 relative = qint16(timestampMs - m_clusterTimestampMs);
+    appendId(&m_cluster, SimpleBlock);
+    appendSize(&m_cluster, quint64(4 + jpeg.size()));
+    m_cluster.append(char(0x81));                   // track number 1
+    m_cluster.append(char((relative >> 8) & 0xFF));
+    m_cluster.append(char(relative & 0xFF));
+    m_cluster.append(char(0x80));                   // keyframe
+    m_cluster.append(jpeg);
+    m_framesWritten++;
+    return true;
+}
+
+bool MatroskaWriter::flushCluster()
+{
+    if (m_cluster.isEmpty()) {
+        return true;
+    }
+
+    QByteArray body;
+    appendUInt(&body, ClusterTimestamp, quint64(m_clusterTimestampMs));
+
+    QByteArray header;
+    appendId(&header, Cluster);
+    appendSize(&header, quint64(body.size() + m_cluster.size()));
+
+    const bool written = m_file.write(header) == header.size()
+                         && m_file.write(body) == body.size()
+                         && m_file.write(m_cluster) == m_cluster.size();
+    m_cluster.clear();
+    return written;
+}
+
+void MatroskaWriter::close()
+{
+    if (!m_file.isOpen()) {
+        return;
+    }
+
+    flushCluster();
+
+    // Patch the segment size now that it is known
+    const qint64 segmentSize = m_file.pos() - m_segmentDataStart;
+    QByteArray size;
+    appendSize(&size, quint64(segmentSize), 8);
+    if (m_file.seek(m_segmentSizePosition)) {
+        m_file.write(size);
+    }
+    m_file.close();
+}
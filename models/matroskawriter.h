@@ -0,0 +1,49 @@
+#ifndef MATROSKAWRITER_H
+#define MATROSKAWRITER_H
+
+#include <QByteArray>
+#include <QFile>
+#include <QSize>
+#include <QString>
+
+// Writes JPEG frames unchanged into a Matroska file with one V_MJPEG video track.
+//
+// Every frame becomes a keyframe SimpleBlock carrying its own timestamp (millisecond
+// resolution, relative to the first frame), so a variable frame rate stream plays back
+// with its original timing. Clusters are buffered in memory and written whole, at most
+// one second or 8 MB each; the segment size is patched in close(), and a file cut short
+// by a crash is still readable up to its last complete cluster.
+class MatroskaWriter
+{
+public:
+    MatroskaWriter() = default;
+    ~MatroskaWriter();
+
+    MatroskaWriter(const MatroskaWriter &) = delete;
+    MatroskaWriter &operator=(const MatroskaWriter &) = delete;
+
+    // Creates the file and writes the headers, frameSize is the track's display size
+    bool open(const QString &filePath, const QSize &frameSize);
+    bool writeFrame(const QByteArray &jpeg, qint64 timestampUs);
+    void close();
+
+    bool isOpen() const { return m_file.isOpen(); }
+    QString errorString() const { return m_file.errorString(); }
+    quint64 framesWritten() const { return m_framesWritten; }
+
+    // Pixel size from the JPEG's SOF header, invalid if there is none
+    static QSize jpegSize(const QByteArray &jpeg);
+
+private:
+    bool flushCluster();
+
+    QFile m_file;
+    qint64 m_segmentSizePosition = 0;   // offset of the 8 byte segment size
+    qint64 m_segmentDataStart = 0;
+    qint64 m_firstTimestampUs = -1;
+    qint64 m_clusterTimestampMs = 0;
+    QByteArray m_cluster;               // SimpleBlocks of the open cluster
+    quint64 m_framesWritten = 0;
+};
+
+#endif // MATROSKAWRITER_H
@@ -0,0 +1,104 @@
+#ifndef PARTIALJPEG_H
+#define PARTIALJPEG_H
+
+#include <QByteArray>
+#include <QtEndian>
+#include <cstring>
+
+// Turns the received start of a baseline JPEG into a decodable image of its top rows.
+//
+// A sender that sets a restart interval (DRI) resets the entropy coder every N MCUs and
+// marks the spot with RST0..RST7, so the scan can be cut cleanly right before any
+// restart marker. truncateAtRestart() cuts the prefix at its last marker and appends
+// EOI; decoders then fill the missing MCUs in gray. rows is the number of image rows,
+// at full resolution, made of complete MCU rows before the cut, height the image
+// height. Progressive JPEGs, and scans without restart markers, cannot be cut.
+struct PartialJpeg
+{
+    static bool truncateAtRestart(const QByteArray &prefix, QByteArray *jpeg, int *rows, int *height)
+    {
+        const uchar *data = reinterpret_cast<const uchar *>(prefix.constData());
+        const qsizetype size = prefix.size();
+        if (size < 4 || data[0] != 0xFF || data[1] != 0xD8) {
+            return false;
+        }
+
+        int width = 0;
+        int imageHeight = 0;
+        int maxH = 1;
+        int maxV = 1;
+        int restartInterval = 0;
+        qsizetype scanStart = -1;
+        qsizetype offset = 2;   // after SOI
+
+        while (offset + 4 <= size && data[offset] == 0xFF) {
+            const uchar marker = data[offset + 1];
+            const qsizetype length = qFromBigEndian<quint16>(data + offset + 2);
+            if (length < 2 || offset + 2 + length > size) {
+                return false;
+            }
+            const uchar *segment = data + offset + 4;
+            if (marker == 0xC0 || marker == 0xC1) {
+                // Baseline or extended sequential: precision(1) height(2) width(2) components(1)
+                if (length < 8) {
+                    return false;
+                }
+                imageHeight = qFromBigEndian<quint16>(segment + 1);
+                width = qFromBigEndian<quint16>(segment + 3);
+                const int components = segment[5];
+                if (length < 8 + 3 * components) {
+                    return false;
+                }
+                // A single component scan is not interleaved, its MCU is one 8x8 block
+                for (int i = 0; components > 1 && i < components; ++i) {
+                    const uchar sampling = segment[6 + 3 * i + 1];
+                    maxH = qMax(maxH, sampling >> 4);
+                    maxV = qMax(maxV, sampling & 0x0F);
+                }
+            } else if (marker == 0xC2 || marker == 0xC3 || (marker >= 0xC5 && marker <= 0xCF && marker != 0xC8 && marker != 0xCC)) {
+                return false;   // progressive, lossless or arithmetic coded
+            } else if (marker == 0xDD && length == 4) {
+                restartInterval = qFromBigEndian<quint16>(segment);
+            } else if (marker == 0xDA) {
+                scanStart = offset + 2 + length;
+                break;
+            }
+            offset += 2 + length;
+        }
+        if (scanStart < 0 || restartInterval == 0 || width == 0 || imageHeight == 0) {
+            return false;
+        }
+
+        // Restart markers cannot appear inside entropy coded data, FF is stuffed as FF 00
+        qsizetype cut = -1;
+        qint64 intervals = 0;
+        for (qsizetype i = scanStart; i + 1 < size; ++i) {
+            if (data[i] == 0xFF && data[i + 1] >= 0xD0 && data[i + 1] <= 0xD7) {
+                cut = i;
+                intervals++;
+                i++;
+            }
+        }
+        if (cut < 0) {
+            return false;
+        }
+
+        const int mcuWidth = 8 * maxH;
+        const int mcuHeight = 8 * maxV;
+        const qint64 mcusPerRow = (width + mcuWidth - 1) / mcuWidth;
+        const qint64 mcuRows = intervals * restartInterval / mcusPerRow;
+        *rows = int(qMin<qint64>(imageHeight, mcuRows * mcuHeight));
+        *height = imageHeight;
+        if (*rows == 0) {
+            return false;
+        }
+
+        jpeg->resize(cut + 2);
+        std::memcpy(jpeg->data(), data, size_t(cut));
+        jpeg->data()[cut] = char(0xFF);
+        jpeg->data()[cut + 1] = char(0xD9);
+        return true;
+    }
+};
+
+#endif // PARTIALJPEG_H
@@ -0,0 +1,344 @@
+#include "sharedframering.h"
+#include <QDebug>
+#include <cstring>
+
+#ifdef Q_OS_LINUX
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
+#endif
+
+namespace {
+
+QMutex telemetryMutex;
+SharedFrameRingFormat::Telemetry latestTelemetry;
+
+SharedFrameRingFormat::Telemetry currentTelemetry()
+{
+    QMutexLocker locker(&telemetryMutex);
+    return latestTelemetry;
+}
+
+QByteArray objectName(const QString &name)
+{
+    // POSIX shared memory names are a single path component starting with a slash
+    return (QStringLiteral("/") + QString(name).remove(QLatin1Char('/'))).toLocal8Bit();
+}
+
+qsizetype ringSize(quint32 slotCount, quint32 slotSize)
+{
+    return qsizetype(sizeof(SharedFrameRingFormat::RingHeader)) + qsizetype(slotCount) * slotSize;
+}
+
+}
+
+SharedFrameRing::~SharedFrameRing()
+{
+    close();
+}
+
+bool SharedFrameRing::isSupported()
+{
+#ifdef Q_OS_LINUX
+    return true;
+#else
+    return false;
+#endif
+}
+
+bool SharedFrameRing::open(const QString &name, int slotCount, qsizetype slotCapacity)
+{
+    close();
+
+#ifdef Q_OS_LINUX
+    using Format = SharedFrameRingFormat;
+    QMutexLocker locker(&m_mutex);
+
+    const qsizetype slotBytes = qsizetype(sizeof(Format::SlotHeader)) + slotCapacity;
+    const quint32 slotSize = quint32((slotBytes + Format::SlotAlignment - 1) / Format::SlotAlignment * Format::SlotAlignment);
+    const quint32 slots = quint32(qMax(2, slotCount));
+    const QByteArray path = objectName(name);
+
+    // A fresh object, readers of a previous run keep their mapping of the old one
+    ::shm_unlink(path.constData());
+    const int fd = ::shm_open(path.constData(), O_CREAT | O_EXCL | O_RDWR | O_CLOEXEC, 0660);
+    if (fd < 0) {
+        m_errorString = QString::fromLocal8Bit(strerror(errno));
+        return false;
+    }
+    const qsizetype size = ringSize(slots, slotSize);
+    if (::ftruncate(fd, off_t(size)) < 0) {
+        m_errorString = QString::fromLocal8Bit(strerror(errno));
+        ::close(fd);
+        ::shm_unlink(path.constData());
+        return false;
+    }
+    void *map = ::mmap(nullptr, size_t(size), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);    // the mapping keeps the object
+    if (map == MAP_FAILED) {
+        m_errorString = QString::fromLocal8Bit(strerror(errno));
+        ::shm_unlink(path.constData());
+        return false;
+    }
+
+    // ftruncate() zero fills: every slot sequence starts at 0, never 2n+2
+    m_map = static_cast<char *>(map);
+    m_mapSize = size;
+    m_header = reinterpret_cast<Format::RingHeader *>(m_map);
+    m_header->version = Format::Version;
+    m_header->slotCount = slots;
+    m_header->slotSize = slotSize;
+    m_header->slotHeaderSize = sizeof(Format::SlotHeader);
+    m_header->published.store(0, std::memory_order_relaxed);
+    m_header->created = FrameTiming::now();
+    m_header->writerPid = quint32(::getpid());
+    std::atomic_thread_fence(std::memory_order_release);
+    std::memcpy(m_header->magic, Format::Magic, sizeof(Format::Magic));
+
+    m_name = name;
+    qDebug() << "Exporting frames to shared memory" << path << slots << "slots of" << slotSize << "bytes";
+    return true;
+#else
+    Q_UNUSED(slotCount);
+    Q_UNUSED(slotCapacity);
+    QMutexLocker locker(&m_mutex);
+    m_name = name;
+    m_errorString = QStringLiteral("Shared memory frame export is not supported on this platform");
+    return false;
+#endif
+}
+
+void SharedFrameRing::close()
+{
+    QMutexLocker locker(&m_mutex);
+#ifdef Q_OS_LINUX
+    if (m_map) {
+        unmap();
+        ::shm_unlink(objectName(m_name).constData());
+    }
+#endif
+    m_name.clear();
+}
+
+void SharedFrameRing::unmap()
+{
+#ifdef Q_OS_LINUX
+    ::munmap(m_map, size_t(m_mapSize));
+#endif
+    m_map = nullptr;
+    m_mapSize = 0;
+    m_header = nullptr;
+}
+
+bool SharedFrameRing::isOpen() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_header != nullptr;
+}
+
+QString SharedFrameRing::name() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_name;
+}
+
+QString SharedFrameRing::errorString() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_errorString;
+}
+
+bool SharedFrameRing::publishJpeg(const QByteArray &jpeg, quint16 frameId, const FrameTiming &timing)
+{
+    SharedFrameRingFormat::FrameMetadata metadata;
+    metadata.kind = SharedFrameRingFormat::Jpeg;
+    metadata.frameId = frameId;
+    metadata.capture = timing.capture;
+    metadata.firstFragment = timing.firstFragment;
+    metadata.lastFragment = timing.lastFragment;
+    // Exported as soon as it is reassembled, before the stream stamps that itself
+    metadata.reassembled = timing.reassembled ? timing.reassembled : FrameTiming::now();
+    metadata.decoded = timing.decoded;
+    return publish(jpeg.constData(), jpeg.size(), metadata);
+}
+
+bool SharedFrameRing::publishImage(const QImage &image, quint16 frameId, const FrameTiming &timing)
+{
+    // The decoder produces one of these two, both are 0xAARRGGBB words and opaque
+    if (image.format() != QImage::Format_RGB32 && image.format() != QImage::Format_ARGB32_Premultiplied) {
+        return false;
+    }
+
+    SharedFrameRingFormat::FrameMetadata metadata;
+    metadata.kind = SharedFrameRingFormat::Rgb32;
+    metadata.frameId = frameId;
+    metadata.width = quint32(image.width());
+    metadata.height = quint32(image.height());
+    metadata.bytesPerLine = quint32(image.bytesPerLine());
+    metadata.capture = timing.capture;
+    metadata.firstFragment = timing.firstFragment;
+    metadata.lastFragment = timing.lastFragment;
+    metadata.reassembled = timing.reassembled;
+    metadata.decoded = timing.decoded;
+    return publish(reinterpret_cast<const char *>(image.constBits()), image.sizeInBytes(), metadata);
+}
+
+bool SharedFrameRing::publish(const char *data, qsizetype size, SharedFrameRingFormat::FrameMetadata metadata)
+{
+    using Format = SharedFrameRingFormat;
+    QMutexLocker locker(&m_mutex);
+    if (!m_header) {
+        return false;
+    }
+    if (size > qsizetype(m_header->slotSize - m_header->slotHeaderSize)) {
+        m_oversizedFrames.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    metadata.size = quint32(size);
+    metadata.telemetry = currentTelemetry();
+
+    // Only this process writes, published needs no read-modify-write
+    const quint64 sequence = m_header->published.load(std::memory_order_relaxed);
+    char *slot = m_map + sizeof(Format::RingHeader) + qsizetype(sequence % m_header->slotCount) * m_header->slotSize;
+    Format::SlotHeader *slotHeader = reinterpret_cast<Format::SlotHeader *>(slot);
+
+    slotHeader->sequence.store(2 * sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    std::memcpy(slot + m_header->slotHeaderSize, data, size_t(size));
+    slotHeader->metadata = metadata;
+    slotHeader->sequence.store(2 * sequence + 2, std::memory_order_release);
+    m_header->published.store(sequence + 1, std::memory_order_release);
+
+    m_publishedFrames.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+void SharedFrameRing::updateTelemetry(const SharedFrameRingFormat::Telemetry &telemetry)
+{
+    QMutexLocker locker(&telemetryMutex);
+    latestTelemetry = telemetry;
+}
+
+SharedFrameRingReader::~SharedFrameRingReader()
+{
+    close();
+}
+
+bool SharedFrameRingReader::open(const QString &name)
+{
+    close();
+
+#ifdef Q_OS_LINUX
+    using Format = SharedFrameRingFormat;
+    const int fd = ::shm_open(objectName(name).constData(), O_RDONLY | O_CLOEXEC, 0);
+    if (fd < 0) {
+        m_errorString = QString::fromLocal8Bit(strerror(errno));
+        return false;
+    }
+    struct stat status;
+    if (::fstat(fd, &status) < 0 || qsizetype(status.st_size) < qsizetype(sizeof(Format::RingHeader))) {
+        m_errorString = QStringLiteral("Not a frame ring");
+        ::close(fd);
+        return false;
+    }
+    void *map = ::mmap(nullptr, size_t(status.st_size), PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (map == MAP_FAILED) {
+        m_errorString = QString::fromLocal8Bit(strerror(errno));
+        return false;
+    }
+
+    const Format::RingHeader *header = static_cast<const Format::RingHeader *>(map);
+    const bool valid = std::memcmp(header->magic, Format::Magic, sizeof(Format::Magic)) == 0;
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (!valid || header->version != Format::Version || header->slotCount == 0
+        || header->slotHeaderSize != sizeof(Format::SlotHeader)
+        || ringSize(header->slotCount, header->slotSize) > qsizetype(status.st_size)) {
+        m_errorString = valid ? QStringLiteral("Unsupported frame ring version or layout")
+                              : QStringLiteral("Not a frame ring, or not initialized yet");
+        ::munmap(map, size_t(status.st_size));
+        return false;
+    }
+
+    m_map = static_cast<const char *>(map);
+    m_mapSize = qsizetype(status.st_size);
+    m_header = header;
+    return true;
+#else
+    Q_UNUSED(name);
+    m_errorString = QStringLiteral("Shared memory frame export is not supported on this platform");
+    return false;
+#endif
+}
+
+void SharedFrameRingReader::close()
+{
+#ifdef Q_OS_LINUX
+    if (m_map) {
+        ::munmap(const_cast<char *>(m_map), size_t(m_mapSize));
+    }
+#endif
+    m_map = nullptr;
+    m_mapSize = 0;
+    m_header = nullptr;
+    m_hasRead = false;
+    m_lastSequence = 0;
+}
+
+qint64 SharedFrameRingReader::created() const
+{
+    return m_header ? m_header->created : 0;
+}
+
+const SharedFrameRingFormat::SlotHeader *SharedFrameRingReader::slot(quint64 sequence) const
+{
+    return reinterpret_cast<const SharedFrameRingFormat::SlotHeader *>(
+        m_map + sizeof(SharedFrameRingFormat::RingHeader)
+        + qsizetype(sequence % m_header->slotCount) * m_header->slotSize);
+}
+
+bool SharedFrameRingReader::next(Frame *frame)
+{
+    if (!m_header) {
+        return false;
+    }
+    const quint64 published = m_header->published.load(std::memory_order_acquire);
+    if (published == 0 || (m_hasRead && published - 1 <= m_lastSequence)) {
+        return false;
+    }
+
+    const quint64 sequence = published - 1;
+    const SharedFrameRingFormat::SlotHeader *header = slot(sequence);
+    if (header->sequence.load(std::memory_order_acquire) != 2 * sequence + 2) {
+        return false;   // already being overwritten, the next call gets the newer frame
+    }
+    frame->metadata = header->metadata;
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (header->sequence.load(std::memory_order_relaxed) != 2 * sequence + 2
+        || frame->metadata.size > m_header->slotSize - m_header->slotHeaderSize) {
+        return false;
+    }
+
+    if (m_hasRead) {
+        m_skippedFrames += sequence - m_lastSequence - 1;
+    }
+    m_hasRead = true;
+    m_lastSequence = sequence;
+
+    frame->sequence = sequence;
+    frame->data = reinterpret_cast<const char *>(header) + m_header->slotHeaderSize;
+    frame->size = qsizetype(frame->metadata.size);
+    return true;
+}
+
+bool SharedFrameRingReader::isValid(const Frame &frame) const
+{
+    if (!m_header) {
+        return false;
+    }
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return slot(frame.sequence)->sequence.load(std::memory_order_relaxed) == 2 * frame.sequence + 2;
+}
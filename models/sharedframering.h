@@ -0,0 +1,188 @@
+#ifndef SHAREDFRAMERING_H
+#define SHAREDFRAMERING_H
+
+#include <QByteArray>
+#include <QImage>
+#include <QMutex>
+#include <QString>
+#include <atomic>
+#include "frametiming.h"
+
+// POSIX shared memory ring the camera streams are exported through to local analytics
+// processes, which then read frames in place: no socket, no copy, no decode they do
+// not want.
+//
+// Layout, native endian, every slot 64 byte aligned: a 64 byte RingHeader, then
+// slotCount slots of slotSize bytes, each a 128 byte SlotHeader followed by the frame
+// (a JPEG as received, or a decoded RGB32 image).
+//
+// Every slot is a sequence lock. Frame n goes to slot n % slotCount: its sequence is
+// 2n+1 while the frame is written and 2n+2 once complete, then published becomes n+1.
+// A reader takes frame published-1, checks the sequence is 2n+2, uses the data where
+// it lies and checks the sequence again; a changed sequence means the writer lapped the
+// reader and the frame is discarded. The writer never waits for anyone, so a slow or
+// stuck consumer only ever loses frames, it cannot hold up the ground station.
+struct SharedFrameRingFormat
+{
+    static constexpr char Magic[8] = { 'M', 'A', 'R', 'S', 'S', 'H', 'M', '1' };
+    static constexpr quint32 Version = 1;
+    static constexpr quint32 SlotAlignment = 64;
+
+    enum Kind : quint32 {
+        Jpeg = 0,
+        Rgb32 = 1,      // 32 bit 0xffRRGGBB pixels, bytesPerLine apart
+    };
+
+    // Latest gimbal telemetry when the frame was exported
+    struct Telemetry {
+        qint64 received = 0;        // microseconds since the epoch, 0 without telemetry
+        quint32 gimbalPoseLat = 0;
+        quint32 gimbalPoseLon = 0;
+        quint16 gimbalRoll = 0;
+        quint16 gimbalPitch = 0;
+        quint16 gimbalYaw = 0;
+        quint16 yawMotorPose = 0;
+        quint16 pitchMotorPose = 0;
+        quint16 gimbalPoseAlt = 0;
+        quint8 battery = 0;
+        quint8 signalStrength = 0;
+        quint16 reserved = 0;
+    };
+
+    struct FrameMetadata {
+        quint32 kind = Jpeg;
+        quint32 size = 0;           // bytes of frame data after the slot header
+        quint16 frameId = 0;
+        quint16 reserved = 0;
+        quint32 width = 0;          // decoded frames only
+        quint32 height = 0;
+        quint32 bytesPerLine = 0;
+        qint64 capture = 0;         // FrameTiming, microseconds since the epoch
+        qint64 firstFragment = 0;
+        qint64 lastFragment = 0;
+        qint64 reassembled = 0;
+        qint64 decoded = 0;
+        Telemetry telemetry;
+    };
+
+    struct RingHeader {
+        char magic[8];              // written last, a reader ignores the ring until then
+        quint32 version;
+        quint32 slotCount;
+        quint32 slotSize;           // slot header included
+        quint32 slotHeaderSize;
+        std::atomic<quint64> published;
+        qint64 created;             // microseconds since the epoch, changes when the writer restarts
+        quint32 writerPid;
+        char reserved[20];
+    };
+
+    struct SlotHeader {
+        std::atomic<quint64> sequence;
+        FrameMetadata metadata;
+        char reserved[128 - 8 - sizeof(FrameMetadata)];
+    };
+
+    static_assert(std::atomic<quint64>::is_always_lock_free, "the sequence must be usable across processes");
+    static_assert(sizeof(Telemetry) == 32);
+    static_assert(sizeof(FrameMetadata) == 96);
+    static_assert(sizeof(RingHeader) == 64);
+    static_assert(sizeof(SlotHeader) == 128);
+};
+
+// Writer side, owned by the stream that exports. publish*() may be called from any one
+// thread at a time; open() and close() are thread safe with respect to it.
+class SharedFrameRing
+{
+public:
+    SharedFrameRing() = default;
+    ~SharedFrameRing();
+
+    SharedFrameRing(const SharedFrameRing &) = delete;
+    SharedFrameRing &operator=(const SharedFrameRing &) = delete;
+
+    static bool isSupported();
+
+    // Creates /name with slotCount slots of up to slotCapacity bytes of frame data,
+    // replacing an object left behind by an earlier run
+    bool open(const QString &name, int slotCount, qsizetype slotCapacity);
+    // Unmaps and unlinks, readers still attached keep their mapping
+    void close();
+
+    bool isOpen() const;
+    QString name() const;
+    QString errorString() const;
+
+    // False when closed, or when the frame exceeds the slot capacity
+    bool publishJpeg(const QByteArray &jpeg, quint16 frameId, const FrameTiming &timing);
+    bool publishImage(const QImage &image, quint16 frameId, const FrameTiming &timing);
+
+    quint64 publishedFrames() const { return m_publishedFrames.load(std::memory_order_relaxed); }
+    quint64 oversizedFrames() const { return m_oversizedFrames.load(std::memory_order_relaxed); }
+
+    // Process wide gimbal telemetry stamped into every frame exported afterwards.
+    // Thread safe.
+    static void updateTelemetry(const SharedFrameRingFormat::Telemetry &telemetry);
+
+private:
+    bool publish(const char *data, qsizetype size, SharedFrameRingFormat::FrameMetadata metadata);
+    void unmap();
+
+    mutable QMutex m_mutex;
+    QString m_name;
+    QString m_errorString;
+    char *m_map = nullptr;
+    qsizetype m_mapSize = 0;
+    SharedFrameRingFormat::RingHeader *m_header = nullptr;
+    std::atomic<quint64> m_publishedFrames{0};
+    std::atomic<quint64> m_oversizedFrames{0};
+};
+
+// Reader side, for analytics processes and tools
+class SharedFrameRingReader
+{
+public:
+    struct Frame {
+        quint64 sequence = 0;       // frame number n in the ring
+        SharedFrameRingFormat::FrameMetadata metadata;
+        const char *data = nullptr; // inside the mapping, see isValid()
+        qsizetype size = 0;
+    };
+
+    SharedFrameRingReader() = default;
+    ~SharedFrameRingReader();
+
+    SharedFrameRingReader(const SharedFrameRingReader &) = delete;
+    SharedFrameRingReader &operator=(const SharedFrameRingReader &) = delete;
+
+    bool open(const QString &name);
+    void close();
+    bool isOpen() const { return m_header != nullptr; }
+    QString errorString() const { return m_errorString; }
+
+    // Creation time of the ring, a reader reopens when the writer restarted
+    qint64 created() const;
+
+    // The newest frame not returned before, false when there is none
+    bool next(Frame *frame);
+
+    // The writer has not touched the frame's slot since next() returned it: whatever
+    // was read from frame.data before this call is a consistent frame
+    bool isValid(const Frame &frame) const;
+
+    // Frames published but overwritten before this reader got to them
+    quint64 skippedFrames() const { return m_skippedFrames; }
+
+private:
+    const SharedFrameRingFormat::SlotHeader *slot(quint64 sequence) const;
+
+    QString m_errorString;
+    const char *m_map = nullptr;
+    qsizetype m_mapSize = 0;
+    const SharedFrameRingFormat::RingHeader *m_header = nullptr;
+    bool m_hasRead = false;
+    quint64 m_lastSequence = 0;
+    quint64 m_skippedFrames = 0;
+};
+
+#endif // SHAREDFRAMERING_H
@@ -0,0 +1,161 @@
+#include "streamrecorder.h"
+#include "matroskawriter.h"
+#include <QDateTime>
+#include <QDebug>
+#include <QDir>
+#include <QStandardPaths>
+
+StreamRecorder::StreamRecorder(QObject *parent)
+    : QObject(parent)
+    , m_stopping(false)
+    , m_writer(QThread::create([this] { run(); }))
+{
+    m_writer->setObjectName("StreamRecorder writer");
+    m_writer->start(QThread::LowPriority);
+}
+
+StreamRecorder::~StreamRecorder()
+{
+    stop();
+    {
+        QMutexLocker locker(&m_mutex);
+        m_stopping = true;
+        m_wake.wakeAll();
+    }
+    m_writer->wait();
+    delete m_writer;
+}
+
+QString StreamRecorder::filePath() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_filePath;
+}
+
+QString StreamRecorder::outputPath(const QString &folder, const QString &prefix, const QString &suffix)
+{
+    QString outputDir = folder;
+    if (outputDir.isEmpty()) {
+        outputDir = QStandardPaths::writableLocation(QStandardPaths::MoviesLocation);
+        if (outputDir.isEmpty()) {
+            outputDir = QStandardPaths::writableLocation(QStandardPaths::HomeLocation);
+        }
+    }
+
+    QDir dir(outputDir);
+    if (!dir.exists()) {
+        dir.mkpath(outputDir);
+    }
+
+    const QString timestamp = QDateTime::currentDateTime().toString("yyyy-MM-dd_hh-mm-ss");
+    return dir.filePath(QString("%1_%2.%3").arg(prefix, timestamp, suffix));
+}
+
+void StreamRecorder::start(const QString &filePath)
+{
+    if (isRecording()) {
+        stop();
+    }
+
+    {
+        QMutexLocker locker(&m_mutex);
+        m_filePath = filePath;
+    }
+    m_recordedFrames.store(0, std::memory_order_relaxed);
+    m_droppedFrames.store(0, std::memory_order_relaxed);
+    m_recording.store(true, std::memory_order_release);
+
+    qDebug() << "Stream recording to:" << filePath;
+    emit started(filePath);
+}
+
+void StreamRecorder::stop()
+{
+    if (!m_recording.exchange(false, std::memory_order_acq_rel)) {
+        return;
+    }
+
+    // The writer finishes the frames already queued, then closes the file
+    QMutexLocker locker(&m_mutex);
+    Job end;
+    end.filePath = m_filePath;
+    m_queue.append(end);
+    m_wake.wakeAll();
+}
+
+void StreamRecorder::addFrame(const QByteArray &jpeg, qint64 timestampUs)
+{
+    if (!isRecording() || jpeg.isEmpty()) {
+        return;
+    }
+
+    QMutexLocker locker(&m_mutex);
+    if (m_queue.size() >= MaxQueuedFrames) {
+        m_droppedFrames.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    Job job;
+    job.jpeg = jpeg;
+    job.timestampUs = timestampUs;
+    job.filePath = m_filePath;
+    m_queue.append(job);
+    m_wake.wakeOne();
+}
+
+void StreamRecorder::run()
+{
+    MatroskaWriter writer;
+    QString openPath;
+    bool failed = false;
+
+    QMutexLocker locker(&m_mutex);
+    while (true) {
+        while (m_queue.isEmpty() && !m_stopping) {
+            m_wake.wait(&m_mutex);
+        }
+        if (m_queue.isEmpty()) {
+            break;
+        }
+        Job job = m_queue.takeFirst();
+        locker.unlock();
+
+        if (job.jpeg.isNull()) {
+            // End of a recording
+            if (writer.isOpen()) {
+                const quint64 frames = writer.framesWritten();
+                writer.close();
+                qDebug() << "Stream recording saved:" << openPath << "frames:" << frames;
+                emit stopped(openPath, frames);
+            } else if (!failed) {
+                emit stopped(job.filePath, 0);
+            }
+            openPath.clear();
+            failed = false;
+        } else {
+            if (job.filePath != openPath) {
+                writer.close();
+                openPath = job.filePath;
+                failed = !writer.open(openPath, MatroskaWriter::jpegSize(job.jpeg));
+                if (failed) {
+                    m_recording.store(false, std::memory_order_release);
+                    emit errorOccurred("Cannot create " + openPath + ": " + writer.errorString());
+                }
+            }
+            if (!failed) {
+                if (writer.writeFrame(job.jpeg, job.timestampUs)) {
+                    m_recordedFrames.fetch_add(1, std::memory_order_relaxed);
+                } else {
+                    failed = true;
+                    m_recording.store(false, std::memory_order_release);
+                    emit errorOccurred("Writing " + openPath + " failed: " + writer.errorString());
+                    writer.close();
+                }
+            }
+        }
+
+        locker.relock();
+    }
+
+    writer.close();
+}
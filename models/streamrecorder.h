@@ -0,0 +1,71 @@
+#ifndef STREAMRECORDER_H
+#define STREAMRECORDER_H
+
+#include <QObject>
+#include <QByteArray>
+#include <QList>
+#include <QMutex>
+#include <QString>
+#include <QThread>
+#include <QWaitCondition>
+#include <atomic>
+
+// Records the received JPEG frames of one camera stream as they are, without decoding
+// or re-encoding, into a Matroska (V_MJPEG) file with per-frame timestamps.
+//
+// The camera model calls addFrame() from its ingest thread with the reassembled frame;
+// the frame is only referenced (implicitly shared) and queued, and a writer thread owned
+// by the recorder does the file I/O. If the disk cannot keep up, frames beyond
+// MaxQueuedFrames are dropped and counted instead of growing the queue.
+class StreamRecorder : public QObject
+{
+    Q_OBJECT
+
+public:
+    static constexpr int MaxQueuedFrames = 120;
+
+    explicit StreamRecorder(QObject *parent = nullptr);
+    ~StreamRecorder();
+
+    // Thread safe, ignored unless recording
+    void addFrame(const QByteArray &jpeg, qint64 timestampUs);
+
+    bool isRecording() const { return m_recording.load(std::memory_order_acquire); }
+    quint64 recordedFrames() const { return m_recordedFrames.load(std::memory_order_relaxed); }
+    quint64 droppedFrames() const { return m_droppedFrames.load(std::memory_order_relaxed); }
+    QString filePath() const;
+
+    // Default file name in folder (Movies when empty), prefix identifies the stream
+    static QString outputPath(const QString &folder, const QString &prefix, const QString &suffix = "mkv");
+
+public slots:
+    // The file is created with the first frame, which sets the track size
+    void start(const QString &filePath);
+    void stop();
+
+signals:
+    void started(const QString &filePath);
+    void stopped(const QString &filePath, quint64 frames);
+    void errorOccurred(const QString &error);
+
+private:
+    struct Job {
+        QByteArray jpeg;            // null marks the end of a recording
+        qint64 timestampUs = 0;
+        QString filePath;
+    };
+
+    void run();
+
+    mutable QMutex m_mutex;
+    QWaitCondition m_wake;
+    QList<Job> m_queue;
+    QString m_filePath;
+    bool m_stopping;
+    std::atomic<bool> m_recording{false};
+    std::atomic<quint64> m_recordedFrames{0};
+    std::atomic<quint64> m_droppedFrames{0};
+    QThread *m_writer;
+};
+
+#endif // STREAMRECORDER_H
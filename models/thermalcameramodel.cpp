@@ -3,6 +3,7 @@
 #include <QNetworkDatagram>
 #include<QtEndian>
 #include<QDateTime>
+#include "partialjpeg.h"
 // JPEG markers
 const QByteArray ThermalCameraModel::JPEG_START_MARKER = QByteArray::fromHex("FFD8");
 const QByteArray ThermalCameraModel::JPEG_END_MARKER = QByteArray::fromHex("FFD9");
@@ -10,9 +11,19 @@ const QByteArray ThermalCameraModel::JPEG_END_MARKER = QByteArray::fromHex("FFD9
 ThermalCameraModel::ThermalCameraModel(QObject *parent)
     : QObject(parent)
     , m_udpSocket(nullptr)
+    , m_batchReceiver(nullptr)
+    , m_reactorIngest(IngestReactor::isSupported())
+    , m_reactorStream(-1)
+    , m_replay(nullptr)
+    , m_batchedIngest(UdpBatchReceiver::isSupported())
     , m_processTimer(new QTimer(this))
     , m_streaming(false)
     , m_fragmentTimeout(5000)
+    , m_reassembler(m_fragmentTimeout)
+    , m_frameMailbox(nullptr)
+    , m_linkStatistics(nullptr)
+    , m_recorder(nullptr)
+    , m_progressiveDisplay(false)
 {
     // Timer to process buffer periodically
     m_processTimer->setInterval(16);
@@ -38,16 +49,59 @@ void ThermalCameraModel::startStreaming(const QString &ipAddress, int port)
     m_settings.ipAddress = ipAddress;
     m_settings.port = port;
 
-    // Create UDP socket
-    m_udpSocket = new QUdpSocket(this);
+    bool bound = false;
+
+    // The shared reactor serves every stream from one epoll thread, datagrams are handled
+    // on that thread; otherwise this model's thread receives with its own backend
+    if (m_reactorIngest && IngestReactor::isSupported()) {
+        QString error;
+        m_reactorStream = IngestReactor::instance()->addStream(quint16(port), m_multicastGroup, [this](const char *data, qsizetype size) {
+            ingestDatagram(data, size);
+        }, &error);
+        bound = m_reactorStream >= 0;
+        if (!bound) {
+            qDebug() << "Ingest reactor unavailable, falling back to a per stream receiver:" << error;
+        }
+    }
+
+    // Prefer the batched receive backend, fall back to QUdpSocket when it is unavailable
+    if (!bound && m_batchedIngest && UdpBatchReceiver::isSupported()) {
+        m_batchReceiver = new UdpBatchReceiver(this);
+        m_batchReceiver->setDatagramHandler([this](const char *data, qsizetype size) {
+            ingestDatagram(data, size);
+        });
+        connect(m_batchReceiver, &UdpBatchReceiver::errorOccurred, this, [this](const QString &error) {
+            emit errorOccurred("UDP Socket Error: " + error);
+        });
+
+        bound = m_batchReceiver->bind(quint16(port), m_multicastGroup);
+        if (!bound) {
+            qDebug() << "Batched receive unavailable, falling back to QUdpSocket:" << m_batchReceiver->errorString();
+            delete m_batchReceiver;
+            m_batchReceiver = nullptr;
+        }
+    }
+
+    if (!bound) {
+        // Create UDP socket
+        m_udpSocket = new QUdpSocket(this);
 
-    // Connect signals
-    connect(m_udpSocket, &QUdpSocket::readyRead, this, &ThermalCameraModel::readPendingDatagrams);
-    connect(m_udpSocket, QOverload<QAbstractSocket::SocketError>::of(&QUdpSocket::errorOccurred),
-            this, &ThermalCameraModel::onSocketError);
+        // Connect signals
+        connect(m_udpSocket, &QUdpSocket::readyRead, this, &ThermalCameraModel::readPendingDatagrams);
+        connect(m_udpSocket, QOverload<QAbstractSocket::SocketError>::of(&QUdpSocket::errorOccurred),
+                this, &ThermalCameraModel::onSocketError);
 
-    // Bind to the specified port
-    if (m_udpSocket->bind(QHostAddress::AnyIPv4, port)) {
+        // Bind to the specified port, shared with the other members of a multicast group
+        if (m_multicastGroup.isNull()) {
+            bound = m_udpSocket->bind(QHostAddress::AnyIPv4, port);
+        } else {
+            bound = m_udpSocket->bind(QHostAddress::AnyIPv4, port,
+                                      QUdpSocket::ShareAddress | QUdpSocket::ReuseAddressHint)
+                    && m_udpSocket->joinMulticastGroup(m_multicastGroup);
+        }
+    }
+
+    if (bound) {
         m_streaming = true;
         m_processTimer->start();
         m_cleanupTimer->start();
@@ -70,6 +124,23 @@ void ThermalCameraModel::stopStreaming()
     m_processTimer->stop();
     m_cleanupTimer->stop();
 
+    if (m_reactorStream >= 0) {
+        IngestReactor::instance()->removeStream(m_reactorStream);
+        m_reactorStream = -1;
+    }
+
+    if (m_batchReceiver) {
+        m_batchReceiver->close();
+        m_batchReceiver->deleteLater();
+        m_batchReceiver = nullptr;
+    }
+
+    if (m_replay) {
+        m_replay->stop();
+        m_replay->deleteLater();
+        m_replay = nullptr;
+    }
+
     if (m_udpSocket) {
         m_udpSocket->close();
         m_udpSocket->deleteLater();
@@ -78,6 +149,9 @@ void ThermalCameraModel::stopStreaming()
 
     clearBuffer();
     clearIncompleteFrames();
+    if (m_linkStatistics) {
+        m_linkStatistics->resetSequence();
+    }
     m_streaming = false;
     emit streamingStatusChanged(false);
     qDebug() << "Stopped UDP streaming";
@@ -88,6 +162,18 @@ bool ThermalCameraModel::isStreaming() const
     return m_streaming;
 }
 
+void ThermalCameraModel::setBatchedIngest(bool enabled)
+{
+    // Takes effect the next time streaming starts
+    m_batchedIngest = enabled;
+}
+
+void ThermalCameraModel::setReactorIngest(bool enabled)
+{
+    // Takes effect the next time streaming starts
+    m_reactorIngest = enabled;
+}
+
 void ThermalCameraModel::readPendingDatagrams()
 {
     while (m_udpSocket && m_udpSocket->hasPendingDatagrams()) {
@@ -95,106 +181,257 @@ void ThermalCameraModel::readPendingDatagrams()
         QByteArray data = datagram.data();
 
         if (!data.isEmpty()) {
-            processFragmentedPacket(data);
+            ingestDatagram(data.constData(), data.size());
         }
     }
 }
 
-void ThermalCameraModel::processFragmentedPacket(const QByteArray &packet)
+void ThermalCameraModel::ingestDatagram(const char *packet, qsizetype size)
 {
-    // Check if packet has header (minimum 16 bytes for header)
-    // Check if packet has header (minimum 16 bytes for header)
-    // Check if packet has header (minimum 14 bytes for header)
-    if (packet.size() < 14) {
-        qDebug() << "Packet too small for header:" << packet.size();
+    // Downstream stations get the datagram before this station spends time on it
+    m_relay.forward(packet, size);
+
+    if (m_capturing.load(std::memory_order_relaxed) && size > 0) {
+        QMutexLocker locker(&m_captureMutex);
+        if (m_capture.isOpen() && !m_capture.write(packet, size, FrameTiming::now())) {
+            emit errorOccurred("Capture failed: " + m_capture.errorString());
+            m_capture.close();
+            m_capturing.store(false, std::memory_order_relaxed);
+            emit captureStatusChanged(false, QString());
+        }
+    }
+    if (!m_relayOnly.load(std::memory_order_relaxed)) {
+        processFragmentedPacket(packet, size);
+    }
+}
+
+void ThermalCameraModel::startCapture(const QString &filePath)
+{
+    stopCapture();
+
+    QMutexLocker locker(&m_captureMutex);
+    if (!m_capture.open(filePath)) {
+        emit errorOccurred("Cannot create capture " + filePath + ": " + m_capture.errorString());
         return;
     }
+    m_capturing.store(true, std::memory_order_relaxed);
+    qDebug() << "Capturing datagrams to:" << filePath;
+    emit captureStatusChanged(true, filePath);
+}
 
-    // Parse header: frame_id(2) + total_fragments(4) + fragment_index(4) + fragment_size(4)
-    const char* data = packet.constData();
-    quint16 frameId = qFromBigEndian<quint16>(reinterpret_cast<const uchar*>(data));
-    quint32 totalFragments = qFromBigEndian<quint32>(reinterpret_cast<const uchar*>(data + 2));
-    quint32 fragmentIndex = qFromBigEndian<quint32>(reinterpret_cast<const uchar*>(data + 6));
-    quint32 fragmentSize = qFromBigEndian<quint32>(reinterpret_cast<const uchar*>(data + 10));
-    // Validate header
-    if (fragmentIndex >= totalFragments || fragmentSize != (packet.size() - 14)) {
-        qDebug() << "Invalid fragment header - Index:" << fragmentIndex
-                 << "Total:" << totalFragments << "Size:" << fragmentSize ;
+void ThermalCameraModel::stopCapture()
+{
+    QMutexLocker locker(&m_captureMutex);
+    if (!m_capture.isOpen()) {
         return;
     }
+    m_capturing.store(false, std::memory_order_relaxed);
+    const quint64 datagrams = m_capture.datagrams();
+    m_capture.close();
+    qDebug() << "Capture closed, datagrams:" << datagrams;
+    emit captureStatusChanged(false, QString());
+}
 
-    // Extract fragment data
-    QByteArray fragmentData = packet.mid(14);
+void ThermalCameraModel::startReplay(const QString &filePath, bool realTime)
+{
+    if (m_streaming) {
+        stopStreaming();
+    }
+
+    // The replay takes the place of the socket, frames go through the normal ingest path
+    m_replay = new UdpCaptureReplay(this);
+    m_replay->setDatagramHandler([this](const char *data, qsizetype size) {
+        processFragmentedPacket(data, size);
+    });
+    connect(m_replay, &UdpCaptureReplay::finished, this, [this](quint64 datagrams) {
+        qDebug() << "Replay finished, datagrams:" << datagrams;
+        emit replayFinished(datagrams);
+        stopStreaming();
+    });
+
+    const UdpCaptureReplay::Pacing pacing = realTime ? UdpCaptureReplay::Pacing::RealTime
+                                                     : UdpCaptureReplay::Pacing::AsFastAsPossible;
+    if (!m_replay->start(filePath, pacing)) {
+        emit errorOccurred("Cannot replay " + filePath + ": " + m_replay->errorString());
+        delete m_replay;
+        m_replay = nullptr;
+        return;
+    }
 
+    m_streaming = true;
+    m_processTimer->start();
+    m_cleanupTimer->start();
+    emit streamingStatusChanged(true);
+    qDebug() << "Replaying" << filePath << (realTime ? "at the original timing" : "as fast as possible");
+}
+
+void ThermalCameraModel::processFragmentedPacket(const char *packet, qsizetype size)
+{
+    // Taken first: with the ingest reactor this runs on the reactor's thread, and the
+    // link statistics are also written by cleanupIncompleteFrames() on this model's thread
     QMutexLocker locker(&m_bufferMutex);
 
-    // Initialize frame reassembly if this is the first fragment
-    if (!m_incompleteFrames.contains(frameId)) {
-        FrameAssembly assembly;
-        assembly.totalFragments = totalFragments;
-        assembly.receivedFragments = 0;
-        assembly.fragments.resize(totalFragments);
-        assembly.timestamp = QDateTime::currentMSecsSinceEpoch();
-        m_incompleteFrames[frameId] = assembly;
+    if (m_linkStatistics) {
+        m_linkStatistics->recordDatagram(size);
+    }
 
-        qDebug() << "Started reassembly for frame" << frameId << "with" << totalFragments << "fragments";
+    // Check if packet has header (minimum 14 bytes for header)
+    if (size < FragmentHeader::Size) {
+        if (m_linkStatistics) {
+            m_linkStatistics->recordMalformed();
+        }
+        qDebug() << "Packet too small for header:" << size;
+        return;
     }
 
-    FrameAssembly& assembly = m_incompleteFrames[frameId];
+    const qint64 arrivalTime = QDateTime::currentMSecsSinceEpoch();
+    FrameReassembler<>::Frame frame;
+    const FrameReassembler<>::Result result = m_reassembler.addFragment(packet, size, arrivalTime, &frame);
+    if (m_linkStatistics) {
+        if (result == FrameReassembler<>::Result::Malformed) {
+            m_linkStatistics->recordMalformed();
+        } else {
+            m_linkStatistics->recordFragment(m_reassembler.lastHeader(), arrivalTime);
+            if (result == FrameReassembler<>::Result::Duplicate) {
+                m_linkStatistics->recordDuplicate();
+            } else if (result == FrameReassembler<>::Result::Stale) {
+                m_linkStatistics->recordLate();
+            } else if (result == FrameReassembler<>::Result::Complete) {
+                m_linkStatistics->recordCompleted();
+            }
+        }
+    }
 
-    // Check if we already have this fragment
-    if (!assembly.fragments[fragmentIndex].isEmpty()) {
-        qDebug() << "Duplicate fragment" << fragmentIndex << "for frame" << frameId;
+    switch (result) {
+    case FrameReassembler<>::Result::Malformed: {
+        const FragmentHeader &header = m_reassembler.lastHeader();
+        qDebug() << "Invalid fragment header - Index:" << header.fragmentIndex
+                 << "Total:" << header.totalFragments << "Size:" << header.fragmentSize;
         return;
     }
+    case FrameReassembler<>::Result::Duplicate:
+        qDebug() << "Duplicate fragment" << m_reassembler.lastHeader().fragmentIndex
+                 << "for frame" << m_reassembler.lastHeader().frameId;
+        return;
+    case FrameReassembler<>::Result::Stale:
+        return;
+    case FrameReassembler<>::Result::Incomplete:
+        if (m_progressiveDisplay) {
+            postPartialFrame();
+        }
+        return;
+    case FrameReassembler<>::Result::Complete:
+        break;
+    }
+    FrameTiming timing;
+    timing.lastFragment = FrameTiming::now();
+    timing.firstFragment = frame.firstFragmentTime * 1000;     // reassembler clock is in ms
+
+    // Frames older than this one would only be shown out of order, stop assembling them
+    m_reassembler.markDelivered(frame.frameId);
+
+    // Validate and emit the complete frame
+    if (isValidJpegFrame(frame.data)) {
+        timing.capture = FrameTiming::captureTimestamp(frame.data);
+        if (m_recorder) {
+            m_recorder->addFrame(frame.data, timing.capture ? timing.capture : timing.lastFragment);
+        }
+        m_frameExport.publishJpeg(frame.data, frame.frameId, timing);
+        postFrame(frame.data, frame.frameId, timing);
+    } else {
+        qDebug() << "Invalid complete frame for frame ID:" << frame.frameId;
+    }
+}
 
-    // Store the fragment
-    assembly.fragments[fragmentIndex] = fragmentData;
-    assembly.receivedFragments++;
-
-    qDebug() << "Received fragment" << fragmentIndex << "/" << totalFragments
-             << "for frame" << frameId << "(" << assembly.receivedFragments << "/" << totalFragments << ")";
+void ThermalCameraModel::postFrame(const QByteArray &frameData, quint16 frameId, FrameTiming timing)
+{
+    // Only the newest frame is kept if the GUI thread falls behind
+    timing.reassembled = FrameTiming::now();
+    if (m_frameMailbox && m_frameMailbox->post(frameData, frameId, timing)) {
+        emit framePending();
+    }
+}
 
-    // Check if frame is complete
-    if (assembly.receivedFragments == assembly.totalFragments) {
-        // Reassemble the complete frame
-        QByteArray completeFrame;
-        for (const QByteArray& fragment : assembly.fragments) {
-            completeFrame.append(fragment);
-        }
+void ThermalCameraModel::setMulticastGroup(const QString &group)
+{
+    // Takes effect the next time streaming starts
+    const QHostAddress address(group.trimmed());
+    if (!group.trimmed().isEmpty() && !address.isMulticast()) {
+        emit errorOccurred(group + " is not a multicast group, receiving unicast");
+        m_multicastGroup.clear();
+        return;
+    }
+    m_multicastGroup = address;
+}
 
-        qDebug() << "Frame" << frameId << "complete, total size:" << completeFrame.size();
+void ThermalCameraModel::setRelayDestinations(const QStringList &destinations)
+{
+    QList<UdpRelay::Destination> parsed;
+    QString error;
+    if (!UdpRelay::parseDestinations(destinations, &parsed, &error) || !m_relay.setDestinations(parsed, &error)) {
+        emit errorOccurred("Relay: " + error);
+        m_relay.setDestinations({});
+    }
+}
 
-        // Validate and emit the complete frame
-        if (isValidJpegFrame(completeFrame)) {
-            emit frameReceived(completeFrame);
-            qDebug() << "Valid complete frame emitted for frame ID:" << frameId;
-        } else {
-            qDebug() << "Invalid complete frame for frame ID:" << frameId;
-        }
+void ThermalCameraModel::setRelayOnly(bool enabled)
+{
+    m_relayOnly.store(enabled, std::memory_order_relaxed);
+}
 
-        // Remove completed frame from incomplete frames
-        m_incompleteFrames.remove(frameId);
+void ThermalCameraModel::setFrameExport(const QString &name)
+{
+    if (name.isEmpty()) {
+        m_frameExport.close();
+    } else if (!m_frameExport.open(name, FrameExportSlots, FrameExportSlotCapacity)) {
+        emit errorOccurred("Cannot export frames to shared memory " + name + ": " + m_frameExport.errorString());
     }
 }
 
-void ThermalCameraModel::cleanupIncompleteFrames()
+void ThermalCameraModel::setProgressiveDisplay(bool enabled)
 {
     QMutexLocker locker(&m_bufferMutex);
+    m_progressiveDisplay = enabled;
+}
 
-    qint64 currentTime = QDateTime::currentMSecsSinceEpoch();
-    QList<quint32> framesToRemove;
+void ThermalCameraModel::postPartialFrame()
+{
+    FrameReassembler<>::Frame prefix;
+    if (!m_frameMailbox || !m_reassembler.takePrefix(PartialFrameSteps, &prefix)) {
+        return;
+    }
 
-    for (auto it = m_incompleteFrames.begin(); it != m_incompleteFrames.end(); ++it) {
-        if (currentTime - it.value().timestamp > m_fragmentTimeout) {
-            framesToRemove.append(it.key());
-        }
+    LatestFrameMailbox::Frame partial;
+    if (!PartialJpeg::truncateAtRestart(prefix.data, &partial.data, &partial.partialRows, &partial.partialHeight)) {
+        return;     // no restart interval, or no marker received yet
+    }
+    partial.frameId = prefix.frameId;
+
+    // Without a jitter buffer the previous complete frame may still wait in the mailbox;
+    // the mailbox keeps it rather than this partial. Left out of the latency statistics,
+    // they describe complete frames.
+    if (m_frameMailbox->post(std::move(partial))) {
+        emit framePending();
     }
+}
 
-    for (quint16  frameId : framesToRemove) {
+void ThermalCameraModel::cleanupIncompleteFrames()
+{
+    QMutexLocker locker(&m_bufferMutex);
+
+    const QList<quint16> expired = m_reassembler.expireFrames(QDateTime::currentMSecsSinceEpoch());
+    for (quint16 frameId : expired) {
         qDebug() << "Removing incomplete frame" << frameId << "due to timeout";
-        m_incompleteFrames.remove(frameId);
     }
+    if (m_linkStatistics && !expired.isEmpty()) {
+        m_linkStatistics->recordExpired(int(expired.size()));
+    }
+
+    emit fecStatisticsChanged(m_reassembler.recoveredFrames(), m_reassembler.unrecoverableFrames());
+    emit reassemblyStatisticsChanged(m_reassembler.bytesInUse(), m_reassembler.peakBytes(),
+                                     m_reassembler.evictedFrames());
+    emit relayStatisticsChanged(m_relay.forwardedDatagrams(), m_relay.droppedDatagrams());
+    emit frameExportStatisticsChanged(m_frameExport.publishedFrames(), m_frameExport.oversizedFrames());
 }
 
 void ThermalCameraModel::processBuffer()
@@ -240,7 +477,7 @@ void ThermalCameraModel::extractFramesFromBuffer()
 
         // Validate frame
         if (isValidJpegFrame(frameData)) {
-            emit frameReceived(frameData);
+            postFrame(frameData, 0);
             framesExtracted++;
             qDebug() << "Valid frame emitted, total extracted:" << framesExtracted;
         } else {
@@ -299,7 +536,7 @@ void ThermalCameraModel::clearBuffer()
 void ThermalCameraModel::clearIncompleteFrames()
 {
     QMutexLocker locker(&m_bufferMutex);
-    m_incompleteFrames.clear();
+    m_reassembler.clear();
     qDebug() << "Incomplete frames cleared";
 }
 
@@ -8,6 +8,16 @@
 #include <QMutex>
 #include <QNetworkDatagram>
 #include<QMap>
+#include <atomic>
+#include "framereassembler.h"
+#include "udpbatchreceiver.h"
+#include "ingestreactor.h"
+#include "latestframemailbox.h"
+#include "linkstatistics.h"
+#include "streamrecorder.h"
+#include "udpcapture.h"
+#include "udprelay.h"
+#include "sharedframering.h"
 class ThermalCameraModel : public QObject
 {
     Q_OBJECT
@@ -16,23 +26,52 @@ public:
     explicit ThermalCameraModel(QObject *parent = nullptr);
     ~ThermalCameraModel();
 
+    // Frames are handed to the view model through this mailbox, set before the model
+    // is moved to its thread
+    void setFrameMailbox(LatestFrameMailbox *mailbox) { m_frameMailbox = mailbox; }
+
+    // Link quality counters; set before the move as well. Written from the ingest thread
+    // (the IngestReactor shard when reactorIngest is on, this model's thread otherwise)
+    // and from this model's cleanup timer, under m_bufferMutex or after ingest stopped,
+    // so there is only ever one writer at a time.
+    void setLinkStatistics(LinkStatistics *statistics) { m_linkStatistics = statistics; }
+
+    // Receives every complete, valid frame as it arrived; owned by the view model
+    void setStreamRecorder(StreamRecorder *recorder) { m_recorder = recorder; }
+
     struct ThermalCameraSettings {
         QString ipAddress;
         int port;
     };
 
-    // Structure for frame reassembly
-    struct FrameAssembly {
-        quint32 totalFragments;
-        quint32 receivedFragments;
-        QVector<QByteArray> fragments;
-        qint64 timestamp;
-    };
-
 public slots:
     void startStreaming(const QString &ipAddress, int port);
     void stopStreaming();
     bool isStreaming() const;
+    void setBatchedIngest(bool enabled);
+    void setReactorIngest(bool enabled);
+
+    // Multicast group to join instead of unicast reception, empty for unicast; applies
+    // the next time streaming starts
+    void setMulticastGroup(const QString &group);
+
+    // Forward every received datagram unmodified to these "host:port" stations, and
+    // optionally skip local reassembly and decoding altogether
+    void setRelayDestinations(const QStringList &destinations);
+    void setRelayOnly(bool enabled);
+
+    // Export every complete frame as received to the shared memory ring /name for local
+    // analytics processes, an empty name stops exporting
+    void setFrameExport(const QString &name);
+
+    // Raw datagram capture of the live stream, and replay of a capture in place of the
+    // socket (realTime keeps the original spacing, otherwise as fast as possible)
+    void startCapture(const QString &filePath);
+    void stopCapture();
+    void startReplay(const QString &filePath, bool realTime);
+
+    // Post the received top rows of frames still in flight, cut at a JPEG restart marker
+    void setProgressiveDisplay(bool enabled);
 
 private slots:
     void readPendingDatagrams();
@@ -42,12 +81,35 @@ private slots:
 
 signals:
     void streamingStatusChanged(bool streaming);
-    void frameReceived(const QByteArray &frameData);
+    void framePending();    // the frame mailbox went from empty to full
     void errorOccurred(const QString &error);
+    void captureStatusChanged(bool capturing, const QString &filePath);
+    void replayFinished(quint64 datagrams);
     void connectionEstablished();
+    void fecStatisticsChanged(quint64 recoveredFrames, quint64 unrecoverableFrames);
+    void reassemblyStatisticsChanged(qint64 bytesInUse, qint64 peakBytes, quint64 evictedFrames);
+    void relayStatisticsChanged(quint64 forwardedDatagrams, quint64 droppedDatagrams);
+    void frameExportStatisticsChanged(quint64 exportedFrames, quint64 oversizedFrames);
 
 private:
     QUdpSocket *m_udpSocket;
+    UdpBatchReceiver *m_batchReceiver;
+    bool m_reactorIngest;
+    int m_reactorStream;            // IngestReactor stream id, -1 when not used
+    UdpCaptureReplay *m_replay;     // stands in for the socket while replaying
+    UdpCaptureWriter m_capture;
+    QMutex m_captureMutex;          // the reactor writes captures from its own thread
+    std::atomic<bool> m_capturing{false};
+    QHostAddress m_multicastGroup;  // null for unicast
+    UdpRelay m_relay;               // fed from the ingest thread
+    std::atomic<bool> m_relayOnly{false};
+
+    // Shared memory export, written from the ingest thread
+    static constexpr int FrameExportSlots = 16;
+    static constexpr qsizetype FrameExportSlotCapacity = 2 * 1024 * 1024;
+    SharedFrameRing m_frameExport;
+
+    bool m_batchedIngest;
     QByteArray m_frameBuffer;
     QTimer *m_processTimer;
     QTimer *m_cleanupTimer;
@@ -56,19 +118,29 @@ private:
     QMutex m_bufferMutex;
 
     // Fragment reassembly
-    QMap<quint16, FrameAssembly> m_incompleteFrames;
     qint64 m_fragmentTimeout;
+    FrameReassembler<> m_reassembler;
+    LatestFrameMailbox *m_frameMailbox;
+    LinkStatistics *m_linkStatistics;
+    StreamRecorder *m_recorder;
+
+    // Progressive display, a frame is posted in at most this many parts before it completes
+    static constexpr int PartialFrameSteps = 4;
+    bool m_progressiveDisplay;
 
     // MJPEG parsing constants
     static const QByteArray JPEG_START_MARKER;
     static const QByteArray JPEG_END_MARKER;
 
     // Helper methods
-    void processFragmentedPacket(const QByteArray &packet);
+    void ingestDatagram(const char *packet, qsizetype size);
+    void processFragmentedPacket(const char *packet, qsizetype size);
+    void postPartialFrame();
     void extractFramesFromBuffer();
     bool isValidJpegFrame(const QByteArray &data);
     void clearBuffer();
     void clearIncompleteFrames();
+    void postFrame(const QByteArray &frameData, quint16 frameId, FrameTiming timing = FrameTiming());
 };
 
 #endif // THERMALCAMERAMODE
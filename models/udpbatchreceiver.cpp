@@ -0,0 +1,196 @@
+#include "udpbatchreceiver.h"
+#include <QSocketNotifier>
+#include <QDebug>
+
+#ifdef Q_OS_LINUX
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <netinet/in.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <cerrno>
+#include <cstring>
+#endif
+
+UdpBatchReceiver::UdpBatchReceiver(QObject *parent, int batchSize, int maxDatagramSize)
+    : QObject(parent)
+    , m_fd(-1)
+    , m_batchSize(batchSize)
+    , m_maxDatagramSize(maxDatagramSize)
+    , m_notifier(nullptr)
+{
+}
+
+UdpBatchReceiver::~UdpBatchReceiver()
+{
+    close();
+}
+
+bool UdpBatchReceiver::isSupported()
+{
+#ifdef Q_OS_LINUX
+    return true;
+#else
+    return false;
+#endif
+}
+
+int UdpBatchReceiver::openSocket(quint16 port, const QHostAddress &multicastGroup, QString *error)
+{
+#ifdef Q_OS_LINUX
+    const bool multicast = multicastGroup.isMulticast();
+    if (!multicastGroup.isNull() && (!multicast || multicastGroup.protocol() != QAbstractSocket::IPv4Protocol)) {
+        if (error) {
+            *error = QString("%1 is not an IPv4 multicast group").arg(multicastGroup.toString());
+        }
+        return -1;
+    }
+
+    const int fd = ::socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        if (error) {
+            *error = QString::fromLocal8Bit(strerror(errno));
+        }
+        return -1;
+    }
+
+    int reuse = 1;
+    ::setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+    // Give the kernel room to queue a few full frames while the thread is busy
+    int receiveBuffer = 8 * 1024 * 1024;
+    ::setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &receiveBuffer, sizeof(receiveBuffer));
+
+    // Bound to the group, the socket does not also get unicast traffic for the port
+    sockaddr_in address;
+    std::memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(multicast ? multicastGroup.toIPv4Address() : INADDR_ANY);
+    address.sin_port = htons(port);
+    if (::bind(fd, reinterpret_cast<sockaddr *>(&address), sizeof(address)) < 0) {
+        if (error) {
+            *error = QString::fromLocal8Bit(strerror(errno));
+        }
+        ::close(fd);
+        return -1;
+    }
+
+    if (multicast) {
+        ip_mreqn membership;
+        std::memset(&membership, 0, sizeof(membership));
+        membership.imr_multiaddr.s_addr = htonl(multicastGroup.toIPv4Address());
+        membership.imr_address.s_addr = htonl(INADDR_ANY);
+        if (::setsockopt(fd, IPPROTO_IP, IP_ADD_MEMBERSHIP, &membership, sizeof(membership)) < 0) {
+            if (error) {
+                *error = QString("Cannot join %1: %2").arg(multicastGroup.toString(), QString::fromLocal8Bit(strerror(errno)));
+            }
+            ::close(fd);
+            return -1;
+        }
+    }
+    return fd;
+#else
+    Q_UNUSED(port);
+    Q_UNUSED(multicastGroup);
+    if (error) {
+        *error = QStringLiteral("Batched UDP receive is not supported on this platform");
+    }
+    return -1;
+#endif
+}
+
+bool UdpBatchReceiver::bind(quint16 port, const QHostAddress &multicastGroup)
+{
+#ifdef Q_OS_LINUX
+    close();
+
+    m_fd = openSocket(port, multicastGroup, &m_errorString);
+    if (m_fd < 0) {
+        return false;
+    }
+
+    // Preallocate one buffer per batch entry, reused for every recvmmsg() call
+    m_storage.resize(qsizetype(m_batchSize) * m_maxDatagramSize);
+    m_messages.assign(size_t(m_batchSize), mmsghdr());
+    m_iovecs.assign(size_t(m_batchSize), iovec());
+    for (int i = 0; i < m_batchSize; ++i) {
+        m_iovecs[i].iov_base = m_storage.data() + qsizetype(i) * m_maxDatagramSize;
+        m_iovecs[i].iov_len = size_t(m_maxDatagramSize);
+        m_messages[i].msg_hdr.msg_iov = &m_iovecs[i];
+        m_messages[i].msg_hdr.msg_iovlen = 1;
+    }
+
+    m_notifier = new QSocketNotifier(m_fd, QSocketNotifier::Read, this);
+    connect(m_notifier, &QSocketNotifier::activated, this, &UdpBatchReceiver::onReadyRead);
+
+    qDebug() << "Batched UDP receiver bound to port" << port << "batch size:" << m_batchSize
+             << (multicastGroup.isNull() ? QString() : "group: " + multicastGroup.toString());
+    return true;
+#else
+    Q_UNUSED(port);
+    Q_UNUSED(multicastGroup);
+    m_errorString = QStringLiteral("Batched UDP receive is not supported on this platform");
+    return false;
+#endif
+}
+
+void UdpBatchReceiver::close()
+{
+#ifdef Q_OS_LINUX
+    if (m_notifier) {
+        m_notifier->setEnabled(false);
+        delete m_notifier;
+        m_notifier = nullptr;
+    }
+    if (m_fd >= 0) {
+        ::close(m_fd);
+        m_fd = -1;
+    }
+#endif
+}
+
+int UdpBatchReceiver::drain()
+{
+#ifdef Q_OS_LINUX
+    int total = 0;
+
+    while (m_fd >= 0) {
+        int received = ::recvmmsg(m_fd, m_messages.data(), unsigned(m_batchSize), MSG_DONTWAIT, nullptr);
+        if (received < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                m_errorString = QString::fromLocal8Bit(strerror(errno));
+                emit errorOccurred(m_errorString);
+            }
+            break;
+        }
+
+        for (int i = 0; i < received; ++i) {
+            const mmsghdr &message = m_messages[size_t(i)];
+            if (message.msg_hdr.msg_flags & MSG_TRUNC) {
+                qDebug() << "Dropping truncated datagram larger than" << m_maxDatagramSize << "bytes";
+                continue;
+            }
+            if (message.msg_len > 0 && m_handler) {
+                m_handler(static_cast<const char *>(m_iovecs[size_t(i)].iov_base), qsizetype(message.msg_len));
+            }
+        }
+
+        total += received;
+        if (received < m_batchSize) {
+            break;
+        }
+    }
+
+    return total;
+#else
+    return 0;
+#endif
+}
+
+void UdpBatchReceiver::onReadyRead()
+{
+    drain();
+}
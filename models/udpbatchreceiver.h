@@ -0,0 +1,69 @@
+#ifndef UDPBATCHRECEIVER_H
+#define UDPBATCHRECEIVER_H
+
+#include <QObject>
+#include <QByteArray>
+#include <QHostAddress>
+#include <QString>
+#include <functional>
+#include <vector>
+
+class QSocketNotifier;
+struct mmsghdr;
+struct iovec;
+
+// Batched UDP receive backend for the video ingest path.
+//
+// On Linux the socket is drained with recvmmsg() into preallocated buffers, so a
+// burst of fragments costs one syscall per batch instead of one syscall plus one
+// QNetworkDatagram allocation per fragment. Each datagram is handed to the handler
+// as a pointer into the receive buffers, valid only for the duration of the call.
+// Elsewhere isSupported() returns false and callers keep using QUdpSocket.
+class UdpBatchReceiver : public QObject
+{
+    Q_OBJECT
+
+public:
+    using DatagramHandler = std::function<void(const char *data, qsizetype size)>;
+
+    explicit UdpBatchReceiver(QObject *parent = nullptr, int batchSize = 32, int maxDatagramSize = 65536);
+    ~UdpBatchReceiver();
+
+    static bool isSupported();
+
+    // Non-blocking UDP socket bound to port, also used by IngestReactor. With a multicast
+    // group the socket is bound to the group and joins it on the default interface;
+    // address reuse lets every process on the host that joins the group receive it.
+    // Returns the descriptor, or -1 with error set.
+    static int openSocket(quint16 port, const QHostAddress &multicastGroup, QString *error);
+
+    // A null multicastGroup receives unicast datagrams sent to any local address
+    bool bind(quint16 port, const QHostAddress &multicastGroup = QHostAddress());
+    void close();
+    bool isBound() const { return m_fd >= 0; }
+    QString errorString() const { return m_errorString; }
+
+    void setDatagramHandler(DatagramHandler handler) { m_handler = std::move(handler); }
+
+    // Reads every datagram currently queued on the socket, returns how many were read
+    int drain();
+
+signals:
+    void errorOccurred(const QString &error);
+
+private slots:
+    void onReadyRead();
+
+private:
+    int m_fd;
+    int m_batchSize;
+    int m_maxDatagramSize;
+    QSocketNotifier *m_notifier;
+    QByteArray m_storage;
+    std::vector<mmsghdr> m_messages;
+    std::vector<iovec> m_iovecs;
+    DatagramHandler m_handler;
+    QString m_errorString;
+};
+
+#endif // UDPBATCHRECEIVER_H
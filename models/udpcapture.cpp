@@ -0,0 +1,190 @@
+#include "udpcapture.h"
+#include <QTimer>
+#include <QtEndian>
+#include <cstring>
+
+namespace {
+
+constexpr qsizetype FlushThreshold = 1024 * 1024;
+
+}
+
+UdpCaptureWriter::~UdpCaptureWriter()
+{
+    close();
+}
+
+bool UdpCaptureWriter::open(const QString &filePath)
+{
+    close();
+
+    m_file.setFileName(filePath);
+    if (!m_file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        return false;
+    }
+
+    QByteArray header(UdpCaptureFormat::HeaderSize, '\0');
+    std::memcpy(header.data(), UdpCaptureFormat::Magic, sizeof(UdpCaptureFormat::Magic));
+    qToLittleEndian<quint32>(UdpCaptureFormat::Version, header.data() + 8);
+    if (m_file.write(header) != header.size()) {
+        m_file.close();
+        return false;
+    }
+
+    m_pending.clear();
+    m_pending.reserve(FlushThreshold + UdpCaptureFormat::MaxDatagramSize);
+    m_datagrams = 0;
+    return true;
+}
+
+bool UdpCaptureWriter::write(const char *data, qsizetype size, qint64 arrivalUs)
+{
+    if (!m_file.isOpen() || size <= 0 || size > qsizetype(UdpCaptureFormat::MaxDatagramSize)) {
+        return false;
+    }
+
+    char record[UdpCaptureFormat::RecordHeaderSize];
+    qToLittleEndian<qint64>(arrivalUs, record);
+    qToLittleEndian<quint32>(quint32(size), record + 8);
+    m_pending.append(record, sizeof(record));
+    m_pending.append(data, size);
+    m_datagrams++;
+
+    return m_pending.size() < FlushThreshold || flush();
+}
+
+bool UdpCaptureWriter::flush()
+{
+    if (m_pending.isEmpty()) {
+        return true;
+    }
+    const bool written = m_file.write(m_pending) == m_pending.size();
+    m_pending.clear();
+    return written;
+}
+
+void UdpCaptureWriter::close()
+{
+    if (!m_file.isOpen()) {
+        return;
+    }
+    flush();
+    m_file.close();
+}
+
+bool UdpCaptureReader::open(const QString &filePath)
+{
+    m_file.close();
+    m_file.setFileName(filePath);
+    if (!m_file.open(QIODevice::ReadOnly)) {
+        m_errorString = m_file.errorString();
+        return false;
+    }
+
+    const QByteArray header = m_file.read(UdpCaptureFormat::HeaderSize);
+    if (header.size() != UdpCaptureFormat::HeaderSize
+        || std::memcmp(header.constData(), UdpCaptureFormat::Magic, sizeof(UdpCaptureFormat::Magic)) != 0) {
+        m_errorString = "Not a UDP capture file";
+        m_file.close();
+        return false;
+    }
+
+    const quint32 version = qFromLittleEndian<quint32>(header.constData() + 8);
+    if (version != UdpCaptureFormat::Version) {
+        m_errorString = QString("Unsupported capture version %1").arg(version);
+        m_file.close();
+        return false;
+    }
+
+    m_errorString.clear();
+    return true;
+}
+
+bool UdpCaptureReader::readNext(Datagram *datagram)
+{
+    char record[UdpCaptureFormat::RecordHeaderSize];
+    if (m_file.read(record, sizeof(record)) != qint64(sizeof(record))) {
+        return false;
+    }
+
+    const quint32 size = qFromLittleEndian<quint32>(record + 8);
+    if (size == 0 || size > UdpCaptureFormat::MaxDatagramSize) {
+        m_errorString = "Corrupt capture record";
+        return false;
+    }
+
+    datagram->arrivalUs = qFromLittleEndian<qint64>(record);
+    datagram->data = m_file.read(size);
+    if (datagram->data.size() != qsizetype(size)) {
+        m_errorString = "Truncated capture record";
+        return false;
+    }
+    return true;
+}
+
+UdpCaptureReplay::UdpCaptureReplay(QObject *parent)
+    : QObject(parent)
+    , m_timer(new QTimer(this))
+{
+    m_timer->setSingleShot(true);
+    m_timer->setTimerType(Qt::PreciseTimer);
+    connect(m_timer, &QTimer::timeout, this, &UdpCaptureReplay::replayDue);
+}
+
+bool UdpCaptureReplay::start(const QString &filePath, Pacing pacing)
+{
+    stop();
+
+    if (!m_reader.open(filePath)) {
+        return false;
+    }
+
+    m_pacing = pacing;
+    m_datagrams = 0;
+    m_hasNext = m_reader.readNext(&m_next);
+    m_firstArrivalUs = m_next.arrivalUs;
+    m_running = true;
+    m_clock.start();
+    m_timer->start(0);
+    return true;
+}
+
+void UdpCaptureReplay::stop()
+{
+    m_timer->stop();
+    m_reader.close();
+    m_hasNext = false;
+    m_running = false;
+}
+
+void UdpCaptureReplay::replayDue()
+{
+    int handled = 0;
+    while (m_hasNext) {
+        if (m_pacing == Pacing::RealTime) {
+            const qint64 dueUs = m_next.arrivalUs - m_firstArrivalUs;
+            const qint64 waitMs = (dueUs - m_clock.nsecsElapsed() / 1000) / 1000;
+            if (waitMs > 0) {
+                m_timer->start(int(qMin<qint64>(waitMs, 1000)));
+                return;
+            }
+        } else if (handled == FastBatchSize) {
+            m_timer->start(0);
+            return;
+        }
+
+        if (m_handler) {
+            m_handler(m_next.data.constData(), m_next.data.size());
+            if (!m_running) {
+                return;     // stopped by the handler
+            }
+        }
+        m_datagrams++;
+        handled++;
+        m_hasNext = m_reader.readNext(&m_next);
+    }
+
+    m_reader.close();
+    m_running = false;
+    emit finished(m_datagrams);
+}
@@ -0,0 +1,124 @@
+#ifndef UDPCAPTURE_H
+#define UDPCAPTURE_H
+
+#include <QObject>
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QString>
+#include <functional>
+
+class QTimer;
+
+// Capture files of the raw video datagrams received by a camera model, used to
+// reproduce link problems and benchmark ingest without the gimbal.
+//
+// Layout, little endian: a 16 byte file header, magic "MARSUDP1" + version(4) +
+// reserved(4), then one record per datagram: arrival time in microseconds since the
+// epoch(8) + length(4) + the datagram bytes.
+struct UdpCaptureFormat
+{
+    static constexpr char Magic[8] = { 'M', 'A', 'R', 'S', 'U', 'D', 'P', '1' };
+    static constexpr quint32 Version = 1;
+    static constexpr qsizetype HeaderSize = 16;
+    static constexpr qsizetype RecordHeaderSize = 12;
+    static constexpr quint32 MaxDatagramSize = 65536;
+};
+
+// Appends datagrams to a capture file. Records are collected in memory and written in
+// blocks of about 1 MB, so the ingest thread does not issue a write per datagram.
+class UdpCaptureWriter
+{
+public:
+    UdpCaptureWriter() = default;
+    ~UdpCaptureWriter();
+
+    UdpCaptureWriter(const UdpCaptureWriter &) = delete;
+    UdpCaptureWriter &operator=(const UdpCaptureWriter &) = delete;
+
+    bool open(const QString &filePath);
+    bool write(const char *data, qsizetype size, qint64 arrivalUs);
+    void close();
+
+    bool isOpen() const { return m_file.isOpen(); }
+    QString errorString() const { return m_file.errorString(); }
+    quint64 datagrams() const { return m_datagrams; }
+
+private:
+    bool flush();
+
+    QFile m_file;
+    QByteArray m_pending;
+    quint64 m_datagrams = 0;
+};
+
+// Reads a capture file record by record
+class UdpCaptureReader
+{
+public:
+    struct Datagram {
+        qint64 arrivalUs = 0;
+        QByteArray data;
+    };
+
+    bool open(const QString &filePath);
+    void close() { m_file.close(); }
+
+    // False at the end of the file or on a truncated record
+    bool readNext(Datagram *datagram);
+
+    QString errorString() const { return m_errorString; }
+
+private:
+    QFile m_file;
+    QString m_errorString;
+};
+
+// Replays a capture file into a datagram handler on the caller's thread, either with the
+// original spacing between datagrams or as fast as possible. Fast replay hands over the
+// datagrams in batches and returns to the event loop in between, so the receiving model
+// still runs its timers.
+class UdpCaptureReplay : public QObject
+{
+    Q_OBJECT
+
+public:
+    using DatagramHandler = std::function<void(const char *data, qsizetype size)>;
+
+    enum class Pacing {
+        RealTime,
+        AsFastAsPossible
+    };
+
+    explicit UdpCaptureReplay(QObject *parent = nullptr);
+
+    void setDatagramHandler(DatagramHandler handler) { m_handler = std::move(handler); }
+
+    bool start(const QString &filePath, Pacing pacing);
+    void stop();
+    bool isRunning() const { return m_running; }
+    QString errorString() const { return m_reader.errorString(); }
+    quint64 datagrams() const { return m_datagrams; }
+
+signals:
+    void finished(quint64 datagrams);
+
+private slots:
+    void replayDue();
+
+private:
+    static constexpr int FastBatchSize = 256;
+
+    UdpCaptureReader m_reader;
+    UdpCaptureReader::Datagram m_next;
+    bool m_hasNext = false;
+    bool m_running = false;
+    Pacing m_pacing = Pacing::RealTime;
+    qint64 m_firstArrivalUs = 0;
+    QElapsedTimer m_clock;
+    QTimer *m_timer;
+    DatagramHandler m_handler;
+    quint64 m_datagrams = 0;
+};
+
+#endif // UDPCAPTURE_H
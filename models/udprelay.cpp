@@ -0,0 +1,168 @@
+#include "udprelay.h"
+#include <QDebug>
+#include <QUdpSocket>
+
+#ifdef Q_OS_LINUX
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <netinet/in.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+#endif
+
+UdpRelay::UdpRelay()
+{
+}
+
+UdpRelay::~UdpRelay()
+{
+    closeSocket();
+}
+
+bool UdpRelay::parseDestinations(const QStringList &entries, QList<Destination> *destinations, QString *error)
+{
+    destinations->clear();
+    for (const QString &entry : entries) {
+        const QString trimmed = entry.trimmed();
+        if (trimmed.isEmpty()) {
+            continue;
+        }
+
+        const qsizetype colon = trimmed.lastIndexOf(':');
+        bool portValid = false;
+        const uint port = colon > 0 ? trimmed.mid(colon + 1).toUInt(&portValid) : 0;
+        Destination destination;
+        destination.address = QHostAddress(trimmed.left(colon));
+        destination.port = quint16(port);
+        if (!portValid || port == 0 || port > 65535
+            || destination.address.protocol() != QAbstractSocket::IPv4Protocol) {
+            if (error) {
+                *error = QString("Invalid relay destination \"%1\", expected IPv4 address:port").arg(trimmed);
+            }
+            return false;
+        }
+        destinations->append(destination);
+    }
+    return true;
+}
+
+bool UdpRelay::setDestinations(const QList<Destination> &destinations, QString *error)
+{
+#ifdef Q_OS_LINUX
+    QMutexLocker locker(&m_mutex);
+    if (destinations.isEmpty()) {
+        m_active.store(false, std::memory_order_relaxed);
+        closeSocket();
+        return true;
+    }
+
+    if (m_fd < 0) {
+        m_fd = ::socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (m_fd < 0) {
+            if (error) {
+                *error = QString::fromLocal8Bit(strerror(errno));
+            }
+            m_active.store(false, std::memory_order_relaxed);
+            return false;
+        }
+
+        // Room for a few frames to every station before sends start to drop
+        int sendBuffer = 8 * 1024 * 1024;
+        ::setsockopt(m_fd, SOL_SOCKET, SO_SNDBUF, &sendBuffer, sizeof(sendBuffer));
+    }
+
+    m_addresses.assign(size_t(destinations.size()), sockaddr_in());
+    m_messages.assign(size_t(destinations.size()), mmsghdr());
+    m_iovec.assign(1, iovec());
+    for (qsizetype i = 0; i < destinations.size(); ++i) {
+        sockaddr_in &address = m_addresses[size_t(i)];
+        address.sin_family = AF_INET;
+        address.sin_addr.s_addr = htonl(destinations.at(i).address.toIPv4Address());
+        address.sin_port = htons(destinations.at(i).port);
+
+        msghdr &header = m_messages[size_t(i)].msg_hdr;
+        header.msg_name = &address;
+        header.msg_namelen = sizeof(address);
+        header.msg_iov = m_iovec.data();
+        header.msg_iovlen = 1;
+    }
+    m_active.store(true, std::memory_order_relaxed);
+#else
+    Q_UNUSED(error);
+    QMutexLocker locker(&m_mutex);
+    m_destinations = destinations;
+    m_active.store(!destinations.isEmpty(), std::memory_order_relaxed);
+    if (destinations.isEmpty()) {
+        return true;
+    }
+#endif
+
+    qDebug() << "Relaying video datagrams to" << destinations.size() << "stations";
+    return true;
+}
+
+void UdpRelay::forward(const char *data, qsizetype size)
+{
+#ifdef Q_OS_LINUX
+    if (!isActive() || size <= 0) {
+        return;
+    }
+
+    QMutexLocker locker(&m_mutex);
+    if (m_fd < 0) {
+        return;
+    }
+    m_iovec[0].iov_base = const_cast<char *>(data);
+    m_iovec[0].iov_len = size_t(size);
+
+    // sendmmsg() stops at the first destination that fails, the error is reported by the
+    // next call; skip that destination and carry on with the rest
+    const unsigned count = unsigned(m_messages.size());
+    unsigned next = 0;
+    while (next < count) {
+        const int sent = ::sendmmsg(m_fd, m_messages.data() + next, count - next, MSG_DONTWAIT);
+        if (sent < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            m_dropped.fetch_add(1, std::memory_order_relaxed);
+            next++;
+            continue;
+        }
+        m_forwarded.fetch_add(quint64(sent), std::memory_order_relaxed);
+        next += unsigned(sent);
+    }
+#else
+    if (!isActive() || size <= 0) {
+        return;
+    }
+
+    QMutexLocker locker(&m_mutex);
+    if (!m_socket) {
+        m_socket = std::make_unique<QUdpSocket>();
+        if (!m_socket->bind(QHostAddress::AnyIPv4, 0)) {
+            qWarning() << "Video relay socket:" << m_socket->errorString();
+        } else {
+            m_socket->setSocketOption(QAbstractSocket::SendBufferSizeSocketOption, 8 * 1024 * 1024);
+        }
+    }
+    for (const Destination &destination : std::as_const(m_destinations)) {
+        if (m_socket->writeDatagram(data, size, destination.address, destination.port) == size) {
+            m_forwarded.fetch_add(1, std::memory_order_relaxed);
+        } else {
+            m_dropped.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+#endif
+}
+
+void UdpRelay::closeSocket()
+{
+#ifdef Q_OS_LINUX
+    if (m_fd >= 0) {
+        ::close(m_fd);
+        m_fd = -1;
+    }
+#endif
+}
@@ -0,0 +1,72 @@
+#ifndef UDPRELAY_H
+#define UDPRELAY_H
+
+#include <QHostAddress>
+#include <QList>
+#include <QMutex>
+#include <QString>
+#include <QStringList>
+#include <atomic>
+#include <memory>
+#include <vector>
+
+class QUdpSocket;
+
+struct mmsghdr;
+struct iovec;
+struct sockaddr_in;
+
+// Forwards the raw video datagrams of one stream, unmodified, to other stations.
+//
+// The camera model calls forward() from its ingest thread with each datagram as it was
+// received, before reassembly. The datagram is sent straight out of the receive buffer
+// to every destination with a single sendmmsg(), all messages sharing one iovec, so the
+// fan-out copies nothing in user space and costs one syscall whatever the number of
+// stations; the airborne link carries the stream once however many consoles watch it.
+// Sends never block the ingest thread: a datagram the socket buffer cannot take is
+// dropped for that destination and counted. Other platforms fall back to one
+// non-blocking QUdpSocket::writeDatagram() per destination, with the same drop counting;
+// that socket is created on the first forward() and so belongs to the ingest thread.
+class UdpRelay
+{
+public:
+    struct Destination {
+        QHostAddress address;
+        quint16 port = 0;
+    };
+
+    UdpRelay();
+    ~UdpRelay();
+
+    UdpRelay(const UdpRelay &) = delete;
+    UdpRelay &operator=(const UdpRelay &) = delete;
+
+    // "host:port" entries, IPv4 unicast or multicast; false on the first invalid one
+    static bool parseDestinations(const QStringList &entries, QList<Destination> *destinations, QString *error);
+
+    // Replaces the destinations, an empty list stops relaying. Thread safe.
+    bool setDestinations(const QList<Destination> &destinations, QString *error = nullptr);
+    bool isActive() const { return m_active.load(std::memory_order_relaxed); }
+
+    // Thread safe, does nothing unless destinations are set
+    void forward(const char *data, qsizetype size);
+
+    quint64 forwardedDatagrams() const { return m_forwarded.load(std::memory_order_relaxed); }
+    quint64 droppedDatagrams() const { return m_dropped.load(std::memory_order_relaxed); }
+
+private:
+    void closeSocket();
+
+    QMutex m_mutex;                 // destinations, held while sending
+    int m_fd = -1;
+    std::vector<sockaddr_in> m_addresses;
+    std::vector<mmsghdr> m_messages;
+    std::vector<iovec> m_iovec;     // the single iovec every message points to
+    QList<Destination> m_destinations;
+    std::unique_ptr<QUdpSocket> m_socket;   // the fallback sender
+    std::atomic<bool> m_active{false};
+    std::atomic<quint64> m_forwarded{0};
+    std::atomic<quint64> m_dropped{0};
+};
+
+#endif // UDPRELAY_H
@@ -0,0 +1,157 @@
+// Replays a UDP capture recorded by the ground station through the fragment
+// reassembler, without a camera or a socket. The reassembler's clock is driven by the
+// captured arrival times, so a replay reproduces the same completed, duplicate and
+// expired frames on every run regardless of pacing. With --realtime the datagrams are
+// handed over with their original spacing, otherwise as fast as possible, which makes
+// the run a repeatable ingest throughput benchmark.
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QTextStream>
+#include <QThread>
+#include "models/framereassembler.h"
+#include "models/udpcapture.h"
+
+namespace {
+
+struct ReplayResult {
+    qint64 datagrams = 0;
+    qint64 bytes = 0;
+    qint64 frames = 0;
+    qint64 duplicates = 0;
+    qint64 malformed = 0;
+    qint64 stale = 0;           // behind the reorder window
+    qint64 expired = 0;
+    qint64 evicted = 0;
+    qint64 incomplete = 0;      // still assembling at the end of the capture
+    qint64 peakBytes = 0;       // reassembly buffers held at most
+    qint64 capturedUs = 0;      // span of the capture
+    qint64 elapsedNs = 0;
+};
+
+bool replay(const QString &filePath, bool realTime, qint64 timeoutMs, ReplayResult &result, QString *error)
+{
+    UdpCaptureReader reader;
+    if (!reader.open(filePath)) {
+        *error = reader.errorString();
+        return false;
+    }
+
+    FrameReassembler<> reassembler(timeoutMs);
+    FrameReassembler<>::Frame frame;
+    UdpCaptureReader::Datagram datagram;
+    qint64 firstArrivalUs = -1;
+    qint64 lastExpiryMs = 0;
+
+    QElapsedTimer timer;
+    timer.start();
+    while (reader.readNext(&datagram)) {
+        if (firstArrivalUs < 0) {
+            firstArrivalUs = datagram.arrivalUs;
+        }
+        const qint64 offsetUs = datagram.arrivalUs - firstArrivalUs;
+        if (realTime) {
+            const qint64 waitUs = offsetUs - timer.nsecsElapsed() / 1000;
+            if (waitUs > 0) {
+                QThread::usleep(quint64(waitUs));
+            }
+        }
+
+        // Same once a second expiry as the camera models, on the captured clock
+        const qint64 nowMs = datagram.arrivalUs / 1000;
+        if (nowMs - lastExpiryMs >= 1000) {
+            result.expired += reassembler.expireFrames(nowMs).size();
+            lastExpiryMs = nowMs;
+        }
+
+        result.datagrams++;
+        result.bytes += datagram.data.size();
+        switch (reassembler.addFragment(datagram.data.constData(), datagram.data.size(), nowMs, &frame)) {
+        case FrameReassembler<>::Result::Complete:
+            result.frames++;
+            // Like the models, older frames are no longer assembled once a newer one is out
+            reassembler.markDelivered(frame.frameId);
+            break;
+        case FrameReassembler<>::Result::Duplicate:
+            result.duplicates++;
+            break;
+        case FrameReassembler<>::Result::Malformed:
+            result.malformed++;
+            break;
+        case FrameReassembler<>::Result::Stale:
+            result.stale++;
+            break;
+        case FrameReassembler<>::Result::Incomplete:
+            break;
+        }
+        result.capturedUs = offsetUs;
+    }
+    result.elapsedNs = timer.nsecsElapsed();
+    result.evicted = qint64(reassembler.evictedFrames());
+    result.incomplete = reassembler.pendingFrames();
+    result.peakBytes = reassembler.peakBytes();
+
+    if (!reader.errorString().isEmpty()) {
+        *error = reader.errorString();     // truncated tail, the result covers what was read
+    }
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("mars_capture_replay");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Replays a UDP capture through the fragment reassembler");
+    parser.addHelpOption();
+    parser.addPositionalArgument("capture", "Capture file (.udpcap) to replay.");
+    QCommandLineOption realTimeOption("realtime", "Keep the captured spacing between datagrams.");
+    QCommandLineOption timeoutOption("timeout", "Incomplete frame timeout in milliseconds.", "ms", "5000");
+    QCommandLineOption repeatOption("repeat", "Number of replays, reported separately.", "count", "1");
+    parser.addOptions({realTimeOption, timeoutOption, repeatOption});
+    parser.process(app);
+
+    const QStringList files = parser.positionalArguments();
+    if (files.size() != 1) {
+        parser.showHelp(1);
+    }
+
+    const bool realTime = parser.isSet(realTimeOption);
+    const qint64 timeoutMs = qMax(1, parser.value(timeoutOption).toInt());
+    const int repeat = qMax(1, parser.value(repeatOption).toInt());
+
+    QTextStream out(stdout);
+    for (int run = 0; run < repeat; ++run) {
+        ReplayResult result;
+        QString error;
+        if (!replay(files.first(), realTime, timeoutMs, result, &error)) {
+            out << "Cannot replay " << files.first() << ": " << error << Qt::endl;
+            return 1;
+        }
+        if (!error.isEmpty()) {
+            out << "warning: " << error << Qt::endl;
+        }
+
+        const double seconds = result.elapsedNs / 1e9;
+        out << "run " << run + 1
+            << "  datagrams: " << result.datagrams
+            << "  frames: " << result.frames
+            << "  duplicates: " << result.duplicates
+            << "  malformed: " << result.malformed
+            << "  stale: " << result.stale
+            << "  expired: " << result.expired
+            << "  evicted: " << result.evicted
+            << "  incomplete: " << result.incomplete
+            << "  peak KB: " << result.peakBytes / 1024
+            << "  captured s: " << QString::number(result.capturedUs / 1e6, 'f', 2)
+            << "  replay s: " << QString::number(seconds, 'f', 3)
+            << "  datagrams/s: " << qint64(seconds > 0 ? result.datagrams / seconds : 0)
+            << "  MB/s: " << QString::number(seconds > 0 ? result.bytes / seconds / (1024 * 1024) : 0, 'f', 1)
+            << Qt::endl;
+    }
+
+    return 0;
+}
@@ -0,0 +1,124 @@
+// Attaches to a frame ring the ground station exports to shared memory and reports
+// what an analytics process would see: frames read per second, frames the writer
+// overwrote before they were read, frames torn while being read, the delay from
+// reassembly to the read and the telemetry stamped into the newest frame. It doubles as
+// the reference for reading the ring: the frame is used in place and only trusted once
+// isValid() confirms the writer did not lap the reader meanwhile.
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QTextStream>
+#include <QThread>
+#include "models/sharedframering.h"
+
+namespace {
+
+struct ReadStatistics {
+    qint64 frames = 0;
+    qint64 torn = 0;            // overwritten while being read
+    qint64 invalid = 0;         // a JPEG slot without a JPEG start marker
+    qint64 bytes = 0;
+    qint64 latencyUs = 0;       // summed, reassembled to read
+};
+
+// Stands in for the analytics: touches every byte of the frame where it lies
+quint32 checksum(const char *data, qsizetype size)
+{
+    quint32 sum = 0;
+    for (qsizetype i = 0; i < size; ++i) {
+        sum = sum * 31 + quint8(data[i]);
+    }
+    return sum;
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("mars_frame_export_reader");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Reads the frames a ground station exports to shared memory");
+    parser.addHelpOption();
+    parser.addPositionalArgument("name", "Shared memory ring name, as set in frameExportName.");
+    QCommandLineOption pollOption("poll", "Polling interval in milliseconds.", "ms", "2");
+    QCommandLineOption durationOption("duration", "Seconds to run, 0 runs until interrupted.", "s", "0");
+    parser.addOptions({pollOption, durationOption});
+    parser.process(app);
+
+    const QStringList names = parser.positionalArguments();
+    if (names.size() != 1) {
+        parser.showHelp(1);
+    }
+    const QString name = names.first();
+    const int pollMs = qMax(0, parser.value(pollOption).toInt());
+    const qint64 durationMs = qMax(0, parser.value(durationOption).toInt()) * qint64(1000);
+
+    QTextStream out(stdout);
+    SharedFrameRingReader reader;
+    qint64 created = 0;
+    ReadStatistics statistics;
+    SharedFrameRingFormat::Telemetry telemetry;
+    quint64 skippedReported = 0;
+    volatile quint32 sink = 0;    // keeps the checksum from being optimized out
+
+    QElapsedTimer runTimer;
+    runTimer.start();
+    QElapsedTimer reportTimer;
+    reportTimer.start();
+    while (durationMs == 0 || runTimer.elapsed() < durationMs) {
+        // The writer replaces the ring when the ground station restarts or reconfigures
+        if (!reader.isOpen() || reader.created() != created) {
+            if (!reader.open(name)) {
+                out << "Waiting for " << name << ": " << reader.errorString() << Qt::endl;
+                QThread::msleep(1000);
+                continue;
+            }
+            created = reader.created();
+            skippedReported = reader.skippedFrames();
+            out << "Attached to " << name << Qt::endl;
+        }
+
+        SharedFrameRingReader::Frame frame;
+        if (reader.next(&frame)) {
+            const bool jpeg = frame.metadata.kind == SharedFrameRingFormat::Jpeg;
+            const bool startMarker = frame.size >= 2 && quint8(frame.data[0]) == 0xff && quint8(frame.data[1]) == 0xd8;
+            sink = checksum(frame.data, frame.size);
+            if (!reader.isValid(frame)) {
+                statistics.torn++;
+            } else if (jpeg && !startMarker) {
+                statistics.invalid++;
+            } else {
+                statistics.frames++;
+                statistics.bytes += frame.size;
+                if (frame.metadata.reassembled) {
+                    statistics.latencyUs += FrameTiming::now() - frame.metadata.reassembled;
+                }
+                telemetry = frame.metadata.telemetry;
+            }
+        } else if (pollMs > 0) {
+            QThread::msleep(quint64(pollMs));
+        }
+
+        if (reportTimer.elapsed() >= 1000) {
+            const double seconds = reportTimer.nsecsElapsed() / 1e9;
+            out << "frames/s: " << QString::number(statistics.frames / seconds, 'f', 1)
+                << "  MB/s: " << QString::number(statistics.bytes / seconds / (1024 * 1024), 'f', 1)
+                << "  skipped: " << reader.skippedFrames() - skippedReported
+                << "  torn: " << statistics.torn
+                << "  invalid: " << statistics.invalid
+                << "  latency ms: " << QString::number(statistics.frames ? statistics.latencyUs / 1000.0 / statistics.frames : 0, 'f', 2);
+            if (telemetry.received) {
+                out << "  telemetry age ms: " << (FrameTiming::now() - telemetry.received) / 1000
+                    << "  roll/pitch/yaw: " << telemetry.gimbalRoll << '/' << telemetry.gimbalPitch << '/' << telemetry.gimbalYaw;
+            }
+            out << Qt::endl;
+            skippedReported = reader.skippedFrames();
+            statistics = ReadStatistics();
+            reportTimer.restart();
+        }
+    }
+
+    return 0;
+}
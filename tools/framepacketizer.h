@@ -0,0 +1,94 @@
+#ifndef FRAMEPACKETIZER_H
+#define FRAMEPACKETIZER_H
+
+#include <QByteArray>
+#include <QList>
+#include <cstring>
+#include "models/fragmentprotocol.h"
+
+// Splits a frame into datagrams the way the gimbal sender does: a FragmentHeader
+// followed by at most fragmentSize payload bytes, every fragment but the last full.
+// With fecGroupSize > 0 an XOR parity fragment is appended for every fecGroupSize
+// data fragments (see FragmentHeader for the layout).
+inline QList<QByteArray> packetizeFrame(const QByteArray &frame, quint16 frameId, int fragmentSize,
+                                        int fecGroupSize = 0)
+{
+    QList<QByteArray> datagrams;
+    const quint32 totalFragments = quint32(qMax<qsizetype>(1, (frame.size() + fragmentSize - 1) / fragmentSize));
+    datagrams.reserve(totalFragments);
+
+    for (quint32 index = 0; index < totalFragments; ++index) {
+        const qsizetype offset = qsizetype(index) * fragmentSize;
+        const qsizetype size = qMin<qsizetype>(fragmentSize, frame.size() - offset);
+
+        FragmentHeader header;
+        header.frameId = frameId;
+        header.totalFragments = totalFragments;
+        header.fragmentIndex = index;
+        header.fragmentSize = quint32(size);
+
+        QByteArray datagram(FragmentHeader::Size + size, Qt::Uninitialized);
+        header.write(datagram.data());
+        memcpy(datagram.data() + FragmentHeader::Size, frame.constData() + offset, size_t(size));
+        datagrams.append(datagram);
+    }
+
+    if (fecGroupSize <= 0) {
+        return datagrams;
+    }
+
+    // Receivers take the stride from the first full fragment, or the only one
+    const qsizetype stride = totalFragments > 1 ? fragmentSize : frame.size();
+    const quint32 groupSize = quint32(fecGroupSize);
+    const quint32 groupCount = (totalFragments + groupSize - 1) / groupSize;
+
+    for (quint32 group = 0; group < groupCount; ++group) {
+        QByteArray parity(FragmentHeader::ParityPrefixSize + stride, '\0');
+        char *payload = parity.data() + FragmentHeader::ParityPrefixSize;
+        quint32 sizes = 0;
+
+        const quint32 end = qMin(group * groupSize + groupSize, totalFragments);
+        for (quint32 index = group * groupSize; index < end; ++index) {
+            const QByteArray &datagram = datagrams.at(index);
+            const char *data = datagram.constData() + FragmentHeader::Size;
+            const qsizetype size = datagram.size() - FragmentHeader::Size;
+            sizes ^= quint32(size);
+            for (qsizetype i = 0; i < size; ++i) {
+                payload[i] ^= data[i];
+            }
+        }
+        qToBigEndian<quint32>(sizes, parity.data());
+
+        FragmentHeader header;
+        header.frameId = frameId;
+        header.totalFragments = totalFragments;
+        header.fragmentIndex = FragmentHeader::parityIndex(group, groupSize);
+        header.fragmentSize = quint32(parity.size());
+
+        QByteArray datagram(FragmentHeader::Size + parity.size(), Qt::Uninitialized);
+        header.write(datagram.data());
+        memcpy(datagram.data() + FragmentHeader::Size, parity.constData(), size_t(parity.size()));
+        datagrams.append(datagram);
+    }
+
+    return datagrams;
+}
+
+// A frame that passes CameraModel's JPEG sanity checks (SOI/EOI markers, size range)
+inline QByteArray syntheticJpegFrame(qsizetype size, quint16 seed)
+{
+    QByteArray frame(size, Qt::Uninitialized);
+    char *data = frame.data();
+    quint32 state = 0x9E3779B9u ^ seed;
+    for (qsizetype i = 0; i < size; ++i) {
+        state = state * 1664525u + 1013904223u;
+        data[i] = char(state >> 24);
+    }
+    data[0] = char(0xFF);
+    data[1] = char(0xD8);
+    data[size - 2] = char(0xFF);
+    data[size - 1] = char(0xD9);
+    return frame;
+}
+
+#endif // FRAMEPACKETIZER_H
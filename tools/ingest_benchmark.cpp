@@ -0,0 +1,173 @@
+// Compares the QUdpSocket::receiveDatagram() ingest path with the batched
+// recvmmsg() backend. Synthetic frames are fragmented like the gimbal sender does,
+// sent over loopback in bursts small enough to fit the socket buffer, and each
+// burst is drained and reassembled by the backend under test. Only the receive
+// side is timed.
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QNetworkDatagram>
+#include <QUdpSocket>
+#include <QDeadlineTimer>
+#include <QTextStream>
+#include "models/framereassembler.h"
+#include "models/udpbatchreceiver.h"
+#include "framepacketizer.h"
+
+namespace {
+
+struct BenchmarkResult {
+    qint64 datagrams = 0;
+    qint64 bytes = 0;
+    qint64 frames = 0;
+    qint64 elapsedNs = 0;
+};
+
+struct BenchmarkConfig {
+    int frames = 2000;
+    int frameSize = 200 * 1024;
+    int fragmentSize = 1400;
+    int burst = 64;
+    int fecGroupSize = 0;
+    quint16 port = 47000;
+};
+
+// Sends every frame in bursts and lets drain() receive each burst, timing only drain()
+template <typename Drain>
+BenchmarkResult runBenchmark(const BenchmarkConfig &config, BenchmarkResult &result, Drain &&drain)
+{
+    QList<QByteArray> frames;
+    for (int i = 0; i < 16; ++i) {
+        frames.append(syntheticJpegFrame(config.frameSize, quint16(i)));
+    }
+
+    QUdpSocket sender;
+    for (int i = 0; i < config.frames; ++i) {
+        const QList<QByteArray> datagrams = packetizeFrame(frames.at(i % frames.size()), quint16(i),
+                                                           config.fragmentSize, config.fecGroupSize);
+        for (qsizetype start = 0; start < datagrams.size(); start += config.burst) {
+            const qsizetype count = qMin<qsizetype>(config.burst, datagrams.size() - start);
+            for (qsizetype j = start; j < start + count; ++j) {
+                sender.writeDatagram(datagrams.at(j), QHostAddress::LocalHost, config.port);
+            }
+
+            QElapsedTimer timer;
+            timer.start();
+            qint64 received = 0;
+            QDeadlineTimer deadline(100);
+            while (received < count && !deadline.hasExpired()) {
+                received += drain();
+            }
+            result.elapsedNs += timer.nsecsElapsed();
+            result.datagrams += received;
+        }
+    }
+
+    return result;
+}
+
+BenchmarkResult runQtBackend(const BenchmarkConfig &config)
+{
+    BenchmarkResult result;
+    QUdpSocket receiver;
+    if (!receiver.bind(QHostAddress::AnyIPv4, config.port)) {
+        qWarning() << "Failed to bind" << config.port << receiver.errorString();
+        return result;
+    }
+    receiver.setSocketOption(QAbstractSocket::ReceiveBufferSizeSocketOption, 8 * 1024 * 1024);
+
+    FrameReassembler<> reassembler;
+    FrameReassembler<>::Frame frame;
+
+    return runBenchmark(config, result, [&]() {
+        qint64 received = 0;
+        while (receiver.hasPendingDatagrams()) {
+            QNetworkDatagram datagram = receiver.receiveDatagram();
+            QByteArray data = datagram.data();
+            received++;
+            result.bytes += data.size();
+            if (reassembler.addFragment(data.constData(), data.size(), 0, &frame)
+                == FrameReassembler<>::Result::Complete) {
+                result.frames++;
+            }
+        }
+        return received;
+    });
+}
+
+BenchmarkResult runBatchedBackend(const BenchmarkConfig &config)
+{
+    BenchmarkResult result;
+    UdpBatchReceiver receiver;
+    if (!receiver.bind(config.port)) {
+        qWarning() << "Failed to bind" << config.port << receiver.errorString();
+        return result;
+    }
+
+    FrameReassembler<> reassembler;
+    FrameReassembler<>::Frame frame;
+    receiver.setDatagramHandler([&](const char *data, qsizetype size) {
+        result.bytes += size;
+        if (reassembler.addFragment(data, size, 0, &frame) == FrameReassembler<>::Result::Complete) {
+            result.frames++;
+        }
+    });
+
+    return runBenchmark(config, result, [&]() {
+        return qint64(receiver.drain());
+    });
+}
+
+void report(QTextStream &out, const QString &name, const BenchmarkResult &result)
+{
+    const double seconds = result.elapsedNs / 1e9;
+    out << name.leftJustified(10)
+        << " datagrams: " << result.datagrams
+        << "  frames: " << result.frames
+        << "  ns/datagram: " << (result.datagrams ? result.elapsedNs / result.datagrams : 0)
+        << "  datagrams/s: " << qint64(seconds > 0 ? result.datagrams / seconds : 0)
+        << "  MB/s: " << QString::number(seconds > 0 ? result.bytes / seconds / (1024 * 1024) : 0, 'f', 1)
+        << Qt::endl;
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("mars_ingest_benchmark");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Compares the Qt and batched UDP ingest backends");
+    parser.addHelpOption();
+    QCommandLineOption framesOption("frames", "Number of frames to send.", "count", "2000");
+    QCommandLineOption frameSizeOption("frame-size", "Frame size in bytes.", "bytes", "204800");
+    QCommandLineOption fragmentSizeOption("fragment-size", "Fragment payload size in bytes.", "bytes", "1400");
+    QCommandLineOption burstOption("burst", "Datagrams sent before each drain.", "count", "64");
+    QCommandLineOption portOption("port", "Loopback port to use.", "port", "47000");
+    QCommandLineOption fecOption("fec-group", "Add one XOR parity fragment per this many fragments.", "count", "0");
+    parser.addOptions({framesOption, frameSizeOption, fragmentSizeOption, burstOption, portOption, fecOption});
+    parser.process(app);
+
+    BenchmarkConfig config;
+    config.frames = parser.value(framesOption).toInt();
+    config.frameSize = qMax(1024, parser.value(frameSizeOption).toInt());
+    config.fragmentSize = qMax(1, parser.value(fragmentSizeOption).toInt());
+    config.burst = qMax(1, parser.value(burstOption).toInt());
+    config.port = quint16(parser.value(portOption).toUInt());
+    config.fecGroupSize = qBound(0, parser.value(fecOption).toInt(), 0x7FFF);
+
+    QTextStream out(stdout);
+    out << "frames: " << config.frames << "  frame size: " << config.frameSize
+        << "  fragment size: " << config.fragmentSize << "  burst: " << config.burst
+        << "  fec group: " << config.fecGroupSize << Qt::endl;
+
+    report(out, "qt", runQtBackend(config));
+    if (UdpBatchReceiver::isSupported()) {
+        report(out, "batched", runBatchedBackend(config));
+    } else {
+        out << "batched    not supported on this platform" << Qt::endl;
+    }
+
+    return 0;
+}
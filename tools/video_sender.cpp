@@ -0,0 +1,411 @@
+// Synthetic video sender for load testing the ground station ingest path. Streams a
+// JPEG sequence, or generated test pattern frames, as fragmented datagrams with the
+// gimbal's 14 byte header (see FragmentHeader), at a given frame rate or as fast as
+// the socket accepts them. Loss and reordering can be simulated on the sender side,
+// and every frame carries its capture time for the latency statistics.
+//
+// With --fps 0 the sender runs unpaced; raising the frame size or running several
+// senders against one receiver finds the highest frame rate and bitrate the ingest
+// thread sustains, from the receiver's link and frame rate counters.
+//
+// Like the gimbal, the sender listens for NACKs on the control port (video port + 100)
+// and retransmits the requested fragments of frames sent within the latency budget.
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QBuffer>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QImage>
+#include <QPainter>
+#include <QRandomGenerator>
+#include <QTextStream>
+#include <QThread>
+#include <QUdpSocket>
+#include <iterator>
+#include "models/frametiming.h"
+#include "framepacketizer.h"
+
+namespace {
+
+struct SenderConfig {
+    QHostAddress host = QHostAddress::LocalHost;
+    quint16 port = 5000;
+    QSize size = QSize(1280, 720);
+    double fps = 30;                // 0 sends unpaced
+    int quality = 80;
+    int fragmentSize = 1400;
+    int fecGroupSize = 0;
+    double lossPercent = 0;
+    double reorderPercent = 0;
+    int reorderDepth = 4;
+    qint64 frames = 0;              // 0 runs until interrupted
+    bool timestamps = true;
+    quint32 seed = 1;
+    int nackBudgetMs = 150;         // 0 ignores NACKs
+};
+
+struct SenderStatistics {
+    qint64 frames = 0;
+    qint64 datagrams = 0;
+    qint64 bytes = 0;
+    qint64 lost = 0;
+    qint64 reordered = 0;
+    qint64 sendErrors = 0;
+    qint64 nacks = 0;
+    qint64 resent = 0;
+    qint64 nacksExpired = 0;        // the frame was too old or no longer kept
+};
+
+// The datagrams of the last frames sent, as packetized before any simulated loss
+class RetransmitHistory
+{
+public:
+    static constexpr int Frames = 16;
+
+    void store(quint16 frameId, qint64 sentNs, const QList<QByteArray> &datagrams)
+    {
+        SentFrame &frame = m_frames[frameId % Frames];
+        frame.frameId = frameId;
+        frame.sentNs = sentNs;
+        frame.datagrams = datagrams;
+    }
+
+    const QList<QByteArray> *find(quint16 frameId, qint64 sentAfterNs) const
+    {
+        const SentFrame &frame = m_frames[frameId % Frames];
+        if (frame.datagrams.isEmpty() || frame.frameId != frameId || frame.sentNs < sentAfterNs) {
+            return nullptr;
+        }
+        return &frame.datagrams;
+    }
+
+private:
+    struct SentFrame {
+        quint16 frameId = 0;
+        qint64 sentNs = 0;
+        QList<QByteArray> datagrams;
+    };
+
+    SentFrame m_frames[Frames];
+};
+
+QByteArray encodeJpeg(const QImage &image, int quality)
+{
+    QByteArray jpeg;
+    QBuffer buffer(&jpeg);
+    buffer.open(QIODevice::WriteOnly);
+    image.save(&buffer, "JPG", quality);
+    return jpeg;
+}
+
+// Moving bars with the frame number as a row of black and white blocks, so dropped or
+// repeated frames are visible on screen. No text, which would need a GUI application.
+QImage testPattern(const QSize &size, int index, int count)
+{
+    QImage image(size, QImage::Format_RGB32);
+    QPainter painter(&image);
+
+    static const QColor colors[] = { Qt::white, Qt::yellow, Qt::cyan, Qt::green,
+                                     Qt::magenta, Qt::red, Qt::blue, Qt::black };
+    const int bars = int(std::size(colors));
+    const int barWidth = qMax(1, size.width() / bars);
+    for (int i = 0; i < bars; ++i) {
+        painter.fillRect(i * barWidth, 0, barWidth, size.height(), colors[i]);
+    }
+
+    const int sweep = size.width() * index / qMax(1, count);
+    painter.fillRect(sweep, 0, qMax(4, size.width() / 64), size.height(), Qt::gray);
+
+    const int block = qMax(4, size.width() / 40);
+    for (int bit = 0; bit < 16; ++bit) {
+        const bool set = (index >> (15 - bit)) & 1;
+        painter.fillRect(block + bit * block, size.height() - 2 * block, block, block,
+                         set ? Qt::white : Qt::black);
+    }
+    return image;
+}
+
+QList<QByteArray> loadFrames(const QString &directory, const SenderConfig &config, int patternFrames,
+                             QTextStream &out)
+{
+    QList<QByteArray> frames;
+
+    if (!directory.isEmpty()) {
+        QDir dir(directory);
+        const QStringList files = dir.entryList({ "*.jpg", "*.jpeg", "*.JPG", "*.JPEG" },
+                                                QDir::Files, QDir::Name);
+        for (const QString &file : files) {
+            QFile jpeg(dir.filePath(file));
+            if (jpeg.open(QIODevice::ReadOnly)) {
+                frames.append(jpeg.readAll());
+            }
+        }
+        out << "loaded " << frames.size() << " JPEG files from " << directory << Qt::endl;
+        return frames;
+    }
+
+    for (int i = 0; i < patternFrames; ++i) {
+        frames.append(encodeJpeg(testPattern(config.size, i, patternFrames), config.quality));
+    }
+    out << "generated " << frames.size() << " test pattern frames, "
+        << config.size.width() << "x" << config.size.height()
+        << ", about " << (frames.isEmpty() ? 0 : frames.first().size() / 1024) << " KB each" << Qt::endl;
+    return frames;
+}
+
+// Same APP15 segment FrameTiming::captureTimestamp() reads, inserted after SOI
+QByteArray withCaptureTime(const QByteArray &jpeg, qint64 captureUs)
+{
+    static constexpr char Identifier[8] = { 'M', 'A', 'R', 'S', 'C', 'A', 'P', '\0' };
+
+    QByteArray segment(4 + sizeof(Identifier) + 8, Qt::Uninitialized);
+    uchar *data = reinterpret_cast<uchar *>(segment.data());
+    data[0] = 0xFF;
+    data[1] = 0xEF;
+    qToBigEndian<quint16>(quint16(segment.size() - 2), data + 2);
+    memcpy(data + 4, Identifier, sizeof(Identifier));
+    qToBigEndian<qint64>(captureUs, data + 4 + sizeof(Identifier));
+
+    QByteArray frame;
+    frame.reserve(jpeg.size() + segment.size());
+    frame.append(jpeg.constData(), 2);
+    frame.append(segment);
+    frame.append(jpeg.constData() + 2, jpeg.size() - 2);
+    return frame;
+}
+
+// Drops and swaps datagrams of one frame as configured
+void impairDatagrams(QList<QByteArray> &datagrams, const SenderConfig &config, QRandomGenerator &random,
+                     SenderStatistics &statistics)
+{
+    if (config.lossPercent > 0) {
+        for (qsizetype i = datagrams.size() - 1; i >= 0; --i) {
+            if (random.generateDouble() * 100 < config.lossPercent) {
+                datagrams.removeAt(i);
+                statistics.lost++;
+            }
+        }
+    }
+
+    if (config.reorderPercent > 0 && config.reorderDepth > 0) {
+        for (qsizetype i = 0; i + 1 < datagrams.size(); ++i) {
+            if (random.generateDouble() * 100 < config.reorderPercent) {
+                const qsizetype other = qMin<qsizetype>(datagrams.size() - 1,
+                                                        i + 1 + random.bounded(config.reorderDepth));
+                datagrams.swapItemsAt(i, other);
+                statistics.reordered++;
+            }
+        }
+    }
+}
+
+// Sends one datagram to the receiver
+bool sendDatagram(QUdpSocket &socket, const QByteArray &datagram, const SenderConfig &config,
+                  SenderStatistics &statistics)
+{
+    // A full send buffer is retried, so unpaced runs measure the receiver, not drops here
+    qint64 written;
+    while ((written = socket.writeDatagram(datagram, config.host, config.port)) < 0
+           && socket.error() == QAbstractSocket::TemporaryError) {
+        QThread::yieldCurrentThread();
+    }
+    if (written < 0) {
+        statistics.sendErrors++;
+        return false;
+    }
+    statistics.datagrams++;
+    statistics.bytes += datagram.size();
+    return true;
+}
+
+// Answers the NACKs waiting on the control socket. Retransmissions go through the same
+// simulated loss as the first transmission; other control traffic (the tracking
+// commands) is ignored.
+void serveNacks(QUdpSocket &control, QUdpSocket &socket, const RetransmitHistory &history,
+                const SenderConfig &config, qint64 nowNs, QRandomGenerator &random,
+                SenderStatistics &statistics)
+{
+    while (control.hasPendingDatagrams()) {
+        QByteArray packet(qMax<qint64>(0, control.pendingDatagramSize()), Qt::Uninitialized);
+        const qint64 size = control.readDatagram(packet.data(), packet.size());
+        NackPacket nack;
+        if (size < 0 || !NackPacket::decode(packet.constData(), size, &nack)) {
+            continue;
+        }
+        statistics.nacks++;
+
+        const QList<QByteArray> *datagrams = history.find(nack.frameId,
+                                                          nowNs - qint64(config.nackBudgetMs) * 1000000);
+        if (!datagrams) {
+            statistics.nacksExpired++;
+            continue;
+        }
+        // Only data fragments are requested; packetizeFrame lists them first, by index
+        FragmentHeader header;
+        FragmentHeader::parse(datagrams->first().constData(), datagrams->first().size(), &header);
+        for (quint32 index : std::as_const(nack.fragmentIndices)) {
+            if (index >= header.totalFragments) {
+                continue;
+            }
+            if (config.lossPercent > 0 && random.generateDouble() * 100 < config.lossPercent) {
+                statistics.lost++;
+                continue;
+            }
+            if (sendDatagram(socket, datagrams->at(index), config, statistics)) {
+                statistics.resent++;
+            }
+        }
+    }
+}
+
+void report(QTextStream &out, const SenderStatistics &statistics, const SenderStatistics &previous,
+            double seconds)
+{
+    const double frames = (statistics.frames - previous.frames) / seconds;
+    const double datagrams = (statistics.datagrams - previous.datagrams) / seconds;
+    const double megabits = (statistics.bytes - previous.bytes) * 8 / seconds / 1e6;
+    out << "fps: " << QString::number(frames, 'f', 1)
+        << "  datagrams/s: " << qint64(datagrams)
+        << "  Mbit/s: " << QString::number(megabits, 'f', 1)
+        << "  lost: " << statistics.lost
+        << "  reordered: " << statistics.reordered
+        << "  send errors: " << statistics.sendErrors
+        << "  nacks: " << statistics.nacks
+        << "  resent: " << statistics.resent
+        << "  nacks expired: " << statistics.nacksExpired
+        << Qt::endl;
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("mars_video_sender");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Sends fragmented MJPEG video like the gimbal camera");
+    parser.addHelpOption();
+    QCommandLineOption hostOption("host", "Receiver address.", "address", "127.0.0.1");
+    QCommandLineOption portOption("port", "Receiver port.", "port", "5000");
+    QCommandLineOption jpegDirOption("jpeg-dir", "Send the JPEG files in this directory, in name order.", "directory");
+    QCommandLineOption widthOption("width", "Test pattern width.", "pixels", "1280");
+    QCommandLineOption heightOption("height", "Test pattern height.", "pixels", "720");
+    QCommandLineOption qualityOption("quality", "Test pattern JPEG quality.", "0-100", "80");
+    QCommandLineOption patternFramesOption("pattern-frames", "Distinct test pattern frames.", "count", "60");
+    QCommandLineOption fpsOption("fps", "Frame rate, 0 sends as fast as possible.", "fps", "30");
+    QCommandLineOption framesOption("frames", "Frames to send, 0 runs until interrupted.", "count", "0");
+    QCommandLineOption fragmentSizeOption("fragment-size", "Fragment payload size in bytes.", "bytes", "1400");
+    QCommandLineOption fecOption("fec-group", "Add one XOR parity fragment per this many fragments.", "count", "0");
+    QCommandLineOption lossOption("loss", "Datagrams dropped before sending, in percent.", "percent", "0");
+    QCommandLineOption reorderOption("reorder", "Datagrams swapped with a later one, in percent.", "percent", "0");
+    QCommandLineOption reorderDepthOption("reorder-depth", "Furthest a datagram is moved.", "datagrams", "4");
+    QCommandLineOption seedOption("seed", "Seed of the loss and reordering decisions.", "seed", "1");
+    QCommandLineOption noTimestampOption("no-timestamp", "Do not embed the capture time in the frames.");
+    QCommandLineOption nackBudgetOption("nack-budget", "Retransmit NACKed fragments of frames sent within this time, 0 ignores NACKs.",
+                                        "ms", "150");
+    parser.addOptions({hostOption, portOption, jpegDirOption, widthOption, heightOption, qualityOption,
+                       patternFramesOption, fpsOption, framesOption, fragmentSizeOption, fecOption,
+                       lossOption, reorderOption, reorderDepthOption, seedOption, noTimestampOption,
+                       nackBudgetOption});
+    parser.process(app);
+
+    SenderConfig config;
+    config.host = QHostAddress(parser.value(hostOption));
+    config.port = quint16(parser.value(portOption).toUInt());
+    config.size = QSize(qMax(16, parser.value(widthOption).toInt()), qMax(16, parser.value(heightOption).toInt()));
+    config.quality = qBound(0, parser.value(qualityOption).toInt(), 100);
+    config.fps = qMax(0.0, parser.value(fpsOption).toDouble());
+    config.frames = qMax<qint64>(0, parser.value(framesOption).toLongLong());
+    config.fragmentSize = qBound(1, parser.value(fragmentSizeOption).toInt(), 65000);
+    config.fecGroupSize = qBound(0, parser.value(fecOption).toInt(), 0x7FFF);
+    config.lossPercent = qBound(0.0, parser.value(lossOption).toDouble(), 100.0);
+    config.reorderPercent = qBound(0.0, parser.value(reorderOption).toDouble(), 100.0);
+    config.reorderDepth = qMax(1, parser.value(reorderDepthOption).toInt());
+    config.seed = parser.value(seedOption).toUInt();
+    config.timestamps = !parser.isSet(noTimestampOption);
+    config.nackBudgetMs = qMax(0, parser.value(nackBudgetOption).toInt());
+
+    QTextStream out(stdout);
+    const QList<QByteArray> frames = loadFrames(parser.value(jpegDirOption), config,
+                                                qMax(1, parser.value(patternFramesOption).toInt()), out);
+    if (frames.isEmpty()) {
+        out << "no frames to send" << Qt::endl;
+        return 1;
+    }
+
+    QUdpSocket socket;
+    socket.setSocketOption(QAbstractSocket::SendBufferSizeSocketOption, 8 * 1024 * 1024);
+    QRandomGenerator random(config.seed);
+
+    // NACKs arrive on the control port, as they would at the gimbal
+    QUdpSocket control;
+    const quint16 controlPort = quint16(config.port + 100);
+    if (config.nackBudgetMs > 0 && !control.bind(QHostAddress::Any, controlPort)) {
+        out << "cannot listen for NACKs on port " << controlPort << ": " << control.errorString() << Qt::endl;
+        config.nackBudgetMs = 0;
+    }
+    const bool retransmit = config.nackBudgetMs > 0;
+    RetransmitHistory history;
+
+    out << "sending to " << config.host.toString() << ":" << config.port
+        << "  fps: " << (config.fps > 0 ? QString::number(config.fps) : QString("unpaced"))
+        << "  fragment size: " << config.fragmentSize << "  fec group: " << config.fecGroupSize
+        << "  loss: " << config.lossPercent << "%  reorder: " << config.reorderPercent << "%"
+        << "  nack budget: " << (retransmit ? QString::number(config.nackBudgetMs) + " ms" : QString("off"))
+        << Qt::endl;
+
+    SenderStatistics statistics;
+    SenderStatistics reported;
+    QElapsedTimer clock;
+    clock.start();
+    qint64 lastReportNs = 0;
+
+    for (qint64 frame = 0; config.frames == 0 || frame < config.frames; ++frame) {
+        if (config.fps > 0) {
+            const qint64 dueNs = qint64(frame * 1e9 / config.fps);
+            qint64 waitNs;
+            while ((waitNs = dueNs - clock.nsecsElapsed()) > 0) {
+                // NACKs are answered while waiting for the next frame
+                if (retransmit && waitNs >= 1000000) {
+                    if (control.waitForReadyRead(int(waitNs / 1000000))) {
+                        serveNacks(control, socket, history, config, clock.nsecsElapsed(), random, statistics);
+                    }
+                } else {
+                    QThread::usleep(quint64(waitNs / 1000));
+                }
+            }
+        }
+
+        const QByteArray &jpeg = frames.at(frame % frames.size());
+        const QByteArray payload = config.timestamps ? withCaptureTime(jpeg, FrameTiming::now()) : jpeg;
+        QList<QByteArray> datagrams = packetizeFrame(payload, quint16(frame), config.fragmentSize,
+                                                     config.fecGroupSize);
+        if (retransmit) {
+            history.store(quint16(frame), clock.nsecsElapsed(), datagrams);
+        }
+        impairDatagrams(datagrams, config, random, statistics);
+
+        for (const QByteArray &datagram : std::as_const(datagrams)) {
+            sendDatagram(socket, datagram, config, statistics);
+        }
+        statistics.frames++;
+        if (retransmit) {
+            serveNacks(control, socket, history, config, clock.nsecsElapsed(), random, statistics);
+        }
+
+        const qint64 nowNs = clock.nsecsElapsed();
+        if (nowNs - lastReportNs >= 1000000000) {
+            report(out, statistics, reported, (nowNs - lastReportNs) / 1e9);
+            reported = statistics;
+            lastReportNs = nowNs;
+        }
+    }
+
+    out << "total  frames: " << statistics.frames << "  datagrams: " << statistics.datagrams
+        << "  MB: " << QString::number(statistics.bytes / (1024.0 * 1024.0), 'f', 1)
+        << "  resent: " << statistics.resent
+        << "  seconds: " << QString::number(clock.nsecsElapsed() / 1e9, 'f', 2) << Qt::endl;
+    return 0;
+}
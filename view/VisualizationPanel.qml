@@ -2,6 +2,7 @@
 import QtQuick 2.15
 import QtQuick.Controls 2.15
 import QtQuick.Layouts 1.15
+import SerialApp 1.0
 
 Item {
     id: panel
@@ -226,15 +227,14 @@ Item {
                         }
                         property real displayHeight: displayWidth / targetAspect
 
-                        Image {
+                        VideoSurface {
                             id: thermalImage
                             anchors.centerIn: parent
                             width: thermalContainer.displayWidth
                             height: thermalContainer.displayHeight
-                            fillMode: Image.PreserveAspectFit
+                            fillMode: VideoSurface.PreserveAspectFit
                             // Same swap behavior as in Main.qml
-                            source: framesSwapped ? cameraViewModel.currentFrameUrl : thermalCameraViewModel.currentThermalFrameUrl
-                            cache: false
+                            source: framesSwapped ? cameraViewModel.frameSource : thermalCameraViewModel.thermalFrameSource
                             smooth: true
 
                             Rectangle {
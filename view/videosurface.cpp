@@ -0,0 +1,291 @@
+#include "videosurface.h"
+#include <QSGSimpleTextureNode>
+#include <QSGTexture>
+#include <QQuickWindow>
+#include <QtMath>
+#include <QMutex>
+#include <rhi/qrhi.h>
+
+struct VideoSurface::Presentation
+{
+    QMutex mutex;
+    std::shared_ptr<LatencyStatistics> latency;     // of the current source
+    std::shared_ptr<FrameHistory> history;
+    FrameTiming timing;
+    int frameId = -1;
+    quint64 serial = 0;
+    bool pending = false;
+};
+
+namespace {
+
+// Texture whose GPU storage is kept across frames. setImage() only records the new
+// frame; the upload is queued on the render thread's resource batch the next time the
+// material commits its textures, and the QRhiTexture is only recreated on size change.
+class VideoTexture : public QSGTexture
+{
+public:
+    explicit VideoTexture(std::shared_ptr<VideoSurface::Presentation> presentation)
+        : m_presentation(std::move(presentation))
+    {
+    }
+
+    ~VideoTexture() override
+    {
+        if (m_texture) {
+            m_texture->deleteLater();
+        }
+    }
+
+    void setImage(const QImage &image, const FrameTiming &timing, int frameId, quint64 serial)
+    {
+        m_image = image;
+        m_timing = timing;
+        m_frameId = frameId;
+        m_serial = serial;
+        m_size = image.size();
+        m_hasAlpha = image.hasAlphaChannel();
+        m_uploadPending = true;
+    }
+
+    qint64 comparisonKey() const override { return qint64(qintptr(this)); }
+    QRhiTexture *rhiTexture() const override { return m_texture; }
+    QSize textureSize() const override { return m_size; }
+    bool hasAlphaChannel() const override { return m_hasAlpha; }
+    bool hasMipmaps() const override { return false; }
+
+    void commitTextureOperations(QRhi *rhi, QRhiResourceUpdateBatch *resourceUpdates) override
+    {
+        if (!m_uploadPending || m_image.isNull()) {
+            return;
+        }
+
+        // RGB32 frames are BGRA in memory, upload them without a conversion when possible
+        QRhiTexture::Format format = QRhiTexture::RGBA8;
+        QImage upload = m_image;
+        if (rhi->isTextureFormatSupported(QRhiTexture::BGRA8)
+            && (upload.format() == QImage::Format_RGB32 || upload.format() == QImage::Format_ARGB32_Premultiplied)) {
+            format = QRhiTexture::BGRA8;
+        } else if (upload.format() != QImage::Format_RGBA8888_Premultiplied) {
+            upload.convertTo(QImage::Format_RGBA8888_Premultiplied);
+        }
+
+        if (!m_texture || m_texture->pixelSize() != m_size || m_texture->format() != format) {
+            if (m_texture) {
+                m_texture->deleteLater();
+            }
+            m_texture = rhi->newTexture(format, m_size);
+            if (!m_texture->create()) {
+                delete m_texture;
+                m_texture = nullptr;
+                return;
+            }
+        }
+
+        resourceUpdates->uploadTexture(m_texture, upload);
+        m_uploadPending = false;
+        m_image = QImage();     // the GPU copy is all we need, release the frame
+
+        m_timing.uploaded = FrameTiming::now();
+        QMutexLocker locker(&m_presentation->mutex);
+        m_presentation->timing = m_timing;
+        m_presentation->frameId = m_frameId;
+        m_presentation->serial = m_serial;
+        m_presentation->pending = true;
+    }
+
+private:
+    std::shared_ptr<VideoSurface::Presentation> m_presentation;
+    QRhiTexture *m_texture = nullptr;
+    QImage m_image;
+    FrameTiming m_timing;
+    int m_frameId = -1;
+    quint64 m_serial = 0;
+    QSize m_size;
+    bool m_hasAlpha = false;
+    bool m_uploadPending = false;
+};
+
+}
+
+VideoSurface::VideoSurface(QQuickItem *parent)
+    : QQuickItem(parent)
+    , m_fillMode(PreserveAspectFit)
+    , m_frameId(-1)
+    , m_frameSerial(0)
+    , m_frameDirty(false)
+    , m_presentation(std::make_shared<Presentation>())
+{
+    setFlag(ItemHasContents, true);
+}
+
+VideoSurface::~VideoSurface()
+{
+    if (m_source) {
+        m_source->setConsumerSize(this, QSize());
+    }
+}
+
+void VideoSurface::setSource(VideoFrameSource *source)
+{
+    if (m_source == source) {
+        return;
+    }
+
+    if (m_source) {
+        disconnect(m_source, nullptr, this, nullptr);
+        m_source->setConsumerSize(this, QSize());
+    }
+    m_source = source;
+    if (m_source) {
+        connect(m_source, &VideoFrameSource::frameChanged, this, &VideoSurface::onFrameChanged);
+    }
+    {
+        QMutexLocker locker(&m_presentation->mutex);
+        m_presentation->latency = m_source ? m_source->latency() : nullptr;
+        m_presentation->history = m_source ? m_source->history() : nullptr;
+        m_presentation->pending = false;
+    }
+
+    emit sourceChanged();
+    onFrameChanged();
+    updateConsumerSize();
+}
+
+void VideoSurface::setFillMode(FillMode mode)
+{
+    if (m_fillMode != mode) {
+        m_fillMode = mode;
+        emit fillModeChanged();
+        emit paintedGeometryChanged();
+        updateConsumerSize();
+        update();
+    }
+}
+
+void VideoSurface::onFrameChanged()
+{
+    m_frame = m_source ? m_source->frame() : QImage();
+    m_frameTiming = m_source ? m_source->frameTiming() : FrameTiming();
+    m_frameId = m_source ? m_source->frameId() : -1;
+    m_frameSerial = m_source ? m_source->serial() : 0;
+    m_frameDirty = true;
+
+    if (m_frame.size() != m_frameSize) {
+        m_frameSize = m_frame.size();
+        emit paintedGeometryChanged();
+        updateConsumerSize();
+    }
+    update();
+}
+
+void VideoSurface::geometryChange(const QRectF &newGeometry, const QRectF &oldGeometry)
+{
+    QQuickItem::geometryChange(newGeometry, oldGeometry);
+    if (newGeometry.size() != oldGeometry.size()) {
+        emit paintedGeometryChanged();
+        updateConsumerSize();
+        update();
+    }
+}
+
+void VideoSurface::itemChange(ItemChange change, const ItemChangeData &value)
+{
+    QQuickItem::itemChange(change, value);
+    if (change == ItemSceneChange) {
+        connectWindow(value.window);
+    }
+    if (change == ItemVisibleHasChanged || change == ItemSceneChange
+        || change == ItemDevicePixelRatioHasChanged) {
+        updateConsumerSize();
+    }
+}
+
+void VideoSurface::connectWindow(QQuickWindow *window)
+{
+    if (m_window == window) {
+        return;
+    }
+    disconnect(m_frameEndConnection);
+    m_window = window;
+    if (!m_window) {
+        return;
+    }
+
+    // Runs on the render thread, only touches the shared presentation state
+    std::shared_ptr<Presentation> presentation = m_presentation;
+    m_frameEndConnection = connect(m_window, &QQuickWindow::afterFrameEnd, this, [presentation] {
+        QMutexLocker locker(&presentation->mutex);
+        if (!presentation->pending || !presentation->latency) {
+            return;
+        }
+        presentation->pending = false;
+        FrameTiming timing = presentation->timing;
+        timing.presented = FrameTiming::now();
+        const quint64 serial = presentation->serial;
+        const int frameId = presentation->frameId;
+        const std::shared_ptr<LatencyStatistics> latency = presentation->latency;
+        const std::shared_ptr<FrameHistory> history = presentation->history;
+        locker.unlock();
+
+        latency->record(timing, serial);
+        if (history && frameId >= 0) {
+            history->markPresented(quint16(frameId));
+        }
+    }, Qt::DirectConnection);
+}
+
+void VideoSurface::updateConsumerSize()
+{
+    if (!m_source) {
+        return;
+    }
+
+    // Hidden surfaces do not hold the decoder at a higher resolution
+    QSize pixelSize;
+    if (isVisible() && window()) {
+        const QSizeF painted = paintedRect().size() * window()->effectiveDevicePixelRatio();
+        pixelSize = QSize(qCeil(painted.width()), qCeil(painted.height()));
+    }
+    m_source->setConsumerSize(this, pixelSize);
+}
+
+QRectF VideoSurface::paintedRect() const
+{
+    const QRectF bounds = boundingRect();
+    if (m_fillMode == Stretch || m_frameSize.isEmpty()) {
+        return bounds;
+    }
+
+    QSizeF size = QSizeF(m_frameSize).scaled(bounds.size(), Qt::KeepAspectRatio);
+    return QRectF(bounds.x() + (bounds.width() - size.width()) / 2,
+                  bounds.y() + (bounds.height() - size.height()) / 2,
+                  size.width(), size.height());
+}
+
+QSGNode *VideoSurface::updatePaintNode(QSGNode *oldNode, UpdatePaintNodeData *)
+{
+    auto *node = static_cast<QSGSimpleTextureNode *>(oldNode);
+
+    if (m_frameSize.isEmpty()) {
+        delete node;
+        return nullptr;
+    }
+
+    if (!node) {
+        node = new QSGSimpleTextureNode();
+        node->setTexture(new VideoTexture(m_presentation));
+        node->setOwnsTexture(true);
+        m_frameDirty = true;
+    }
+
+    if (m_frameDirty) {
+        static_cast<VideoTexture *>(node->texture())->setImage(m_frame, m_frameTiming, m_frameId, m_frameSerial);
+        m_frameDirty = false;
+        node->markDirty(QSGNode::DirtyMaterial);
+    }
+
+    node->setFiltering(smooth() ? QSGTexture::Linear : QSGTexture::Nearest);
+    node->setRect(paintedRect());
+    return node;
+}
@@ -0,0 +1,83 @@
+#ifndef VIDEOSURFACE_H
+#define VIDEOSURFACE_H
+
+#include <QQuickItem>
+#include <QImage>
+#include <QPointer>
+#include <QQuickWindow>
+#include <memory>
+#include "viewmodels/videoframesource.h"
+
+// Scene graph item drawing the frames of a VideoFrameSource.
+//
+// Replaces Image { source: "image://camera/..." }: frames go straight from the view
+// model into one GPU texture per item, which is created once and re-uploaded in place
+// for every frame of the same size. No URL, image provider or pixmap is involved.
+// The item reports its painted size in device pixels to the source, which lets the
+// decoder pick a reduced DCT scale for small views.
+//
+// The upload time of every frame is stamped on the render thread, and the frame is
+// recorded in the source's latency statistics and marked presented in its frame
+// history at the window's afterFrameEnd.
+class VideoSurface : public QQuickItem
+{
+    Q_OBJECT
+    Q_PROPERTY(VideoFrameSource *source READ source WRITE setSource NOTIFY sourceChanged)
+    Q_PROPERTY(FillMode fillMode READ fillMode WRITE setFillMode NOTIFY fillModeChanged)
+    Q_PROPERTY(qreal paintedWidth READ paintedWidth NOTIFY paintedGeometryChanged)
+    Q_PROPERTY(qreal paintedHeight READ paintedHeight NOTIFY paintedGeometryChanged)
+
+public:
+    enum FillMode {
+        Stretch,
+        PreserveAspectFit
+    };
+    Q_ENUM(FillMode)
+
+    explicit VideoSurface(QQuickItem *parent = nullptr);
+    ~VideoSurface();
+
+    VideoFrameSource *source() const { return m_source; }
+    void setSource(VideoFrameSource *source);
+
+    FillMode fillMode() const { return m_fillMode; }
+    void setFillMode(FillMode mode);
+
+    qreal paintedWidth() const { return paintedRect().width(); }
+    qreal paintedHeight() const { return paintedRect().height(); }
+
+    // Upload waiting for the end of the window frame, shared with the render thread
+    struct Presentation;
+
+signals:
+    void sourceChanged();
+    void fillModeChanged();
+    void paintedGeometryChanged();
+
+protected:
+    QSGNode *updatePaintNode(QSGNode *oldNode, UpdatePaintNodeData *data) override;
+    void geometryChange(const QRectF &newGeometry, const QRectF &oldGeometry) override;
+    void itemChange(ItemChange change, const ItemChangeData &value) override;
+
+private slots:
+    void onFrameChanged();
+
+private:
+    QRectF paintedRect() const;
+    void updateConsumerSize();
+    void connectWindow(QQuickWindow *window);
+
+    QPointer<VideoFrameSource> m_source;
+    FillMode m_fillMode;
+    QImage m_frame;         // read by the render thread while the GUI thread is blocked in sync
+    FrameTiming m_frameTiming;
+    int m_frameId;
+    quint64 m_frameSerial;
+    bool m_frameDirty;
+    QSize m_frameSize;
+    QPointer<QQuickWindow> m_window;
+    QMetaObject::Connection m_frameEndConnection;
+    std::shared_ptr<Presentation> m_presentation;   // shared with the texture on the render thread
+};
+
+#endif // VIDEOSURFACE_H
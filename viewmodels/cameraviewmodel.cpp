@@ -4,14 +4,14 @@
 #include <QQmlEngine>
 #include <QDebug>
 #include <QMutex>
-#include<QPainter>
-// Global image provider instance
-static CameraImageProvider* g_imageProvider = nullptr;
+#include <QUrl>
+#include <QFile>
 
 CameraViewModel::CameraViewModel(QObject *parent)
     : QObject(parent)
     , m_cameraThread(new QThread(this))
     , m_cameraModel(nullptr)
+    , m_frameDecoder(nullptr)
     , m_ipAddress("127.0.0.1")
     , m_port(5000)
     , m_streaming(false)
@@ -20,8 +20,13 @@ CameraViewModel::CameraViewModel(QObject *parent)
     , m_frameRate(0.0)
     , m_frameRateTimer(new QTimer(this))
     , m_framesInLastSecond(0)
-    , m_lastFrameTime(0), m_ctrlSocket(nullptr)
+    , m_lastFrameTime(0)
+    , m_frameSource(new VideoFrameSource(this))
+    , m_streamRecorder(new StreamRecorder(this))
+    , m_ctrlSocket(nullptr)
     , m_trackingEnabled(false)
+    , m_batchedIngest(UdpBatchReceiver::isSupported())
+    , m_reactorIngest(IngestReactor::isSupported())
 {
     setupThread();
 
@@ -37,34 +42,100 @@ CameraViewModel::~CameraViewModel()
         stopStream();
     }
 
-    // Clean up thread
+    // Clean up the camera thread
     m_cameraThread->quit();
     m_cameraThread->wait(3000);
+
+    // Waits for a decode still running on the pool, it writes into m_decodedMailbox
+    delete m_frameDecoder;
 }
 
 void CameraViewModel::setupThread()
 {
     // Create camera model and move to thread
     m_cameraModel = new CameraModel();
+    m_cameraModel->setFrameMailbox(&m_frameMailbox);
+    m_cameraModel->setLinkStatistics(&m_linkStatistics);
+    m_cameraModel->setStreamRecorder(m_streamRecorder);
+    m_linkSampleTimer.start();
     m_cameraModel->moveToThread(m_cameraThread);
 
+    // Frames are decoded on the shared decoder pool, the GUI only receives ready images
+    m_frameDecoder = new FrameDecoder(&m_frameMailbox, &m_decodedMailbox);
+
     // Connect signals for thread communication
     connect(this, &CameraViewModel::requestStartStream,
             m_cameraModel, &CameraModel::startStreaming);
     connect(this, &CameraViewModel::requestStopStream,
             m_cameraModel, &CameraModel::stopStreaming);
+    connect(this, &CameraViewModel::requestBatchedIngest,
+            m_cameraModel, &CameraModel::setBatchedIngest);
+    connect(this, &CameraViewModel::requestReactorIngest,
+            m_cameraModel, &CameraModel::setReactorIngest);
+    connect(this, &CameraViewModel::requestNackEnabled,
+            m_cameraModel, &CameraModel::setNackEnabled);
+    connect(this, &CameraViewModel::requestMulticastGroup,
+            m_cameraModel, &CameraModel::setMulticastGroup);
+    connect(this, &CameraViewModel::requestRelayDestinations,
+            m_cameraModel, &CameraModel::setRelayDestinations);
+    connect(this, &CameraViewModel::requestRelayOnly,
+            m_cameraModel, &CameraModel::setRelayOnly);
+    connect(this, &CameraViewModel::requestFrameExport,
+            m_cameraModel, &CameraModel::setFrameExport);
+    connect(this, &CameraViewModel::requestJitterBufferMode,
+            m_cameraModel, &CameraModel::setJitterBufferMode);
+    connect(this, &CameraViewModel::requestJitterMaxDelay,
+            m_cameraModel, &CameraModel::setJitterBufferMaxDelay);
+    connect(this, &CameraViewModel::requestStartCapture,
+            m_cameraModel, &CameraModel::startCapture);
+    connect(this, &CameraViewModel::requestStopCapture,
+            m_cameraModel, &CameraModel::stopCapture);
+    connect(this, &CameraViewModel::requestStartReplay,
+            m_cameraModel, &CameraModel::startReplay);
 
     // Connect camera model signals
     connect(m_cameraModel, &CameraModel::streamingStatusChanged,
             this, &CameraViewModel::onStreamingStatusChanged);
-    connect(m_cameraModel, &CameraModel::frameReceived,
-            this, &CameraViewModel::onFrameReceived);
+    connect(m_cameraModel, &CameraModel::framePending,
+            m_frameDecoder, &FrameDecoder::schedule, Qt::DirectConnection);
+    connect(m_frameDecoder, &FrameDecoder::framePending,
+            this, &CameraViewModel::onFramePending);
+    connect(m_frameSource, &VideoFrameSource::requestedSizeChanged,
+            m_frameDecoder, &FrameDecoder::setTargetSize);
+    connect(this, &CameraViewModel::requestVideoFrameOutput,
+            m_frameDecoder, &FrameDecoder::setVideoFrameOutput);
+    connect(this, &CameraViewModel::requestProgressiveDisplay,
+            m_cameraModel, &CameraModel::setProgressiveDisplay);
+    connect(this, &CameraViewModel::requestProgressiveDisplay,
+            m_frameDecoder, &FrameDecoder::setProgressiveOutput);
+    connect(this, &CameraViewModel::requestDecodedFrameExport,
+            m_frameDecoder, &FrameDecoder::setFrameExport);
     connect(m_cameraModel, &CameraModel::errorOccurred,
             this, &CameraViewModel::onCameraError);
     connect(m_cameraModel, &CameraModel::connectionEstablished,
             this, &CameraViewModel::onConnectionEstablished);
-
-    // Cleanup when thread finishes
+    connect(m_cameraModel, &CameraModel::fecStatisticsChanged,
+            this, &CameraViewModel::onFecStatisticsChanged);
+    connect(m_cameraModel, &CameraModel::reassemblyStatisticsChanged,
+            this, &CameraViewModel::onReassemblyStatisticsChanged);
+    connect(m_cameraModel, &CameraModel::relayStatisticsChanged,
+            this, &CameraViewModel::onRelayStatisticsChanged);
+    connect(m_cameraModel, &CameraModel::frameExportStatisticsChanged,
+            this, &CameraViewModel::onFrameExportStatisticsChanged);
+    connect(m_cameraModel, &CameraModel::nackStatisticsChanged,
+            this, &CameraViewModel::onNackStatisticsChanged);
+    connect(m_cameraModel, &CameraModel::jitterStatisticsChanged,
+            this, &CameraViewModel::onJitterStatisticsChanged);
+    connect(m_cameraModel, &CameraModel::captureStatusChanged,
+            this, &CameraViewModel::onCaptureStatusChanged);
+    connect(m_cameraModel, &CameraModel::replayFinished,
+            this, &CameraViewModel::replayFinished);
+    connect(m_streamRecorder, &StreamRecorder::stopped,
+            this, &CameraViewModel::onStreamRecordingStopped);
+    connect(m_streamRecorder, &StreamRecorder::errorOccurred,
+            this, &CameraViewModel::onStreamRecordingError);
+
+    // Cleanup when the thread finishes
     connect(m_cameraThread, &QThread::finished, m_cameraModel, &QObject::deleteLater);
 
     // Start the thread
@@ -87,6 +158,150 @@ void CameraViewModel::setPort(int port)
     }
 }
 
+void CameraViewModel::setBatchedIngest(bool enabled)
+{
+    if (m_batchedIngest != enabled) {
+        m_batchedIngest = enabled;
+        emit requestBatchedIngest(enabled);
+        emit batchedIngestChanged();
+    }
+}
+
+void CameraViewModel::setReactorIngest(bool enabled)
+{
+    if (m_reactorIngest != enabled) {
+        m_reactorIngest = enabled;
+        emit requestReactorIngest(enabled);
+        emit reactorIngestChanged();
+    }
+}
+
+void CameraViewModel::setIngestThreads(int count)
+{
+    if (ingestThreads() != count) {
+        IngestReactor::instance()->setThreadCount(count);
+        emit ingestThreadsChanged();
+    }
+}
+
+void CameraViewModel::setMulticastGroup(const QString &group)
+{
+    if (m_multicastGroup != group) {
+        m_multicastGroup = group;
+        emit requestMulticastGroup(group);
+        emit multicastGroupChanged();
+    }
+}
+
+void CameraViewModel::setRelayDestinations(const QStringList &destinations)
+{
+    if (m_relayDestinations != destinations) {
+        m_relayDestinations = destinations;
+        emit requestRelayDestinations(destinations);
+        emit relayDestinationsChanged();
+    }
+}
+
+void CameraViewModel::setRelayOnly(bool enabled)
+{
+    if (m_relayOnly != enabled) {
+        m_relayOnly = enabled;
+        emit requestRelayOnly(enabled);
+        emit relayOnlyChanged();
+    }
+}
+
+void CameraViewModel::setFrameExportName(const QString &name)
+{
+    if (m_frameExportName != name) {
+        m_frameExportName = name;
+        emit requestFrameExport(name);
+        if (m_decodedFrameExport) {
+            emit requestDecodedFrameExport(name.isEmpty() ? QString() : name + "_decoded");
+        }
+        emit frameExportNameChanged();
+    }
+}
+
+void CameraViewModel::setDecodedFrameExport(bool enabled)
+{
+    if (m_decodedFrameExport != enabled) {
+        m_decodedFrameExport = enabled;
+        emit requestDecodedFrameExport(enabled && !m_frameExportName.isEmpty() ? m_frameExportName + "_decoded" : QString());
+        emit decodedFrameExportChanged();
+    }
+}
+
+void CameraViewModel::setNackEnabled(bool enabled)
+{
+    if (m_nackEnabled != enabled) {
+        m_nackEnabled = enabled;
+        emit requestNackEnabled(enabled);
+        emit nackEnabledChanged();
+    }
+}
+
+void CameraViewModel::setProgressiveDisplay(bool enabled)
+{
+    if (m_progressiveDisplay != enabled) {
+        m_progressiveDisplay = enabled;
+        emit requestProgressiveDisplay(enabled);
+        emit progressiveDisplayChanged();
+    }
+}
+
+void CameraViewModel::setVideoSinkOutput(bool enabled)
+{
+    if (m_videoSinkOutput != enabled) {
+        m_videoSinkOutput = enabled;
+        emit requestVideoFrameOutput(enabled);
+
+        // Neither output keeps showing a stale frame of the other path
+        if (enabled) {
+            m_frameSource->clear();
+        } else if (m_videoSink) {
+            m_videoSink->setVideoFrame(QVideoFrame());
+        }
+        m_frameSource->latency()->clear();
+        emit videoSinkOutputChanged();
+    }
+}
+
+void CameraViewModel::setVideoSink(QVideoSink *sink)
+{
+    if (m_videoSink != sink) {
+        m_videoSink = sink;
+        emit videoSinkChanged();
+    }
+}
+
+void CameraViewModel::setPrimaryDisplay(bool primary)
+{
+    if (m_primaryDisplay != primary) {
+        m_primaryDisplay = primary;
+        m_frameDecoder->setPriority(primary ? DecoderPool::Priority::Primary : DecoderPool::Priority::Secondary);
+        emit primaryDisplayChanged();
+    }
+}
+
+void CameraViewModel::setJitterBufferMode(JitterBufferMode mode)
+{
+    if (m_jitterBufferMode != mode) {
+        m_jitterBufferMode = mode;
+        emit requestJitterBufferMode(int(mode));
+        emit jitterBufferModeChanged();
+    }
+}
+
+void CameraViewModel::setJitterMaxDelay(int maxDelayMs)
+{
+    if (m_jitterMaxDelay != maxDelayMs && maxDelayMs >= 0) {
+        m_jitterMaxDelay = maxDelayMs;
+        emit requestJitterMaxDelay(maxDelayMs);
+        emit jitterMaxDelayChanged();
+    }
+}
+
 void CameraViewModel::toggleStream()
 {
     if (m_streaming) {
@@ -214,7 +429,10 @@ void CameraViewModel::onStreamingStatusChanged(bool streaming)
             m_cameraStatus = "Disconnected";
             m_frameCount = 0;
             m_frameRate = 0.0;
-            m_currentFrameUrl = "";
+            m_frameSource->clear();
+            if (m_videoSink) {
+                m_videoSink->setVideoFrame(QVideoFrame());
+            }
             emit cameraStatusChanged();
             emit frameCountChanged();
             emit frameRateChanged();
@@ -223,20 +441,50 @@ void CameraViewModel::onStreamingStatusChanged(bool streaming)
     }
 }
 
-void CameraViewModel::onFrameReceived(const QByteArray &frameData, quint16 frameId)
+void CameraViewModel::onFramePending()
 {
-    m_frameCount++;
-    m_framesInLastSecond++;
+    LatestFrameMailbox::Frame frame;
+    if (m_decodedMailbox.take(&frame)) {
+        onFrameReceived(frame);
+    }
+}
+
+void CameraViewModel::onFrameReceived(const LatestFrameMailbox::Frame &frame)
+{
+    const quint16 frameId = frame.frameId;
     m_lastFrameTime = QDateTime::currentMSecsSinceEpoch();
 
+    // Partial frames update the picture but are neither counted nor timed
+    const FrameTiming timing = frame.isPartial() ? FrameTiming() : frame.timing;
+    if (!frame.isPartial()) {
+        m_frameCount++;
+        m_framesInLastSecond++;
+        m_frameSource->addToHistory(frame);
+    }
+
     if (m_currentFrameId != frameId) {
         m_currentFrameId = frameId;
         emit frameIdChanged();
     }
 
-    qDebug() << "Frame received, frameId:" << frameId << "count:" << m_frameCount << "size:" << frameData.size();
-
-    updateFrameUrl(frameData);
+    if (frame.videoFrame.isValid()) {
+        // Color conversion happens in the VideoOutput
+        if (m_videoSink) {
+            m_videoSink->setVideoFrame(frame.videoFrame);
+            if (!frame.isPartial()) {
+                m_frameSource->history()->markPresented(frame.frameId);
+            }
+
+            // The VideoOutput does not report its frames, the handoff is the last stage seen
+            if (!frame.isPartial()) {
+                FrameTiming presentedTiming = timing;
+                presentedTiming.presented = FrameTiming::now();
+                m_frameSource->latency()->record(presentedTiming, ++m_sinkFrameSerial);
+            }
+        }
+    } else {
+        m_frameSource->setFrame(frame.image, timing, frame.isPartial() ? -1 : frame.frameId);
+    }
 
     emit frameCountChanged();
     emit frameChanged();
@@ -247,23 +495,6 @@ void CameraViewModel::onFrameReceived(const QByteArray &frameData, quint16 frame
     }
 }
 
-void CameraViewModel::updateFrameUrl(const QByteArray &frameData)
-{
-    // Update the image provider with new frame data
-    if (g_imageProvider) {
-        QString frameId = "camera_frame";
-        g_imageProvider->updateFrame(frameId, frameData);
-
-        // Create a unique URL to force QML to reload the image
-        // Use the frame count instead of timestamp for simpler ID matching
-        m_currentFrameUrl = QString("image://camera/%1?f=%2").arg(frameId).arg(m_frameCount);
-
-        qDebug() << "Updated frame URL:" << m_currentFrameUrl;
-    } else {
-        qDebug() << "ERROR: Image provider not available!";
-    }
-}
-
 void CameraViewModel::onCameraError(const QString &error)
 {
     m_cameraStatus = "Error: " + error;
@@ -278,90 +509,201 @@ void CameraViewModel::onConnectionEstablished()
     qDebug() << "Camera connection established";
 }
 
-void CameraViewModel::calculateFrameRate()
+void CameraViewModel::onFecStatisticsChanged(quint64 recoveredFrames, quint64 unrecoverableFrames)
 {
-    m_frameRate = m_framesInLastSecond;
-    m_framesInLastSecond = 0;
-    emit frameRateChanged();
+    if (m_fecRecoveredFrames != recoveredFrames || m_fecUnrecoverableFrames != unrecoverableFrames) {
+        m_fecRecoveredFrames = recoveredFrames;
+        m_fecUnrecoverableFrames = unrecoverableFrames;
+        emit fecStatisticsChanged();
+    }
+}
 
-    if (m_frameRate > 0) {
-        qDebug() << "Current FPS:" << m_frameRate;
+void CameraViewModel::onReassemblyStatisticsChanged(qint64 bytesInUse, qint64 peakBytes, quint64 evictedFrames)
+{
+    if (m_reassemblyBytes != bytesInUse || m_reassemblyPeakBytes != peakBytes
+        || m_reassemblyEvictedFrames != evictedFrames) {
+        m_reassemblyBytes = bytesInUse;
+        m_reassemblyPeakBytes = peakBytes;
+        m_reassemblyEvictedFrames = evictedFrames;
+        emit reassemblyStatisticsChanged();
     }
 }
 
-// CameraImageProvider implementation
-CameraImageProvider::CameraImageProvider()
-    : QQuickImageProvider(QQuickImageProvider::Pixmap)
+void CameraViewModel::onRelayStatisticsChanged(quint64 forwardedDatagrams, quint64 droppedDatagrams)
 {
-    g_imageProvider = this;
-    qDebug() << "CameraImageProvider created";
+    if (m_relayedDatagrams != forwardedDatagrams || m_relayDroppedDatagrams != droppedDatagrams) {
+        m_relayedDatagrams = forwardedDatagrams;
+        m_relayDroppedDatagrams = droppedDatagrams;
+        emit relayStatisticsChanged();
+    }
 }
 
-QPixmap CameraImageProvider::requestPixmap(const QString &id, QSize *size, const QSize &requestedSize)
+void CameraViewModel::onFrameExportStatisticsChanged(quint64 exportedFrames, quint64 oversizedFrames)
 {
-    QMutexLocker locker(&m_mutex);
+    if (m_exportedFrames != exportedFrames || m_exportOversizedFrames != oversizedFrames) {
+        m_exportedFrames = exportedFrames;
+        m_exportOversizedFrames = oversizedFrames;
+        emit frameExportStatisticsChanged();
+    }
+}
 
-    // Extract the base ID (remove query parameters)
-    QString baseId = id;
-    int queryIndex = id.indexOf('?');
-    if (queryIndex != -1) {
-        baseId = id.left(queryIndex);
+void CameraViewModel::onNackStatisticsChanged(quint64 requests, quint64 fragments)
+{
+    if (m_nackRequests != requests || m_nackedFragments != fragments) {
+        m_nackRequests = requests;
+        m_nackedFragments = fragments;
+        emit nackStatisticsChanged();
     }
+}
 
-    qDebug() << "Image provider requested pixmap for ID:" << id << "-> Base ID:" << baseId;
+void CameraViewModel::onJitterStatisticsChanged(int occupancy, quint64 lateDrops, int targetDelayMs)
+{
+    if (m_jitterBufferOccupancy != occupancy || m_jitterLateDrops != lateDrops
+        || m_jitterTargetDelay != targetDelayMs) {
+        m_jitterBufferOccupancy = occupancy;
+        m_jitterLateDrops = lateDrops;
+        m_jitterTargetDelay = targetDelayMs;
+        emit jitterStatisticsChanged();
+    }
+}
 
-    if (!m_frameData.contains(baseId)) {
-        // Return a placeholder pixmap if no data available
-        QPixmap placeholder(320, 240);
-        placeholder.fill(Qt::gray);
+void CameraViewModel::startStreamRecording(const QString &folder)
+{
+    m_streamRecordingPath = StreamRecorder::outputPath(folder, "camera");
+    m_streamRecorder->start(m_streamRecordingPath);
+    m_streamRecordedFrames = 0;
+    m_streamRecordingDroppedFrames = 0;
+    emit streamRecordingChanged();
+    emit streamRecordingStatisticsChanged();
+}
 
-        // Draw text on placeholder
-        QPainter painter(&placeholder);
-        painter.setPen(Qt::white);
-        painter.setFont(QFont("Arial", 12, QFont::Bold));
-        painter.drawText(placeholder.rect(), Qt::AlignCenter, "No Frame Data");
+void CameraViewModel::stopStreamRecording()
+{
+    if (m_streamRecorder->isRecording()) {
+        m_streamRecorder->stop();
+        emit streamRecordingChanged();
+    }
+}
 
-        if (size) *size = placeholder.size();
-        qDebug() << "No frame data available for base ID:" << baseId << ", returning gray placeholder";
-        return placeholder;
+void CameraViewModel::onStreamRecordingStopped(const QString &filePath, quint64 frames)
+{
+    if (filePath == m_streamRecordingPath) {
+        m_streamRecordedFrames = frames;
+        m_streamRecordingDroppedFrames = m_streamRecorder->droppedFrames();
+        emit streamRecordingStatisticsChanged();
     }
+}
 
-    QByteArray frameData = m_frameData[baseId];
-    QPixmap pixmap;
+void CameraViewModel::onStreamRecordingError(const QString &error)
+{
+    qDebug() << "Stream recording error:" << error;
+    emit streamRecordingChanged();
+    emit streamRecordingError(error);
+}
 
-    qDebug() << "Loading frame data for base ID:" << baseId << ", size:" << frameData.size() << "bytes";
+void CameraViewModel::startPacketCapture(const QString &folder)
+{
+    emit requestStartCapture(StreamRecorder::outputPath(folder, "camera", "udpcap"));
+}
 
-    if (pixmap.loadFromData(frameData, "JPEG")) {
-        if (size) *size = pixmap.size();
+void CameraViewModel::stopPacketCapture()
+{
+    emit requestStopCapture();
+}
 
-        qDebug() << "Successfully loaded pixmap, size:" << pixmap.size();
+void CameraViewModel::replayCapture(const QString &filePath, bool realTime)
+{
+    // Accepts file:// URLs from a QML FileDialog
+    const QUrl url(filePath);
+    emit requestStartReplay(url.isLocalFile() ? url.toLocalFile() : filePath, realTime);
+}
 
-        if (!requestedSize.isEmpty()) {
-            QPixmap scaled = pixmap.scaled(requestedSize, Qt::KeepAspectRatio, Qt::SmoothTransformation);
-            qDebug() << "Scaled pixmap to:" << scaled.size();
-            return scaled;
-        }
-        return pixmap;
-    } else {
-        // Return error pixmap if failed to load
-        QPixmap errorPixmap(320, 240);
-        errorPixmap.fill(Qt::red);
+void CameraViewModel::onCaptureStatusChanged(bool capturing, const QString &filePath)
+{
+    m_packetCapturePath = capturing ? filePath : QString();
+    emit packetCaptureChanged();
+}
+
+void CameraViewModel::calculateFrameRate()
+{
+    m_frameRate = m_framesInLastSecond;
+    m_framesInLastSecond = 0;
+    m_displayDroppedFrames = m_frameMailbox.droppedFrames() + m_decodedMailbox.droppedFrames();
+    emit frameRateChanged();
+
+    m_decoderStatistics = m_frameDecoder->takeStatistics();
+    emit decoderStatisticsChanged();
+
+    m_latency = m_frameSource->latency()->snapshot();
+    m_latencyIncludesCapture = m_frameSource->latency()->hasCaptureTime();
+    emit latencyStatisticsChanged();
 
-        // Draw error text
-        QPainter painter(&errorPixmap);
-        painter.setPen(Qt::white);
-        painter.setFont(QFont("Arial", 12, QFont::Bold));
-        painter.drawText(errorPixmap.rect(), Qt::AlignCenter, "JPEG Load Error");
+    const LinkStatistics::Snapshot linkSnapshot = m_linkStatistics.snapshot();
+    m_linkRates = LinkStatistics::rates(m_linkSnapshot, linkSnapshot, m_linkSampleTimer.restart());
+    m_linkSnapshot = linkSnapshot;
+    emit linkStatisticsChanged();
 
-        if (size) *size = errorPixmap.size();
-        qDebug() << "Failed to load JPEG data for base ID:" << baseId << ", returning red error pixmap";
-        return errorPixmap;
+    if (m_streamRecorder->isRecording()) {
+        m_streamRecordedFrames = m_streamRecorder->recordedFrames();
+        m_streamRecordingDroppedFrames = m_streamRecorder->droppedFrames();
+        emit streamRecordingStatisticsChanged();
+    }
+
+    if (m_frameRate > 0) {
+        qDebug() << "Current FPS:" << m_frameRate;
     }
 }
 
-void CameraImageProvider::updateFrame(const QString &id, const QByteArray &frameData)
+QVariantList CameraViewModel::latencyStages() const
 {
-    QMutexLocker locker(&m_mutex);
-    m_frameData[id] = frameData;
-    qDebug() << "Image provider updated frame data for ID:" << id << "size:" << frameData.size();
+    QVariantList stages;
+    for (int stage = 0; stage < LatencyStatistics::StageCount; ++stage) {
+        const LatencyStatistics::Percentiles &latency = m_latency[stage];
+        stages.append(QVariantMap {
+            { "stage", LatencyStatistics::stageName(LatencyStatistics::Stage(stage)) },
+            { "p50", latency.p50 },
+            { "p95", latency.p95 },
+            { "p99", latency.p99 },
+            { "samples", latency.samples }
+        });
+    }
+    return stages;
+}
+
+QVariantMap CameraViewModel::linkRates() const
+{
+    return QVariantMap {
+        { "fragments", m_linkRates.fragmentsPerSecond },
+        { "bytes", m_linkRates.bytesPerSecond },
+        { "frames", m_linkRates.framesPerSecond },
+        { "duplicates", m_linkRates.duplicatesPerSecond },
+        { "outOfOrder", m_linkRates.outOfOrderPerSecond },
+        { "malformed", m_linkRates.malformedPerSecond },
+        { "late", m_linkRates.latePerSecond },
+        { "expired", m_linkRates.expiredPerSecond }
+    };
+}
+
+int CameraViewModel::presentedFrameId() const
+{
+    return m_frameSource->history()->presentedFrameId();
+}
+
+QString CameraViewModel::saveFrame(const QString &folder, int frameId)
+{
+    // The encoded frame exactly as received, no re-encode
+    FrameHistory::Entry entry;
+    const std::shared_ptr<FrameHistory> history = m_frameSource->history();
+    if (frameId < 0 ? !history->presentedFrame(&entry) : !history->find(quint16(frameId), &entry)) {
+        qDebug() << "Frame" << frameId << "is no longer in the history";
+        return QString();
+    }
+
+    const QString filePath = StreamRecorder::outputPath(folder, QString("camera_%1").arg(entry.frameId), "jpg");
+    QFile file(filePath);
+    if (!file.open(QIODevice::WriteOnly) || file.write(entry.data) != entry.data.size()) {
+        qDebug() << "Cannot save frame to" << filePath << file.errorString();
+        return QString();
+    }
+    return filePath;
 }
@@ -4,8 +4,15 @@
 #include <QObject>
 #include <QThread>
 #include <QPixmap>
-#include <QQuickImageProvider>
+#include <QImage>
+#include <QVideoSink>
+#include <QPointer>
+#include <QVariantList>
+#include <QVariantMap>
+#include <QElapsedTimer>
 #include "models/CameraModel.h"
+#include "models/framedecoder.h"
+#include "videoframesource.h"
 
 class CameraViewModel : public QObject
 {
@@ -19,11 +26,78 @@ class CameraViewModel : public QObject
     Q_PROPERTY(QString streamButtonColor READ streamButtonColor NOTIFY streamingChanged)
     Q_PROPERTY(QString cameraStatus READ cameraStatus NOTIFY cameraStatusChanged)
     Q_PROPERTY(bool trackingEnabled READ trackingEnabled NOTIFY trackingEnabledChanged)
+    Q_PROPERTY(bool batchedIngest READ batchedIngest WRITE setBatchedIngest NOTIFY batchedIngestChanged)
+    // Receive on the shared epoll ingest reactor; ingestThreads is the reactor's thread
+    // count, shared by all streams and applied to streams started afterwards
+    Q_PROPERTY(bool reactorIngest READ reactorIngest WRITE setReactorIngest NOTIFY reactorIngestChanged)
+    Q_PROPERTY(int ingestThreads READ ingestThreads WRITE setIngestThreads NOTIFY ingestThreadsChanged)
+    // Multicast group to receive from, empty for unicast; applied when the stream starts
+    Q_PROPERTY(QString multicastGroup READ multicastGroup WRITE setMulticastGroup NOTIFY multicastGroupChanged)
+
+    // Relay of the received datagrams, unmodified, to other stations ("host:port" each);
+    // relayOnly skips local decoding for a station that only forwards
+    Q_PROPERTY(QStringList relayDestinations READ relayDestinations WRITE setRelayDestinations NOTIFY relayDestinationsChanged)
+    Q_PROPERTY(bool relayOnly READ relayOnly WRITE setRelayOnly NOTIFY relayOnlyChanged)
+    Q_PROPERTY(quint64 relayedDatagrams READ relayedDatagrams NOTIFY relayStatisticsChanged)
+    Q_PROPERTY(quint64 relayDroppedDatagrams READ relayDroppedDatagrams NOTIFY relayStatisticsChanged)
+
+    // Export of the received frames to the POSIX shared memory ring /frameExportName for
+    // local analytics, empty to stop; decodedFrameExport also exports the decoded frames
+    // to /<frameExportName>_decoded. Linux only.
+    Q_PROPERTY(QString frameExportName READ frameExportName WRITE setFrameExportName NOTIFY frameExportNameChanged)
+    Q_PROPERTY(bool decodedFrameExport READ decodedFrameExport WRITE setDecodedFrameExport NOTIFY decodedFrameExportChanged)
+    Q_PROPERTY(quint64 exportedFrames READ exportedFrames NOTIFY frameExportStatisticsChanged)
+    Q_PROPERTY(quint64 exportOversizedFrames READ exportOversizedFrames NOTIFY frameExportStatisticsChanged)
 
     // Frame properties
-    Q_PROPERTY(QString currentFrameUrl READ currentFrameUrl NOTIFY frameChanged)
+    Q_PROPERTY(VideoFrameSource *frameSource READ frameSource CONSTANT)   // for VideoSurface
     Q_PROPERTY(int frameCount READ frameCount NOTIFY frameCountChanged)
     Q_PROPERTY(double frameRate READ frameRate NOTIFY frameRateChanged)
+    Q_PROPERTY(quint64 displayDroppedFrames READ displayDroppedFrames NOTIFY frameRateChanged)
+
+    // YUV frames for a VideoOutput's sink instead of RGB images for VideoSurface
+    Q_PROPERTY(bool videoSinkOutput READ videoSinkOutput WRITE setVideoSinkOutput NOTIFY videoSinkOutputChanged)
+    Q_PROPERTY(QVideoSink *videoSink READ videoSink WRITE setVideoSink NOTIFY videoSinkChanged)
+
+    // Decoding on the shared decoder pool, a stream that is not the primary display is
+    // decoded at a reduced rate
+    Q_PROPERTY(bool primaryDisplay READ primaryDisplay WRITE setPrimaryDisplay NOTIFY primaryDisplayChanged)
+    Q_PROPERTY(double decodeTimeMs READ decodeTimeMs NOTIFY decoderStatisticsChanged)
+    Q_PROPERTY(double decodeQueueWaitMs READ decodeQueueWaitMs NOTIFY decoderStatisticsChanged)
+    Q_PROPERTY(int decodeQueueDepth READ decodeQueueDepth NOTIFY decoderStatisticsChanged)
+
+    // Glass-to-glass latency over the last presented frames, from the sender's capture
+    // time when frames carry one, otherwise from the first fragment. latencyStages holds
+    // { stage, p50, p95, p99, samples } per pipeline stage, all in milliseconds.
+    Q_PROPERTY(double latencyP50 READ latencyP50 NOTIFY latencyStatisticsChanged)
+    Q_PROPERTY(double latencyP95 READ latencyP95 NOTIFY latencyStatisticsChanged)
+    Q_PROPERTY(double latencyP99 READ latencyP99 NOTIFY latencyStatisticsChanged)
+    Q_PROPERTY(bool latencyIncludesCapture READ latencyIncludesCapture NOTIFY latencyStatisticsChanged)
+    Q_PROPERTY(QVariantList latencyStages READ latencyStages NOTIFY latencyStatisticsChanged)
+
+    // Video link quality, counters since the model was created and rates over the last
+    // second. linkRates adds duplicates, outOfOrder, malformed, late and expired per second.
+    Q_PROPERTY(quint64 linkFragments READ linkFragments NOTIFY linkStatisticsChanged)
+    Q_PROPERTY(quint64 linkDuplicates READ linkDuplicates NOTIFY linkStatisticsChanged)
+    Q_PROPERTY(quint64 linkOutOfOrder READ linkOutOfOrder NOTIFY linkStatisticsChanged)
+    Q_PROPERTY(quint64 linkMalformed READ linkMalformed NOTIFY linkStatisticsChanged)
+    Q_PROPERTY(quint64 linkLateFragments READ linkLateFragments NOTIFY linkStatisticsChanged)
+    Q_PROPERTY(quint64 linkFramesCompleted READ linkFramesCompleted NOTIFY linkStatisticsChanged)
+    Q_PROPERTY(quint64 linkFramesExpired READ linkFramesExpired NOTIFY linkStatisticsChanged)
+    Q_PROPERTY(double linkFragmentsPerSecond READ linkFragmentsPerSecond NOTIFY linkStatisticsChanged)
+    Q_PROPERTY(double linkBytesPerSecond READ linkBytesPerSecond NOTIFY linkStatisticsChanged)
+    Q_PROPERTY(double linkJitterMs READ linkJitterMs NOTIFY linkStatisticsChanged)
+    Q_PROPERTY(QVariantMap linkRates READ linkRates NOTIFY linkStatisticsChanged)
+
+    // Recording of the received MJPEG stream as it arrived, without re-encoding
+    Q_PROPERTY(bool streamRecording READ streamRecording NOTIFY streamRecordingChanged)
+    Q_PROPERTY(QString streamRecordingPath READ streamRecordingPath NOTIFY streamRecordingChanged)
+    Q_PROPERTY(quint64 streamRecordedFrames READ streamRecordedFrames NOTIFY streamRecordingStatisticsChanged)
+    Q_PROPERTY(quint64 streamRecordingDroppedFrames READ streamRecordingDroppedFrames NOTIFY streamRecordingStatisticsChanged)
+
+    // Raw datagram capture for offline replay
+    Q_PROPERTY(bool packetCapturing READ packetCapturing NOTIFY packetCaptureChanged)
+    Q_PROPERTY(QString packetCapturePath READ packetCapturePath NOTIFY packetCaptureChanged)
     // Add to Q_PROPERTY section:
     Q_PROPERTY(bool showTrackingRect READ showTrackingRect NOTIFY trackingRectChanged)
     Q_PROPERTY(int trackingRectX READ trackingRectX NOTIFY trackingRectChanged)
@@ -31,7 +105,39 @@ class CameraViewModel : public QObject
 
     Q_PROPERTY(int currentFrameId READ currentFrameId NOTIFY frameIdChanged)
 
+    // Forward error correction counters
+    Q_PROPERTY(quint64 fecRecoveredFrames READ fecRecoveredFrames NOTIFY fecStatisticsChanged)
+    Q_PROPERTY(quint64 fecUnrecoverableFrames READ fecUnrecoverableFrames NOTIFY fecStatisticsChanged)
+
+    // Reassembly memory held by incomplete frames, and frames evicted to bound it
+    Q_PROPERTY(qint64 reassemblyBytes READ reassemblyBytes NOTIFY reassemblyStatisticsChanged)
+    Q_PROPERTY(qint64 reassemblyPeakBytes READ reassemblyPeakBytes NOTIFY reassemblyStatisticsChanged)
+    Q_PROPERTY(quint64 reassemblyEvictedFrames READ reassemblyEvictedFrames NOTIFY reassemblyStatisticsChanged)
+
+    // Selective retransmission of missing fragments over the control channel
+    Q_PROPERTY(bool nackEnabled READ nackEnabled WRITE setNackEnabled NOTIFY nackEnabledChanged)
+
+    // Show the top rows of a frame as they arrive, for senders using JPEG restart intervals
+    Q_PROPERTY(bool progressiveDisplay READ progressiveDisplay WRITE setProgressiveDisplay NOTIFY progressiveDisplayChanged)
+    Q_PROPERTY(quint64 nackRequests READ nackRequests NOTIFY nackStatisticsChanged)
+    Q_PROPERTY(quint64 nackedFragments READ nackedFragments NOTIFY nackStatisticsChanged)
+
+    // Playout jitter buffer
+    Q_PROPERTY(JitterBufferMode jitterBufferMode READ jitterBufferMode WRITE setJitterBufferMode NOTIFY jitterBufferModeChanged)
+    Q_PROPERTY(int jitterMaxDelay READ jitterMaxDelay WRITE setJitterMaxDelay NOTIFY jitterMaxDelayChanged)
+    Q_PROPERTY(int jitterBufferOccupancy READ jitterBufferOccupancy NOTIFY jitterStatisticsChanged)
+    Q_PROPERTY(quint64 jitterLateDrops READ jitterLateDrops NOTIFY jitterStatisticsChanged)
+    Q_PROPERTY(int jitterTargetDelay READ jitterTargetDelay NOTIFY jitterStatisticsChanged)
+
 public:
+    // Same order as JitterBuffer::Mode
+    enum JitterBufferMode {
+        LowestLatency,
+        Balanced,
+        Smooth
+    };
+    Q_ENUM(JitterBufferMode)
+
     explicit CameraViewModel(QObject *parent = nullptr);
     ~CameraViewModel();
     bool trackingEnabled() const { return m_trackingEnabled; }
@@ -43,19 +149,89 @@ public:
     QString streamButtonText() const { return m_streaming ? "Stop Stream" : "Start Stream"; }
     QString streamButtonColor() const { return m_streaming ? "#FF4444" : "#44BB44"; }
     QString cameraStatus() const { return m_cameraStatus; }
-    QString currentFrameUrl() const { return m_currentFrameUrl; }
     int frameCount() const { return m_frameCount; }
     double frameRate() const { return m_frameRate; }
+    bool batchedIngest() const { return m_batchedIngest; }
+    bool reactorIngest() const { return m_reactorIngest; }
+    int ingestThreads() const { return IngestReactor::instance()->threadCount(); }
+    QString multicastGroup() const { return m_multicastGroup; }
+    QStringList relayDestinations() const { return m_relayDestinations; }
+    bool relayOnly() const { return m_relayOnly; }
+    quint64 relayedDatagrams() const { return m_relayedDatagrams; }
+    quint64 relayDroppedDatagrams() const { return m_relayDroppedDatagrams; }
+    QString frameExportName() const { return m_frameExportName; }
+    bool decodedFrameExport() const { return m_decodedFrameExport; }
+    quint64 exportedFrames() const { return m_exportedFrames; }
+    quint64 exportOversizedFrames() const { return m_exportOversizedFrames; }
 
     // Property setters
     void setIpAddress(const QString &ipAddress);
     void setPort(int port);
+    void setBatchedIngest(bool enabled);
+    void setReactorIngest(bool enabled);
+    void setIngestThreads(int count);
+    void setMulticastGroup(const QString &group);
+    void setRelayDestinations(const QStringList &destinations);
+    void setRelayOnly(bool enabled);
+    void setFrameExportName(const QString &name);
+    void setDecodedFrameExport(bool enabled);
+    void setNackEnabled(bool enabled);
+    void setProgressiveDisplay(bool enabled);
+    void setJitterBufferMode(JitterBufferMode mode);
+    void setJitterMaxDelay(int maxDelayMs);
+    void setVideoSinkOutput(bool enabled);
+    void setVideoSink(QVideoSink *sink);
+    void setPrimaryDisplay(bool primary);
 
     //// Add to public getters:
     bool showTrackingRect() const { return m_showTrackingRect; }
     int trackingRectX() const { return m_trackingRectX; }
     int trackingRectY() const { return m_trackingRectY; }
     int currentFrameId() const { return m_currentFrameId; }
+    VideoFrameSource *frameSource() const { return m_frameSource; }
+    quint64 displayDroppedFrames() const { return m_displayDroppedFrames; }
+    bool videoSinkOutput() const { return m_videoSinkOutput; }
+    QVideoSink *videoSink() const { return m_videoSink; }
+    bool primaryDisplay() const { return m_primaryDisplay; }
+    double decodeTimeMs() const { return m_decoderStatistics.decodeTimeMs; }
+    double decodeQueueWaitMs() const { return m_decoderStatistics.queueWaitMs; }
+    int decodeQueueDepth() const { return m_decoderStatistics.queueDepth; }
+    double latencyP50() const { return m_latency[LatencyStatistics::Total].p50; }
+    double latencyP95() const { return m_latency[LatencyStatistics::Total].p95; }
+    double latencyP99() const { return m_latency[LatencyStatistics::Total].p99; }
+    bool latencyIncludesCapture() const { return m_latencyIncludesCapture; }
+    QVariantList latencyStages() const;
+    quint64 linkFragments() const { return m_linkSnapshot.fragments; }
+    quint64 linkDuplicates() const { return m_linkSnapshot.duplicates; }
+    quint64 linkOutOfOrder() const { return m_linkSnapshot.outOfOrder; }
+    quint64 linkMalformed() const { return m_linkSnapshot.malformed; }
+    quint64 linkLateFragments() const { return m_linkSnapshot.late; }
+    quint64 linkFramesCompleted() const { return m_linkSnapshot.framesCompleted; }
+    quint64 linkFramesExpired() const { return m_linkSnapshot.framesExpired; }
+    double linkFragmentsPerSecond() const { return m_linkRates.fragmentsPerSecond; }
+    double linkBytesPerSecond() const { return m_linkRates.bytesPerSecond; }
+    double linkJitterMs() const { return m_linkSnapshot.jitterMs; }
+    QVariantMap linkRates() const;
+    bool streamRecording() const { return m_streamRecorder->isRecording(); }
+    QString streamRecordingPath() const { return m_streamRecordingPath; }
+    quint64 streamRecordedFrames() const { return m_streamRecordedFrames; }
+    quint64 streamRecordingDroppedFrames() const { return m_streamRecordingDroppedFrames; }
+    bool packetCapturing() const { return !m_packetCapturePath.isEmpty(); }
+    QString packetCapturePath() const { return m_packetCapturePath; }
+    quint64 fecRecoveredFrames() const { return m_fecRecoveredFrames; }
+    quint64 fecUnrecoverableFrames() const { return m_fecUnrecoverableFrames; }
+    qint64 reassemblyBytes() const { return m_reassemblyBytes; }
+    qint64 reassemblyPeakBytes() const { return m_reassemblyPeakBytes; }
+    quint64 reassemblyEvictedFrames() const { return m_reassemblyEvictedFrames; }
+    bool nackEnabled() const { return m_nackEnabled; }
+    bool progressiveDisplay() const { return m_progressiveDisplay; }
+    quint64 nackRequests() const { return m_nackRequests; }
+    quint64 nackedFragments() const { return m_nackedFragments; }
+    JitterBufferMode jitterBufferMode() const { return m_jitterBufferMode; }
+    int jitterMaxDelay() const { return m_jitterMaxDelay; }
+    int jitterBufferOccupancy() const { return m_jitterBufferOccupancy; }
+    quint64 jitterLateDrops() const { return m_jitterLateDrops; }
+    int jitterTargetDelay() const { return m_jitterTargetDelay; }
 
     Q_INVOKABLE void toggleStream();
     Q_INVOKABLE void startStream();
@@ -63,6 +239,20 @@ public:
     Q_INVOKABLE void enableTracking();
     Q_INVOKABLE void disableTracking();
     Q_INVOKABLE void sendTarget(int x, int y, int w, int h);
+    // folder defaults to the Movies location
+    Q_INVOKABLE void startStreamRecording(const QString &folder = QString());
+    Q_INVOKABLE void stopStreamRecording();
+    // Captures every received datagram to folder (Movies when empty), and replays a
+    // capture through the camera model instead of the socket
+    Q_INVOKABLE void startPacketCapture(const QString &folder = QString());
+    Q_INVOKABLE void stopPacketCapture();
+    Q_INVOKABLE void replayCapture(const QString &filePath, bool realTime = true);
+    // Frame on screen right now, unlike currentFrameId which is the newest one decoded;
+    // -1 before the first frame
+    Q_INVOKABLE int presentedFrameId() const;
+    // Writes a recent frame as received to folder (Movies when empty), -1 for the one on
+    // screen; returns the file path, empty when the frame has left the history
+    Q_INVOKABLE QString saveFrame(const QString &folder = QString(), int frameId = -1);
     // Add this new method:
     Q_INVOKABLE void updateTrackingRect(int x, int y, bool show) {
         if (m_trackingRectX != x || m_trackingRectY != y || m_showTrackingRect != show) {
@@ -82,17 +272,71 @@ signals:
     void frameRateChanged();
     void trackingEnabledChanged();
     void frameIdChanged();
+    void batchedIngestChanged();
+    void reactorIngestChanged();
+    void ingestThreadsChanged();
+    void multicastGroupChanged();
+    void relayDestinationsChanged();
+    void relayOnlyChanged();
+    void relayStatisticsChanged();
+    void frameExportNameChanged();
+    void decodedFrameExportChanged();
+    void frameExportStatisticsChanged();
+    void fecStatisticsChanged();
+    void reassemblyStatisticsChanged();
+    void nackEnabledChanged();
+    void progressiveDisplayChanged();
+    void nackStatisticsChanged();
+    void jitterBufferModeChanged();
+    void jitterMaxDelayChanged();
+    void jitterStatisticsChanged();
+    void videoSinkOutputChanged();
+    void videoSinkChanged();
+    void primaryDisplayChanged();
+    void decoderStatisticsChanged();
+    void latencyStatisticsChanged();
+    void linkStatisticsChanged();
+    void streamRecordingChanged();
+    void streamRecordingStatisticsChanged();
+    void streamRecordingError(const QString &error);
+    void packetCaptureChanged();
+    void replayFinished(quint64 datagrams);
 
     // Internal signals for thread communication
     void requestStartStream(const QString &ipAddress, int port);
     void requestStopStream();
+    void requestBatchedIngest(bool enabled);
+    void requestReactorIngest(bool enabled);
+    void requestMulticastGroup(const QString &group);
+    void requestRelayDestinations(const QStringList &destinations);
+    void requestRelayOnly(bool enabled);
+    void requestFrameExport(const QString &name);
+    void requestDecodedFrameExport(const QString &name);
+    void requestNackEnabled(bool enabled);
+    void requestProgressiveDisplay(bool enabled);
+    void requestJitterBufferMode(int mode);
+    void requestJitterMaxDelay(int maxDelayMs);
+    void requestStartCapture(const QString &filePath);
+    void requestStopCapture();
+    void requestStartReplay(const QString &filePath, bool realTime);
+    void requestVideoFrameOutput(bool enabled);
     // Add to signals:
     void trackingRectChanged();
 private slots:
     void onStreamingStatusChanged(bool streaming);
-    void onFrameReceived(const QByteArray &frameData, quint16 frameId);
+    void onFramePending();
+    void onFrameReceived(const LatestFrameMailbox::Frame &frame);
     void onCameraError(const QString &error);
     void onConnectionEstablished();
+    void onFecStatisticsChanged(quint64 recoveredFrames, quint64 unrecoverableFrames);
+    void onReassemblyStatisticsChanged(qint64 bytesInUse, qint64 peakBytes, quint64 evictedFrames);
+    void onRelayStatisticsChanged(quint64 forwardedDatagrams, quint64 droppedDatagrams);
+    void onFrameExportStatisticsChanged(quint64 exportedFrames, quint64 oversizedFrames);
+    void onNackStatisticsChanged(quint64 requests, quint64 fragments);
+    void onJitterStatisticsChanged(int occupancy, quint64 lateDrops, int targetDelayMs);
+    void onStreamRecordingStopped(const QString &filePath, quint64 frames);
+    void onCaptureStatusChanged(bool capturing, const QString &filePath);
+    void onStreamRecordingError(const QString &error);
     void calculateFrameRate();
 
 private:
@@ -100,12 +344,14 @@ private:
     QThread *m_cameraThread;
     CameraModel *m_cameraModel;
 
+    // JPEG decoding on the shared decoder pool, fed by the camera model
+    FrameDecoder *m_frameDecoder;
+
     // Properties
     QString m_ipAddress;
     int m_port;
     bool m_streaming;
     QString m_cameraStatus;
-    QString m_currentFrameUrl;
     int m_frameCount;
     double m_frameRate;
     // Add to private members:
@@ -117,24 +363,57 @@ private:
     int m_framesInLastSecond;
     qint64 m_lastFrameTime;
     int m_currentFrameId = 0;
+    LatestFrameMailbox m_frameMailbox;      // encoded frames, camera model -> decoder
+    LatestFrameMailbox m_decodedMailbox;    // decoded frames, decoder -> view model
+    VideoFrameSource *m_frameSource;
+    quint64 m_displayDroppedFrames = 0;   // frames superseded in the mailboxes before display
+    bool m_videoSinkOutput = false;
+    QPointer<QVideoSink> m_videoSink;     // owned by the VideoOutput in QML
+    bool m_primaryDisplay = true;
+    FrameDecoder::Statistics m_decoderStatistics;
+    std::array<LatencyStatistics::Percentiles, LatencyStatistics::StageCount> m_latency;
+    bool m_latencyIncludesCapture = false;
+    quint64 m_sinkFrameSerial = 0;
+    LinkStatistics m_linkStatistics;           // written by the model under its buffer mutex, see setLinkStatistics()
+    LinkStatistics::Snapshot m_linkSnapshot;
+    LinkStatistics::Rates m_linkRates;
+    QElapsedTimer m_linkSampleTimer;
+    StreamRecorder *m_streamRecorder;           // fed by the model on its thread
+    QString m_streamRecordingPath;
+    quint64 m_streamRecordedFrames = 0;
+    quint64 m_streamRecordingDroppedFrames = 0;
+    QString m_packetCapturePath;    // empty unless capturing
+    quint64 m_fecRecoveredFrames = 0;
+    quint64 m_fecUnrecoverableFrames = 0;
+    qint64 m_reassemblyBytes = 0;
+    qint64 m_reassemblyPeakBytes = 0;
+    quint64 m_reassemblyEvictedFrames = 0;
+    QString m_multicastGroup;
+    QStringList m_relayDestinations;
+    bool m_relayOnly = false;
+    quint64 m_relayedDatagrams = 0;
+    quint64 m_relayDroppedDatagrams = 0;
+
+    // Shared memory frame export
+    QString m_frameExportName;
+    bool m_decodedFrameExport = false;
+    quint64 m_exportedFrames = 0;
+    quint64 m_exportOversizedFrames = 0;
+    bool m_nackEnabled = false;
+    bool m_progressiveDisplay = false;
+    quint64 m_nackRequests = 0;
+    quint64 m_nackedFragments = 0;
+    JitterBufferMode m_jitterBufferMode = LowestLatency;
+    int m_jitterMaxDelay = 200;
+    int m_jitterBufferOccupancy = 0;
+    quint64 m_jitterLateDrops = 0;
+    int m_jitterTargetDelay = 0;
 
     QUdpSocket *m_ctrlSocket;
     bool m_trackingEnabled;
+    bool m_batchedIngest;
+    bool m_reactorIngest;
     void setupThread();
-    void updateFrameUrl(const QByteArray &frameData);
-};
-
-// Custom image provider for displaying camera frames
-class CameraImageProvider : public QQuickImageProvider
-{
-public:
-    CameraImageProvider();
-    QPixmap requestPixmap(const QString &id, QSize *size, const QSize &requestedSize) override;
-    void updateFrame(const QString &id, const QByteArray &frameData);
-
-private:
-    QMap<QString, QByteArray> m_frameData;
-    QMutex m_mutex;
 };
 
 #endif // CAMERAVIEWMODEL_H
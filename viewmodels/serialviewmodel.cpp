@@ -1,4 +1,5 @@
 #include "serialviewmodel.h"
+#include "models/sharedframering.h"
 #include <QtMath>
 
 SerialViewModel::SerialViewModel(QObject *parent)
@@ -122,6 +123,21 @@ void SerialViewModel::onTelemetryDataReceived(const SerialWorker::TelemetryData
 {
     m_telemetryData = data;
     emit telemetryChanged();
+
+    // Stamped into the frames exported to analytics from now on
+    SharedFrameRingFormat::Telemetry telemetry;
+    telemetry.received = FrameTiming::now();
+    telemetry.gimbalPoseLat = data.gimbalPoseLat;
+    telemetry.gimbalPoseLon = data.gimbalPoseLon;
+    telemetry.gimbalRoll = data.gimbalRoll;
+    telemetry.gimbalPitch = data.gimbalPitch;
+    telemetry.gimbalYaw = data.gimbalYaw;
+    telemetry.yawMotorPose = data.yawMotorPose;
+    telemetry.pitchMotorPose = data.pitchMotorPose;
+    telemetry.gimbalPoseAlt = data.gimbalPoseAlt;
+    telemetry.battery = data.battery;
+    telemetry.signalStrength = data.signalStrength;
+    SharedFrameRing::updateTelemetry(telemetry);
     m_statusMessage = "Receiving telemetry data...";
     emit statusMessageChanged();
 }
@@ -0,0 +1,317 @@
+#include "streamsyncviewmodel.h"
+#include "models/streamrecorder.h"
+#include <QDebug>
+#include <QFile>
+#include <algorithm>
+
+StreamSyncViewModel::StreamSyncViewModel(QObject *parent)
+    : QObject(parent)
+    , m_visibleFrameSource(nullptr)
+    , m_thermalFrameSource(nullptr)
+    , m_enabled(true)
+    , m_tolerance(40.0)
+    , m_thermalOffset(0.0)
+    , m_hasPair(false)
+    , m_lastPaired(FrameTiming::now())
+    , m_synchronized(false)
+    , m_skewMs(0.0)
+    , m_matchedPairs(0)
+    , m_unpairedFrames(0)
+    , m_visibleRecorder(new StreamRecorder(this))
+    , m_thermalRecorder(new StreamRecorder(this))
+{
+    for (StreamRecorder *recorder : { m_visibleRecorder, m_thermalRecorder }) {
+        connect(recorder, &StreamRecorder::stopped, this, &StreamSyncViewModel::pairRecordingChanged);
+        connect(recorder, &StreamRecorder::errorOccurred, this, [this](const QString &error) {
+            qDebug() << "Pair recording error:" << error;
+            stopPairRecording();
+        });
+    }
+}
+
+StreamSyncViewModel::~StreamSyncViewModel()
+{
+    // Withdraw the display sizes the outputs requested from the streams
+    if (m_visibleSource) {
+        m_visibleSource->setConsumerSize(m_visibleFrameSource, QSize());
+    }
+    if (m_thermalSource) {
+        m_thermalSource->setConsumerSize(m_thermalFrameSource, QSize());
+    }
+}
+
+bool StreamSyncViewModel::pairRecording() const
+{
+    return m_visibleRecorder->isRecording() || m_thermalRecorder->isRecording();
+}
+
+void StreamSyncViewModel::setVisibleSource(VideoFrameSource *source)
+{
+    if (m_visibleSource == source) {
+        return;
+    }
+    if (m_visibleSource) {
+        disconnect(m_visibleSource, nullptr, this, nullptr);
+        m_visibleSource->setConsumerSize(m_visibleFrameSource, QSize());
+    }
+    if (m_visibleFrameSource) {
+        m_visibleFrameSource->deleteLater();
+    }
+
+    m_visibleSource = source;
+    m_visibleFrameSource = source ? createOutput(source) : nullptr;
+    reset();
+    emit visibleSourceChanged();
+    emit visibleFrameSourceChanged();
+}
+
+void StreamSyncViewModel::setThermalSource(VideoFrameSource *source)
+{
+    if (m_thermalSource == source) {
+        return;
+    }
+    if (m_thermalSource) {
+        disconnect(m_thermalSource, nullptr, this, nullptr);
+        m_thermalSource->setConsumerSize(m_thermalFrameSource, QSize());
+    }
+    if (m_thermalFrameSource) {
+        m_thermalFrameSource->deleteLater();
+    }
+
+    m_thermalSource = source;
+    m_thermalFrameSource = source ? createOutput(source) : nullptr;
+    reset();
+    emit thermalSourceChanged();
+    emit thermalFrameSourceChanged();
+}
+
+void StreamSyncViewModel::setEnabled(bool enabled)
+{
+    if (m_enabled != enabled) {
+        m_enabled = enabled;
+        reset();
+        if (!m_enabled) {
+            // Do not hold on to frames nobody shows
+            for (VideoFrameSource *output : { m_visibleFrameSource, m_thermalFrameSource }) {
+                if (output) {
+                    output->clear();
+                }
+            }
+            stopPairRecording();
+        }
+        emit enabledChanged();
+    }
+}
+
+void StreamSyncViewModel::setTolerance(double toleranceMs)
+{
+    toleranceMs = qMax(0.0, toleranceMs);
+    if (!qFuzzyCompare(m_tolerance, toleranceMs)) {
+        m_tolerance = toleranceMs;
+        emit toleranceChanged();
+    }
+}
+
+void StreamSyncViewModel::setThermalOffset(double offsetMs)
+{
+    if (!qFuzzyCompare(m_thermalOffset, offsetMs)) {
+        m_thermalOffset = offsetMs;
+        emit thermalOffsetChanged();
+    }
+}
+
+VideoFrameSource *StreamSyncViewModel::createOutput(VideoFrameSource *upstream)
+{
+    VideoFrameSource *output = new VideoFrameSource(upstream, this);
+
+    // Surfaces showing the output size the upstream decoder like their own consumers
+    QPointer<VideoFrameSource> stream(upstream);
+    connect(output, &VideoFrameSource::requestedSizeChanged, output, [stream, output](const QSize &size) {
+        if (stream) {
+            stream->setConsumerSize(output, size);
+        }
+    });
+    connect(upstream, &VideoFrameSource::frameAdded, this, &StreamSyncViewModel::synchronize);
+    return output;
+}
+
+qint64 StreamSyncViewModel::captureTime(const FrameHistory::Entry &entry)
+{
+    return entry.timing.capture;
+}
+
+qint64 StreamSyncViewModel::arrivalTime(const FrameHistory::Entry &entry)
+{
+    return entry.timing.firstFragment ? entry.timing.firstFragment : entry.timing.reassembled;
+}
+
+void StreamSyncViewModel::synchronize()
+{
+    if (!m_enabled || !m_visibleSource || !m_thermalSource) {
+        return;
+    }
+
+    // Both histories hold frames of roughly the last second, pairing them all is cheap
+    QList<FrameHistory::Entry> visibleEntries = m_visibleSource->history()->entries();
+    const QList<FrameHistory::Entry> thermalEntries = m_thermalSource->history()->entries();
+    std::sort(visibleEntries.begin(), visibleEntries.end(),
+              [](const FrameHistory::Entry &a, const FrameHistory::Entry &b) { return arrivalTime(a) > arrivalTime(b); });
+
+    const qint64 toleranceUs = qint64(m_tolerance * 1000.0);
+    const qint64 offsetUs = qint64(m_thermalOffset * 1000.0);
+
+    for (const FrameHistory::Entry &visible : std::as_const(visibleEntries)) {
+        if (m_hasPair && arrivalTime(visible) <= arrivalTime(m_visibleEntry)) {
+            break;      // shown already, never step back
+        }
+
+        const FrameHistory::Entry *match = nullptr;
+        qint64 matchSkew = 0;
+        bool partnerMissed = false;
+        for (const FrameHistory::Entry &thermal : thermalEntries) {
+            // A slower thermal stream may pair with consecutive visible frames
+            if (m_hasPair && arrivalTime(thermal) < arrivalTime(m_thermalEntry)) {
+                continue;
+            }
+            const bool captured = captureTime(visible) != 0 && captureTime(thermal) != 0;
+            const qint64 skew = (captured ? captureTime(thermal) - captureTime(visible)
+                                          : arrivalTime(thermal) - arrivalTime(visible)) + offsetUs;
+            partnerMissed = partnerMissed || skew > toleranceUs;
+            if (!match || qAbs(skew) < qAbs(matchSkew)) {
+                match = &thermal;
+                matchSkew = skew;
+            }
+        }
+        if (match && qAbs(matchSkew) <= toleranceUs) {
+            publishPair(visible, *match, matchSkew);
+            return;
+        }
+
+        // A thermal frame taken after this one's window has arrived, so no partner will
+        // follow: a faster visible stream shows its frame next to the last thermal one
+        // rather than skipping it
+        if (partnerMissed) {
+            publish(m_visibleFrameSource, visible);
+            m_visibleEntry = visible;
+            m_hasPair = true;
+            m_unpairedFrames++;
+            emit pairStatisticsChanged();
+            return;
+        }
+    }
+
+    // One stream is down or the clocks are too far apart: show the streams unpaired
+    // rather than freezing them
+    if (FrameTiming::now() - m_lastPaired < UnmatchedTimeout) {
+        return;
+    }
+    if (!visibleEntries.isEmpty()
+        && (!m_hasPair || arrivalTime(visibleEntries.first()) > arrivalTime(m_visibleEntry))) {
+        publish(m_visibleFrameSource, visibleEntries.first());
+        m_visibleEntry = visibleEntries.first();
+        m_unpairedFrames++;
+        emit pairStatisticsChanged();
+    }
+    const auto newestThermal = std::max_element(thermalEntries.cbegin(), thermalEntries.cend(),
+        [](const FrameHistory::Entry &a, const FrameHistory::Entry &b) { return arrivalTime(a) < arrivalTime(b); });
+    if (newestThermal != thermalEntries.cend()
+        && (!m_hasPair || arrivalTime(*newestThermal) > arrivalTime(m_thermalEntry))) {
+        publish(m_thermalFrameSource, *newestThermal);
+        m_thermalEntry = *newestThermal;
+    }
+    m_hasPair = true;
+    setSynchronized(false);
+}
+
+void StreamSyncViewModel::publish(VideoFrameSource *output, const FrameHistory::Entry &entry)
+{
+    // Frames shown through a video sink are only in the history as video frames, and the
+    // history keeps no pixels at all for its older frames
+    QImage image = entry.image;
+    if (image.isNull() && entry.videoFrame.isValid()) {
+        image = entry.videoFrame.toImage();
+    }
+    if (image.isNull()) {
+        image = QImage::fromData(entry.data, "JPG");
+    }
+    output->setFrame(image, entry.timing, entry.frameId);
+}
+
+void StreamSyncViewModel::publishPair(const FrameHistory::Entry &visible, const FrameHistory::Entry &thermal, qint64 skew)
+{
+    publish(m_visibleFrameSource, visible);
+    if (!m_hasPair || thermal.frameId != m_thermalEntry.frameId || arrivalTime(thermal) != arrivalTime(m_thermalEntry)) {
+        publish(m_thermalFrameSource, thermal);
+    }
+    m_visibleEntry = visible;
+    m_thermalEntry = thermal;
+    m_hasPair = true;
+    m_lastPaired = FrameTiming::now();
+
+    // Both files share the visible frame's timeline, so they play back in step
+    const qint64 timestamp = captureTime(visible) ? captureTime(visible) : arrivalTime(visible);
+    m_visibleRecorder->addFrame(visible.data, timestamp);
+    m_thermalRecorder->addFrame(thermal.data, timestamp);
+
+    m_skewMs = skew / 1000.0;
+    m_matchedPairs++;
+    setSynchronized(true);
+    emit pairStatisticsChanged();
+    emit pairMatched(visible.frameId, thermal.frameId, m_skewMs);
+}
+
+void StreamSyncViewModel::setSynchronized(bool synchronized)
+{
+    if (m_synchronized != synchronized) {
+        m_synchronized = synchronized;
+        emit synchronizedChanged();
+    }
+}
+
+void StreamSyncViewModel::reset()
+{
+    m_visibleEntry = FrameHistory::Entry();
+    m_thermalEntry = FrameHistory::Entry();
+    m_hasPair = false;
+    m_lastPaired = FrameTiming::now();
+    setSynchronized(false);
+}
+
+QVariantMap StreamSyncViewModel::savePair(const QString &folder)
+{
+    QVariantMap paths;
+    if (!m_synchronized) {
+        qDebug() << "No synchronized pair to save";
+        return paths;
+    }
+
+    // The encoded frames exactly as received, no re-encode
+    const auto save = [&folder](const FrameHistory::Entry &entry, const QString &prefix) {
+        const QString filePath = StreamRecorder::outputPath(folder, QString("%1_%2").arg(prefix).arg(entry.frameId), "jpg");
+        QFile file(filePath);
+        if (!file.open(QIODevice::WriteOnly) || file.write(entry.data) != entry.data.size()) {
+            qDebug() << "Cannot save frame to" << filePath << file.errorString();
+            return QString();
+        }
+        return filePath;
+    };
+    paths.insert("visible", save(m_visibleEntry, "pair_visible"));
+    paths.insert("thermal", save(m_thermalEntry, "pair_thermal"));
+    return paths;
+}
+
+void StreamSyncViewModel::startPairRecording(const QString &folder)
+{
+    m_visibleRecorder->start(StreamRecorder::outputPath(folder, "pair_visible"));
+    m_thermalRecorder->start(StreamRecorder::outputPath(folder, "pair_thermal"));
+    emit pairRecordingChanged();
+}
+
+void StreamSyncViewModel::stopPairRecording()
+{
+    if (pairRecording()) {
+        m_visibleRecorder->stop();
+        m_thermalRecorder->stop();
+        emit pairRecordingChanged();
+    }
+}
@@ -0,0 +1,138 @@
+#ifndef STREAMSYNCVIEWMODEL_H
+#define STREAMSYNCVIEWMODEL_H
+
+#include <QObject>
+#include <QPointer>
+#include <QString>
+#include <QVariantMap>
+#include "videoframesource.h"
+#include "models/framehistory.h"
+
+class StreamRecorder;
+
+// Pairs the frames of the visible and the thermal stream by capture time.
+//
+// Each camera view model shows the frame that arrived last, and the two links drift
+// apart by several frames. This view model watches both streams' frame histories and,
+// whenever a frame is added, looks for the newest visible frame with a thermal frame
+// taken within tolerance of it. A matched pair is published at once on
+// visibleFrameSource() and thermalFrameSource(), which the swapped and fused views
+// display instead of the streams' own sources, and can be saved or recorded side by side.
+//
+// Frames are timed by the capture time the sender embeds; when either frame of a pair
+// lacks one, both are timed by the arrival of their first fragment instead.
+// thermalOffset is added to thermal times and compensates a constant difference between
+// the two senders' clocks or sensor pipelines. A visible frame that can no longer be
+// paired, because a later thermal frame arrived, is shown next to the last thermal
+// frame, so a slower thermal camera does not hold back the visible stream. When no
+// pair is found for UnmatchedTimeout, for instance while one stream is down, the newest
+// frames are shown unpaired and synchronized is false.
+class StreamSyncViewModel : public QObject
+{
+    Q_OBJECT
+
+    // Streams to pair, normally the camera view models' frame sources
+    Q_PROPERTY(VideoFrameSource* visibleSource READ visibleSource WRITE setVisibleSource NOTIFY visibleSourceChanged)
+    Q_PROPERTY(VideoFrameSource* thermalSource READ thermalSource WRITE setThermalSource NOTIFY thermalSourceChanged)
+
+    // Sync settings
+    Q_PROPERTY(bool enabled READ enabled WRITE setEnabled NOTIFY enabledChanged)
+    Q_PROPERTY(double tolerance READ tolerance WRITE setTolerance NOTIFY toleranceChanged)
+    Q_PROPERTY(double thermalOffset READ thermalOffset WRITE setThermalOffset NOTIFY thermalOffsetChanged)
+
+    // Paired frames, for VideoSurface
+    Q_PROPERTY(VideoFrameSource* visibleFrameSource READ visibleFrameSource NOTIFY visibleFrameSourceChanged)
+    Q_PROPERTY(VideoFrameSource* thermalFrameSource READ thermalFrameSource NOTIFY thermalFrameSourceChanged)
+
+    // Sync status, skew is thermal minus visible capture time of the last pair
+    Q_PROPERTY(bool synchronized READ synchronized NOTIFY synchronizedChanged)
+    Q_PROPERTY(double skewMs READ skewMs NOTIFY pairStatisticsChanged)
+    Q_PROPERTY(quint64 matchedPairs READ matchedPairs NOTIFY pairStatisticsChanged)
+    Q_PROPERTY(quint64 unpairedFrames READ unpairedFrames NOTIFY pairStatisticsChanged)
+
+    // Side by side recording of the paired frames
+    Q_PROPERTY(bool pairRecording READ pairRecording NOTIFY pairRecordingChanged)
+
+public:
+    static constexpr qint64 UnmatchedTimeout = 500000;     // microseconds
+
+    explicit StreamSyncViewModel(QObject *parent = nullptr);
+    ~StreamSyncViewModel();
+
+    VideoFrameSource *visibleSource() const { return m_visibleSource; }
+    VideoFrameSource *thermalSource() const { return m_thermalSource; }
+    bool enabled() const { return m_enabled; }
+    double tolerance() const { return m_tolerance; }
+    double thermalOffset() const { return m_thermalOffset; }
+    VideoFrameSource *visibleFrameSource() const { return m_visibleFrameSource; }
+    VideoFrameSource *thermalFrameSource() const { return m_thermalFrameSource; }
+    bool synchronized() const { return m_synchronized; }
+    double skewMs() const { return m_skewMs; }
+    quint64 matchedPairs() const { return m_matchedPairs; }
+    quint64 unpairedFrames() const { return m_unpairedFrames; }
+    bool pairRecording() const;
+
+    void setVisibleSource(VideoFrameSource *source);
+    void setThermalSource(VideoFrameSource *source);
+    void setEnabled(bool enabled);
+    void setTolerance(double toleranceMs);
+    void setThermalOffset(double offsetMs);
+
+    // Writes both frames of the pair shown last as received; returns the file paths
+    // as "visible" and "thermal", empty when nothing was paired yet
+    Q_INVOKABLE QVariantMap savePair(const QString &folder = QString());
+
+    Q_INVOKABLE void startPairRecording(const QString &folder = QString());
+    Q_INVOKABLE void stopPairRecording();
+
+signals:
+    void visibleSourceChanged();
+    void thermalSourceChanged();
+    void enabledChanged();
+    void toleranceChanged();
+    void thermalOffsetChanged();
+    void visibleFrameSourceChanged();
+    void thermalFrameSourceChanged();
+    void synchronizedChanged();
+    void pairStatisticsChanged();
+    void pairRecordingChanged();
+    void pairMatched(quint16 visibleFrameId, quint16 thermalFrameId, double skewMs);
+
+private slots:
+    void synchronize();
+
+private:
+    static qint64 captureTime(const FrameHistory::Entry &entry);
+    static qint64 arrivalTime(const FrameHistory::Entry &entry);
+
+    VideoFrameSource *createOutput(VideoFrameSource *upstream);
+    void publish(VideoFrameSource *output, const FrameHistory::Entry &entry);
+    void publishPair(const FrameHistory::Entry &visible, const FrameHistory::Entry &thermal, qint64 skew);
+    void setSynchronized(bool synchronized);
+    void reset();
+
+    QPointer<VideoFrameSource> m_visibleSource;
+    QPointer<VideoFrameSource> m_thermalSource;
+    VideoFrameSource *m_visibleFrameSource;
+    VideoFrameSource *m_thermalFrameSource;
+
+    bool m_enabled;
+    double m_tolerance;                 // milliseconds
+    double m_thermalOffset;             // milliseconds
+
+    // Last published frames, the next pair must be newer on both streams
+    FrameHistory::Entry m_visibleEntry;
+    FrameHistory::Entry m_thermalEntry;
+    bool m_hasPair;
+    qint64 m_lastPaired;                // FrameTiming clock, 0 before the first pair
+
+    bool m_synchronized;
+    double m_skewMs;
+    quint64 m_matchedPairs;
+    quint64 m_unpairedFrames;
+
+    StreamRecorder *m_visibleRecorder;
+    StreamRecorder *m_thermalRecorder;
+};
+
+#endif // STREAMSYNCVIEWMODEL_H
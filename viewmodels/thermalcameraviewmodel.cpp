@@ -4,21 +4,24 @@
 #include <QQmlEngine>
 #include <QDebug>
 #include <QMutex>
-#include <QPainter>
-
-// Global thermal image provider instance
-static ThermalImageProvider* g_thermalImageProvider = nullptr;
+#include <QUrl>
+#include <QFile>
 
 ThermalCameraViewModel::ThermalCameraViewModel(QObject *parent)
     : QObject(parent)
     , m_thermalCameraThread(new QThread(this))
     , m_thermalCameraModel(nullptr)
+    , m_thermalFrameDecoder(nullptr)
     , m_thermalIpAddress("127.0.0.1")
     , m_thermalPort(5001)
     , m_thermalStreaming(false)
     , m_thermalCameraStatus("Disconnected")
     , m_thermalFrameCount(0)
     , m_thermalFrameRate(0.0)
+    , m_thermalBatchedIngest(UdpBatchReceiver::isSupported())
+    , m_thermalReactorIngest(IngestReactor::isSupported())
+    , m_thermalFrameSource(new VideoFrameSource(this))
+    , m_thermalStreamRecorder(new StreamRecorder(this))
     , m_thermalFrameRateTimer(new QTimer(this))
     , m_thermalFramesInLastSecond(0)
     , m_lastThermalFrameTime(0)
@@ -37,34 +40,91 @@ ThermalCameraViewModel::~ThermalCameraViewModel()
         stopThermalStream();
     }
 
-    // Clean up thread
+    // Clean up the camera thread
     m_thermalCameraThread->quit();
     m_thermalCameraThread->wait(3000);
+
+    // Waits for a decode still running on the pool, it writes into m_thermalDecodedMailbox
+    delete m_thermalFrameDecoder;
 }
 
 void ThermalCameraViewModel::setupThermalThread()
 {
     // Create thermal camera model and move to thread
     m_thermalCameraModel = new ThermalCameraModel();
+    m_thermalCameraModel->setFrameMailbox(&m_thermalFrameMailbox);
+    m_thermalCameraModel->setLinkStatistics(&m_thermalLinkStatistics);
+    m_thermalCameraModel->setStreamRecorder(m_thermalStreamRecorder);
+    m_thermalLinkSampleTimer.start();
     m_thermalCameraModel->moveToThread(m_thermalCameraThread);
 
+    // Frames are decoded on the shared decoder pool, the GUI only receives ready images
+    m_thermalFrameDecoder = new FrameDecoder(&m_thermalFrameMailbox, &m_thermalDecodedMailbox);
+    m_thermalFrameDecoder->setPriority(DecoderPool::Priority::Secondary);
+
     // Connect signals for thread communication
     connect(this, &ThermalCameraViewModel::requestStartThermalStream,
             m_thermalCameraModel, &ThermalCameraModel::startStreaming);
     connect(this, &ThermalCameraViewModel::requestStopThermalStream,
             m_thermalCameraModel, &ThermalCameraModel::stopStreaming);
+    connect(this, &ThermalCameraViewModel::requestThermalBatchedIngest,
+            m_thermalCameraModel, &ThermalCameraModel::setBatchedIngest);
+    connect(this, &ThermalCameraViewModel::requestThermalReactorIngest,
+            m_thermalCameraModel, &ThermalCameraModel::setReactorIngest);
 
     // Connect thermal camera model signals
     connect(m_thermalCameraModel, &ThermalCameraModel::streamingStatusChanged,
             this, &ThermalCameraViewModel::onThermalStreamingStatusChanged);
-    connect(m_thermalCameraModel, &ThermalCameraModel::frameReceived,
-            this, &ThermalCameraViewModel::onThermalFrameReceived);
+    connect(m_thermalCameraModel, &ThermalCameraModel::framePending,
+            m_thermalFrameDecoder, &FrameDecoder::schedule, Qt::DirectConnection);
+    connect(m_thermalFrameDecoder, &FrameDecoder::framePending,
+            this, &ThermalCameraViewModel::onThermalFramePending);
+    connect(m_thermalFrameSource, &VideoFrameSource::requestedSizeChanged,
+            m_thermalFrameDecoder, &FrameDecoder::setTargetSize);
+    connect(this, &ThermalCameraViewModel::requestThermalVideoFrameOutput,
+            m_thermalFrameDecoder, &FrameDecoder::setVideoFrameOutput);
+    connect(this, &ThermalCameraViewModel::requestThermalProgressiveDisplay,
+            m_thermalCameraModel, &ThermalCameraModel::setProgressiveDisplay);
+    connect(this, &ThermalCameraViewModel::requestThermalMulticastGroup,
+            m_thermalCameraModel, &ThermalCameraModel::setMulticastGroup);
+    connect(this, &ThermalCameraViewModel::requestThermalRelayDestinations,
+            m_thermalCameraModel, &ThermalCameraModel::setRelayDestinations);
+    connect(this, &ThermalCameraViewModel::requestThermalRelayOnly,
+            m_thermalCameraModel, &ThermalCameraModel::setRelayOnly);
+    connect(this, &ThermalCameraViewModel::requestThermalFrameExport,
+            m_thermalCameraModel, &ThermalCameraModel::setFrameExport);
+    connect(this, &ThermalCameraViewModel::requestThermalProgressiveDisplay,
+            m_thermalFrameDecoder, &FrameDecoder::setProgressiveOutput);
+    connect(this, &ThermalCameraViewModel::requestThermalDecodedFrameExport,
+            m_thermalFrameDecoder, &FrameDecoder::setFrameExport);
     connect(m_thermalCameraModel, &ThermalCameraModel::errorOccurred,
             this, &ThermalCameraViewModel::onThermalCameraError);
     connect(m_thermalCameraModel, &ThermalCameraModel::connectionEstablished,
             this, &ThermalCameraViewModel::onThermalConnectionEstablished);
-
-    // Cleanup when thread finishes
+    connect(m_thermalCameraModel, &ThermalCameraModel::fecStatisticsChanged,
+            this, &ThermalCameraViewModel::onThermalFecStatisticsChanged);
+    connect(m_thermalCameraModel, &ThermalCameraModel::reassemblyStatisticsChanged,
+            this, &ThermalCameraViewModel::onThermalReassemblyStatisticsChanged);
+    connect(m_thermalCameraModel, &ThermalCameraModel::relayStatisticsChanged,
+            this, &ThermalCameraViewModel::onThermalRelayStatisticsChanged);
+    connect(m_thermalCameraModel, &ThermalCameraModel::frameExportStatisticsChanged,
+            this, &ThermalCameraViewModel::onThermalFrameExportStatisticsChanged);
+    connect(this, &ThermalCameraViewModel::requestStartThermalCapture,
+            m_thermalCameraModel, &ThermalCameraModel::startCapture);
+    connect(this, &ThermalCameraViewModel::requestStopThermalCapture,
+            m_thermalCameraModel, &ThermalCameraModel::stopCapture);
+    connect(this, &ThermalCameraViewModel::requestStartThermalReplay,
+            m_thermalCameraModel, &ThermalCameraModel::startReplay);
+    connect(m_thermalCameraModel, &ThermalCameraModel::captureStatusChanged,
+            this, &ThermalCameraViewModel::onThermalCaptureStatusChanged);
+    connect(m_thermalCameraModel, &ThermalCameraModel::replayFinished,
+            this, &ThermalCameraViewModel::thermalReplayFinished);
+    connect(m_thermalStreamRecorder, &StreamRecorder::stopped,
+            this, &ThermalCameraViewModel::onThermalStreamRecordingStopped);
+    connect(m_thermalStreamRecorder, &StreamRecorder::errorOccurred,
+            this, &ThermalCameraViewModel::onThermalStreamRecordingError);
+
+    // Cleanup when the thread finishes
     connect(m_thermalCameraThread, &QThread::finished, m_thermalCameraModel, &QObject::deleteLater);
 
     // Start the thread
@@ -87,6 +147,116 @@ void ThermalCameraViewModel::setThermalPort(int port)
     }
 }
 
+void ThermalCameraViewModel::setThermalBatchedIngest(bool enabled)
+{
+    if (m_thermalBatchedIngest != enabled) {
+        m_thermalBatchedIngest = enabled;
+        emit requestThermalBatchedIngest(enabled);
+        emit thermalBatchedIngestChanged();
+    }
+}
+
+void ThermalCameraViewModel::setThermalReactorIngest(bool enabled)
+{
+    if (m_thermalReactorIngest != enabled) {
+        m_thermalReactorIngest = enabled;
+        emit requestThermalReactorIngest(enabled);
+        emit thermalReactorIngestChanged();
+    }
+}
+
+void ThermalCameraViewModel::setThermalMulticastGroup(const QString &group)
+{
+    if (m_thermalMulticastGroup != group) {
+        m_thermalMulticastGroup = group;
+        emit requestThermalMulticastGroup(group);
+        emit thermalMulticastGroupChanged();
+    }
+}
+
+void ThermalCameraViewModel::setThermalRelayDestinations(const QStringList &destinations)
+{
+    if (m_thermalRelayDestinations != destinations) {
+        m_thermalRelayDestinations = destinations;
+        emit requestThermalRelayDestinations(destinations);
+        emit thermalRelayDestinationsChanged();
+    }
+}
+
+void ThermalCameraViewModel::setThermalRelayOnly(bool enabled)
+{
+    if (m_thermalRelayOnly != enabled) {
+        m_thermalRelayOnly = enabled;
+        emit requestThermalRelayOnly(enabled);
+        emit thermalRelayOnlyChanged();
+    }
+}
+
+void ThermalCameraViewModel::setThermalFrameExportName(const QString &name)
+{
+    if (m_thermalFrameExportName != name) {
+        m_thermalFrameExportName = name;
+        emit requestThermalFrameExport(name);
+        if (m_thermalDecodedFrameExport) {
+            emit requestThermalDecodedFrameExport(name.isEmpty() ? QString() : name + "_decoded");
+        }
+        emit thermalFrameExportNameChanged();
+    }
+}
+
+void ThermalCameraViewModel::setThermalDecodedFrameExport(bool enabled)
+{
+    if (m_thermalDecodedFrameExport != enabled) {
+        m_thermalDecodedFrameExport = enabled;
+        emit requestThermalDecodedFrameExport(enabled && !m_thermalFrameExportName.isEmpty()
+                                              ? m_thermalFrameExportName + "_decoded" : QString());
+        emit thermalDecodedFrameExportChanged();
+    }
+}
+
+void ThermalCameraViewModel::setThermalProgressiveDisplay(bool enabled)
+{
+    if (m_thermalProgressiveDisplay != enabled) {
+        m_thermalProgressiveDisplay = enabled;
+        emit requestThermalProgressiveDisplay(enabled);
+        emit thermalProgressiveDisplayChanged();
+    }
+}
+
+void ThermalCameraViewModel::setThermalVideoSinkOutput(bool enabled)
+{
+    if (m_thermalVideoSinkOutput != enabled) {
+        m_thermalVideoSinkOutput = enabled;
+        emit requestThermalVideoFrameOutput(enabled);
+
+        // Neither output keeps showing a stale frame of the other path
+        if (enabled) {
+            m_thermalFrameSource->clear();
+        } else if (m_thermalVideoSink) {
+            m_thermalVideoSink->setVideoFrame(QVideoFrame());
+        }
+        m_thermalFrameSource->latency()->clear();
+        emit thermalVideoSinkOutputChanged();
+    }
+}
+
+void ThermalCameraViewModel::setThermalVideoSink(QVideoSink *sink)
+{
+    if (m_thermalVideoSink != sink) {
+        m_thermalVideoSink = sink;
+        emit thermalVideoSinkChanged();
+    }
+}
+
+void ThermalCameraViewModel::setThermalPrimaryDisplay(bool primary)
+{
+    if (m_thermalPrimaryDisplay != primary) {
+        m_thermalPrimaryDisplay = primary;
+        m_thermalFrameDecoder->setPriority(primary ? DecoderPool::Priority::Primary : DecoderPool::Priority::Secondary);
+        emit thermalPrimaryDisplayChanged();
+    }
+}
+
 void ThermalCameraViewModel::toggleThermalStream()
 {
     if (m_thermalStreaming) {
@@ -126,7 +296,10 @@ void ThermalCameraViewModel::onThermalStreamingStatusChanged(bool streaming)
             m_thermalCameraStatus = "Disconnected";
             m_thermalFrameCount = 0;
             m_thermalFrameRate = 0.0;
-            m_currentThermalFrameUrl = "";
+            m_thermalFrameSource->clear();
+            if (m_thermalVideoSink) {
+                m_thermalVideoSink->setVideoFrame(QVideoFrame());
+            }
             emit thermalCameraStatusChanged();
             emit thermalFrameCountChanged();
             emit thermalFrameRateChanged();
@@ -135,15 +308,44 @@ void ThermalCameraViewModel::onThermalStreamingStatusChanged(bool streaming)
     }
 }
 
-void ThermalCameraViewModel::onThermalFrameReceived(const QByteArray &frameData)
+void ThermalCameraViewModel::onThermalFramePending()
+{
+    LatestFrameMailbox::Frame frame;
+    if (m_thermalDecodedMailbox.take(&frame)) {
+        onThermalFrameReceived(frame);
+    }
+}
+
+void ThermalCameraViewModel::onThermalFrameReceived(const LatestFrameMailbox::Frame &frame)
 {
-    m_thermalFrameCount++;
-    m_thermalFramesInLastSecond++;
     m_lastThermalFrameTime = QDateTime::currentMSecsSinceEpoch();
 
-    qDebug() << "Thermal frame received, count:" << m_thermalFrameCount << "size:" << frameData.size();
+    // Partial frames update the picture but are neither counted nor timed
+    const FrameTiming timing = frame.isPartial() ? FrameTiming() : frame.timing;
+    if (!frame.isPartial()) {
+        m_thermalFrameCount++;
+        m_thermalFramesInLastSecond++;
+        m_thermalFrameSource->addToHistory(frame);
+    }
 
-    updateThermalFrameUrl(frameData);
+    if (frame.videoFrame.isValid()) {
+        // Color conversion happens in the VideoOutput
+        if (m_thermalVideoSink) {
+            m_thermalVideoSink->setVideoFrame(frame.videoFrame);
+            if (!frame.isPartial()) {
+                m_thermalFrameSource->history()->markPresented(frame.frameId);
+            }
+
+            // The VideoOutput does not report its frames, the handoff is the last stage seen
+            if (!frame.isPartial()) {
+                FrameTiming presentedTiming = timing;
+                presentedTiming.presented = FrameTiming::now();
+                m_thermalFrameSource->latency()->record(presentedTiming, ++m_thermalSinkFrameSerial);
+            }
+        }
+    } else {
+        m_thermalFrameSource->setFrame(frame.image, timing, frame.isPartial() ? -1 : frame.frameId);
+    }
 
     emit thermalFrameCountChanged();
     emit thermalFrameChanged();
@@ -154,22 +356,6 @@ void ThermalCameraViewModel::onThermalFrameReceived(const QByteArray &frameData)
     }
 }
 
-void ThermalCameraViewModel::updateThermalFrameUrl(const QByteArray &frameData)
-{
-    // Update the thermal image provider with new frame data
-    if (g_thermalImageProvider) {
-        QString frameId = "thermal_frame";
-        g_thermalImageProvider->updateFrame(frameId, frameData);
-
-        // Create a unique URL to force QML to reload the image
-        m_currentThermalFrameUrl = QString("image://thermal/%1?f=%2").arg(frameId).arg(m_thermalFrameCount);
-
-        qDebug() << "Updated thermal frame URL:" << m_currentThermalFrameUrl;
-    } else {
-        qDebug() << "ERROR: Thermal image provider not available!";
-    }
-}
-
 void ThermalCameraViewModel::onThermalCameraError(const QString &error)
 {
     m_thermalCameraStatus = "Error: " + error;
@@ -184,90 +370,181 @@ void ThermalCameraViewModel::onThermalConnectionEstablished()
     qDebug() << "Thermal camera connection established";
 }
 
-void ThermalCameraViewModel::calculateThermalFrameRate()
+void ThermalCameraViewModel::onThermalFecStatisticsChanged(quint64 recoveredFrames, quint64 unrecoverableFrames)
 {
-    m_thermalFrameRate = m_thermalFramesInLastSecond;
-    m_thermalFramesInLastSecond = 0;
-    emit thermalFrameRateChanged();
+    if (m_thermalFecRecoveredFrames != recoveredFrames || m_thermalFecUnrecoverableFrames != unrecoverableFrames) {
+        m_thermalFecRecoveredFrames = recoveredFrames;
+        m_thermalFecUnrecoverableFrames = unrecoverableFrames;
+        emit thermalFecStatisticsChanged();
+    }
+}
 
-    if (m_thermalFrameRate > 0) {
-        qDebug() << "Current Thermal FPS:" << m_thermalFrameRate;
+void ThermalCameraViewModel::onThermalReassemblyStatisticsChanged(qint64 bytesInUse, qint64 peakBytes, quint64 evictedFrames)
+{
+    if (m_thermalReassemblyBytes != bytesInUse || m_thermalReassemblyPeakBytes != peakBytes
+        || m_thermalReassemblyEvictedFrames != evictedFrames) {
+        m_thermalReassemblyBytes = bytesInUse;
+        m_thermalReassemblyPeakBytes = peakBytes;
+        m_thermalReassemblyEvictedFrames = evictedFrames;
+        emit thermalReassemblyStatisticsChanged();
+    }
+}
+
+void ThermalCameraViewModel::onThermalRelayStatisticsChanged(quint64 forwardedDatagrams, quint64 droppedDatagrams)
+{
+    if (m_thermalRelayedDatagrams != forwardedDatagrams || m_thermalRelayDroppedDatagrams != droppedDatagrams) {
+        m_thermalRelayedDatagrams = forwardedDatagrams;
+        m_thermalRelayDroppedDatagrams = droppedDatagrams;
+        emit thermalRelayStatisticsChanged();
     }
 }
 
-// ThermalImageProvider implementation
-ThermalImageProvider::ThermalImageProvider()
-    : QQuickImageProvider(QQuickImageProvider::Pixmap)
+void ThermalCameraViewModel::onThermalFrameExportStatisticsChanged(quint64 exportedFrames, quint64 oversizedFrames)
 {
-    g_thermalImageProvider = this;
-    qDebug() << "ThermalImageProvider created";
+    if (m_thermalExportedFrames != exportedFrames || m_thermalExportOversizedFrames != oversizedFrames) {
+        m_thermalExportedFrames = exportedFrames;
+        m_thermalExportOversizedFrames = oversizedFrames;
+        emit thermalFrameExportStatisticsChanged();
+    }
 }
 
-QPixmap ThermalImageProvider::requestPixmap(const QString &id, QSize *size, const QSize &requestedSize)
+void ThermalCameraViewModel::startThermalStreamRecording(const QString &folder)
 {
-    QMutexLocker locker(&m_mutex);
+    m_thermalStreamRecordingPath = StreamRecorder::outputPath(folder, "thermal");
+    m_thermalStreamRecorder->start(m_thermalStreamRecordingPath);
+    m_thermalStreamRecordedFrames = 0;
+    m_thermalStreamRecordingDroppedFrames = 0;
+    emit thermalStreamRecordingChanged();
+    emit thermalStreamRecordingStatisticsChanged();
+}
 
-    // Extract the base ID (remove query parameters)
-    QString baseId = id;
-    int queryIndex = id.indexOf('?');
-    if (queryIndex != -1) {
-        baseId = id.left(queryIndex);
+void ThermalCameraViewModel::stopThermalStreamRecording()
+{
+    if (m_thermalStreamRecorder->isRecording()) {
+        m_thermalStreamRecorder->stop();
+        emit thermalStreamRecordingChanged();
     }
+}
 
-    qDebug() << "Thermal image provider requested pixmap for ID:" << id << "-> Base ID:" << baseId;
+void ThermalCameraViewModel::onThermalStreamRecordingStopped(const QString &filePath, quint64 frames)
+{
+    if (filePath == m_thermalStreamRecordingPath) {
+        m_thermalStreamRecordedFrames = frames;
+        m_thermalStreamRecordingDroppedFrames = m_thermalStreamRecorder->droppedFrames();
+        emit thermalStreamRecordingStatisticsChanged();
+    }
+}
 
-    if (!m_frameData.contains(baseId)) {
-        // Return a placeholder pixmap if no data available
-        QPixmap placeholder(320, 240);
-        placeholder.fill(Qt::darkBlue);
+void ThermalCameraViewModel::onThermalStreamRecordingError(const QString &error)
+{
+    qDebug() << "Thermal stream recording error:" << error;
+    emit thermalStreamRecordingChanged();
+    emit thermalStreamRecordingError(error);
+}
 
-        // Draw text on placeholder
-        QPainter painter(&placeholder);
-        painter.setPen(Qt::white);
-        painter.setFont(QFont("Arial", 12, QFont::Bold));
-        painter.drawText(placeholder.rect(), Qt::AlignCenter, "No Thermal Data");
+void ThermalCameraViewModel::startThermalPacketCapture(const QString &folder)
+{
+    emit requestStartThermalCapture(StreamRecorder::outputPath(folder, "thermal", "udpcap"));
+}
 
-        if (size) *size = placeholder.size();
-        qDebug() << "No thermal frame data available for base ID:" << baseId << ", returning placeholder";
-        return placeholder;
-    }
+void ThermalCameraViewModel::stopThermalPacketCapture()
+{
+    emit requestStopThermalCapture();
+}
 
-    QByteArray frameData = m_frameData[baseId];
-    QPixmap pixmap;
+void ThermalCameraViewModel::replayThermalCapture(const QString &filePath, bool realTime)
+{
+    // Accepts file:// URLs from a QML FileDialog
+    const QUrl url(filePath);
+    emit requestStartThermalReplay(url.isLocalFile() ? url.toLocalFile() : filePath, realTime);
+}
 
-    qDebug() << "Loading thermal frame data for base ID:" << baseId << ", size:" << frameData.size() << "bytes";
+void ThermalCameraViewModel::onThermalCaptureStatusChanged(bool capturing, const QString &filePath)
+{
+    m_thermalPacketCapturePath = capturing ? filePath : QString();
+    emit thermalPacketCaptureChanged();
+}
 
-    if (pixmap.loadFromData(frameData, "JPEG")) {
-        if (size) *size = pixmap.size();
+void ThermalCameraViewModel::calculateThermalFrameRate()
+{
+    m_thermalFrameRate = m_thermalFramesInLastSecond;
+    m_thermalFramesInLastSecond = 0;
+    m_thermalDisplayDroppedFrames = m_thermalFrameMailbox.droppedFrames() + m_thermalDecodedMailbox.droppedFrames();
+    emit thermalFrameRateChanged();
 
-        qDebug() << "Successfully loaded thermal pixmap, size:" << pixmap.size();
+    m_thermalDecoderStatistics = m_thermalFrameDecoder->takeStatistics();
+    emit thermalDecoderStatisticsChanged();
 
-        if (!requestedSize.isEmpty()) {
-            QPixmap scaled = pixmap.scaled(requestedSize, Qt::KeepAspectRatio, Qt::SmoothTransformation);
-            qDebug() << "Scaled thermal pixmap to:" << scaled.size();
-            return scaled;
-        }
-        return pixmap;
-    } else {
-        // Return error pixmap if failed to load
-        QPixmap errorPixmap(320, 240);
-        errorPixmap.fill(Qt::darkRed);
+    m_thermalLatency = m_thermalFrameSource->latency()->snapshot();
+    m_thermalLatencyIncludesCapture = m_thermalFrameSource->latency()->hasCaptureTime();
+    emit thermalLatencyStatisticsChanged();
+
+    const LinkStatistics::Snapshot linkSnapshot = m_thermalLinkStatistics.snapshot();
+    m_thermalLinkRates = LinkStatistics::rates(m_thermalLinkSnapshot, linkSnapshot, m_thermalLinkSampleTimer.restart());
+    m_thermalLinkSnapshot = linkSnapshot;
+    emit thermalLinkStatisticsChanged();
+
+    if (m_thermalStreamRecorder->isRecording()) {
+        m_thermalStreamRecordedFrames = m_thermalStreamRecorder->recordedFrames();
+        m_thermalStreamRecordingDroppedFrames = m_thermalStreamRecorder->droppedFrames();
+        emit thermalStreamRecordingStatisticsChanged();
+    }
 
-        // Draw error text
-        QPainter painter(&errorPixmap);
-        painter.setPen(Qt::white);
-        painter.setFont(QFont("Arial", 12, QFont::Bold));
-        painter.drawText(errorPixmap.rect(), Qt::AlignCenter, "Thermal Load Error");
+    if (m_thermalFrameRate > 0) {
+        qDebug() << "Current Thermal FPS:" << m_thermalFrameRate;
+    }
+}
 
-        if (size) *size = errorPixmap.size();
-        qDebug() << "Failed to load thermal JPEG data for base ID:" << baseId << ", returning error pixmap";
-        return errorPixmap;
+QVariantList ThermalCameraViewModel::thermalLatencyStages() const
+{
+    QVariantList stages;
+    for (int stage = 0; stage < LatencyStatistics::StageCount; ++stage) {
+        const LatencyStatistics::Percentiles &latency = m_thermalLatency[stage];
+        stages.append(QVariantMap {
+            { "stage", LatencyStatistics::stageName(LatencyStatistics::Stage(stage)) },
+            { "p50", latency.p50 },
+            { "p95", latency.p95 },
+            { "p99", latency.p99 },
+            { "samples", latency.samples }
+        });
     }
+    return stages;
 }
 
-void ThermalImageProvider::updateFrame(const QString &id, const QByteArray &frameData)
+QVariantMap ThermalCameraViewModel::thermalLinkRates() const
 {
-    QMutexLocker locker(&m_mutex);
-    m_frameData[id] = frameData;
-    qDebug() << "Thermal image provider updated frame data for ID:" << id << "size:" << frameData.size();
+    return QVariantMap {
+        { "fragments", m_thermalLinkRates.fragmentsPerSecond },
+        { "bytes", m_thermalLinkRates.bytesPerSecond },
+        { "frames", m_thermalLinkRates.framesPerSecond },
+        { "duplicates", m_thermalLinkRates.duplicatesPerSecond },
+        { "outOfOrder", m_thermalLinkRates.outOfOrderPerSecond },
+        { "malformed", m_thermalLinkRates.malformedPerSecond },
+        { "late", m_thermalLinkRates.latePerSecond },
+        { "expired", m_thermalLinkRates.expiredPerSecond }
+    };
+}
+
+int ThermalCameraViewModel::thermalPresentedFrameId() const
+{
+    return m_thermalFrameSource->history()->presentedFrameId();
+}
+
+QString ThermalCameraViewModel::saveThermalFrame(const QString &folder, int frameId)
+{
+    // The encoded frame exactly as received, no re-encode
+    FrameHistory::Entry entry;
+    const std::shared_ptr<FrameHistory> history = m_thermalFrameSource->history();
+    if (frameId < 0 ? !history->presentedFrame(&entry) : !history->find(quint16(frameId), &entry)) {
+        qDebug() << "Frame" << frameId << "is no longer in the history";
+        return QString();
+    }
+
+    const QString filePath = StreamRecorder::outputPath(folder, QString("thermal_%1").arg(entry.frameId), "jpg");
+    QFile file(filePath);
+    if (!file.open(QIODevice::WriteOnly) || file.write(entry.data) != entry.data.size()) {
+        qDebug() << "Cannot save frame to" << filePath << file.errorString();
+        return QString();
+    }
+    return filePath;
 }
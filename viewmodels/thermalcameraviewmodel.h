@@ -4,10 +4,17 @@
 #include <QObject>
 #include <QThread>
 #include <QTimer>
-#include <QQuickImageProvider>
+#include <QImage>
 #include <QPixmap>
 #include <QMutex>
+#include <QVideoSink>
+#include <QPointer>
+#include <QVariantList>
+#include <QVariantMap>
+#include <QElapsedTimer>
 #include "models/ThermalCameraModel.h"
+#include "models/framedecoder.h"
+#include "videoframesource.h"
 
 class ThermalCameraViewModel : public QObject
 {
@@ -20,11 +27,82 @@ class ThermalCameraViewModel : public QObject
     Q_PROPERTY(QString thermalStreamButtonText READ thermalStreamButtonText NOTIFY thermalStreamingChanged)
     Q_PROPERTY(QString thermalStreamButtonColor READ thermalStreamButtonColor NOTIFY thermalStreamingChanged)
     Q_PROPERTY(QString thermalCameraStatus READ thermalCameraStatus NOTIFY thermalCameraStatusChanged)
+    Q_PROPERTY(bool thermalBatchedIngest READ thermalBatchedIngest WRITE setThermalBatchedIngest NOTIFY thermalBatchedIngestChanged)
+    // Receive on the shared epoll ingest reactor, see CameraViewModel::ingestThreads
+    Q_PROPERTY(bool thermalReactorIngest READ thermalReactorIngest WRITE setThermalReactorIngest NOTIFY thermalReactorIngestChanged)
+    // Show the top rows of a frame as they arrive, see CameraViewModel::progressiveDisplay
+    Q_PROPERTY(bool thermalProgressiveDisplay READ thermalProgressiveDisplay WRITE setThermalProgressiveDisplay NOTIFY thermalProgressiveDisplayChanged)
+
+    // Multicast reception and relay to other stations, see CameraViewModel::multicastGroup
+    // and CameraViewModel::relayDestinations
+    Q_PROPERTY(QString thermalMulticastGroup READ thermalMulticastGroup WRITE setThermalMulticastGroup NOTIFY thermalMulticastGroupChanged)
+    Q_PROPERTY(QStringList thermalRelayDestinations READ thermalRelayDestinations WRITE setThermalRelayDestinations NOTIFY thermalRelayDestinationsChanged)
+    Q_PROPERTY(bool thermalRelayOnly READ thermalRelayOnly WRITE setThermalRelayOnly NOTIFY thermalRelayOnlyChanged)
+    Q_PROPERTY(quint64 thermalRelayedDatagrams READ thermalRelayedDatagrams NOTIFY thermalRelayStatisticsChanged)
+    Q_PROPERTY(quint64 thermalRelayDroppedDatagrams READ thermalRelayDroppedDatagrams NOTIFY thermalRelayStatisticsChanged)
+
+    // Shared memory frame export, see CameraViewModel::frameExportName
+    Q_PROPERTY(QString thermalFrameExportName READ thermalFrameExportName WRITE setThermalFrameExportName NOTIFY thermalFrameExportNameChanged)
+    Q_PROPERTY(bool thermalDecodedFrameExport READ thermalDecodedFrameExport WRITE setThermalDecodedFrameExport NOTIFY thermalDecodedFrameExportChanged)
+    Q_PROPERTY(quint64 thermalExportedFrames READ thermalExportedFrames NOTIFY thermalFrameExportStatisticsChanged)
+    Q_PROPERTY(quint64 thermalExportOversizedFrames READ thermalExportOversizedFrames NOTIFY thermalFrameExportStatisticsChanged)
 
     // Thermal frame properties
-    Q_PROPERTY(QString currentThermalFrameUrl READ currentThermalFrameUrl NOTIFY thermalFrameChanged)
+    Q_PROPERTY(VideoFrameSource *thermalFrameSource READ thermalFrameSource CONSTANT)     // for VideoSurface
     Q_PROPERTY(int thermalFrameCount READ thermalFrameCount NOTIFY thermalFrameCountChanged)
     Q_PROPERTY(double thermalFrameRate READ thermalFrameRate NOTIFY thermalFrameRateChanged)
+    Q_PROPERTY(quint64 thermalDisplayDroppedFrames READ thermalDisplayDroppedFrames NOTIFY thermalFrameRateChanged)
+
+    // YUV frames for a VideoOutput's sink instead of RGB images for VideoSurface
+    Q_PROPERTY(bool thermalVideoSinkOutput READ thermalVideoSinkOutput WRITE setThermalVideoSinkOutput NOTIFY thermalVideoSinkOutputChanged)
+    Q_PROPERTY(QVideoSink *thermalVideoSink READ thermalVideoSink WRITE setThermalVideoSink NOTIFY thermalVideoSinkChanged)
+
+    // Decoding on the shared decoder pool, a stream that is not the primary display is
+    // decoded at a reduced rate
+    Q_PROPERTY(bool thermalPrimaryDisplay READ thermalPrimaryDisplay WRITE setThermalPrimaryDisplay NOTIFY thermalPrimaryDisplayChanged)
+    Q_PROPERTY(double thermalDecodeTimeMs READ thermalDecodeTimeMs NOTIFY thermalDecoderStatisticsChanged)
+    Q_PROPERTY(double thermalDecodeQueueWaitMs READ thermalDecodeQueueWaitMs NOTIFY thermalDecoderStatisticsChanged)
+    Q_PROPERTY(int thermalDecodeQueueDepth READ thermalDecodeQueueDepth NOTIFY thermalDecoderStatisticsChanged)
+
+    // Glass-to-glass latency, same layout as CameraViewModel's latency properties
+    Q_PROPERTY(double thermalLatencyP50 READ thermalLatencyP50 NOTIFY thermalLatencyStatisticsChanged)
+    Q_PROPERTY(double thermalLatencyP95 READ thermalLatencyP95 NOTIFY thermalLatencyStatisticsChanged)
+    Q_PROPERTY(double thermalLatencyP99 READ thermalLatencyP99 NOTIFY thermalLatencyStatisticsChanged)
+    Q_PROPERTY(bool thermalLatencyIncludesCapture READ thermalLatencyIncludesCapture NOTIFY thermalLatencyStatisticsChanged)
+    Q_PROPERTY(QVariantList thermalLatencyStages READ thermalLatencyStages NOTIFY thermalLatencyStatisticsChanged)
+
+    // Video link quality, counters since the model was created and rates over the last
+    // second. thermalLinkRates adds duplicates, outOfOrder, malformed, late and expired per second.
+    Q_PROPERTY(quint64 thermalLinkFragments READ thermalLinkFragments NOTIFY thermalLinkStatisticsChanged)
+    Q_PROPERTY(quint64 thermalLinkDuplicates READ thermalLinkDuplicates NOTIFY thermalLinkStatisticsChanged)
+    Q_PROPERTY(quint64 thermalLinkOutOfOrder READ thermalLinkOutOfOrder NOTIFY thermalLinkStatisticsChanged)
+    Q_PROPERTY(quint64 thermalLinkMalformed READ thermalLinkMalformed NOTIFY thermalLinkStatisticsChanged)
+    Q_PROPERTY(quint64 thermalLinkLateFragments READ thermalLinkLateFragments NOTIFY thermalLinkStatisticsChanged)
+    Q_PROPERTY(quint64 thermalLinkFramesCompleted READ thermalLinkFramesCompleted NOTIFY thermalLinkStatisticsChanged)
+    Q_PROPERTY(quint64 thermalLinkFramesExpired READ thermalLinkFramesExpired NOTIFY thermalLinkStatisticsChanged)
+    Q_PROPERTY(double thermalLinkFragmentsPerSecond READ thermalLinkFragmentsPerSecond NOTIFY thermalLinkStatisticsChanged)
+    Q_PROPERTY(double thermalLinkBytesPerSecond READ thermalLinkBytesPerSecond NOTIFY thermalLinkStatisticsChanged)
+    Q_PROPERTY(double thermalLinkJitterMs READ thermalLinkJitterMs NOTIFY thermalLinkStatisticsChanged)
+    Q_PROPERTY(QVariantMap thermalLinkRates READ thermalLinkRates NOTIFY thermalLinkStatisticsChanged)
+
+    // Recording of the received MJPEG stream as it arrived, without re-encoding
+    Q_PROPERTY(bool thermalStreamRecording READ thermalStreamRecording NOTIFY thermalStreamRecordingChanged)
+    Q_PROPERTY(QString thermalStreamRecordingPath READ thermalStreamRecordingPath NOTIFY thermalStreamRecordingChanged)
+    Q_PROPERTY(quint64 thermalStreamRecordedFrames READ thermalStreamRecordedFrames NOTIFY thermalStreamRecordingStatisticsChanged)
+    Q_PROPERTY(quint64 thermalStreamRecordingDroppedFrames READ thermalStreamRecordingDroppedFrames NOTIFY thermalStreamRecordingStatisticsChanged)
+
+    // Raw datagram capture for offline replay
+    Q_PROPERTY(bool thermalPacketCapturing READ thermalPacketCapturing NOTIFY thermalPacketCaptureChanged)
+    Q_PROPERTY(QString thermalPacketCapturePath READ thermalPacketCapturePath NOTIFY thermalPacketCaptureChanged)
+
+    // Forward error correction counters
+    Q_PROPERTY(quint64 thermalFecRecoveredFrames READ thermalFecRecoveredFrames NOTIFY thermalFecStatisticsChanged)
+    Q_PROPERTY(quint64 thermalFecUnrecoverableFrames READ thermalFecUnrecoverableFrames NOTIFY thermalFecStatisticsChanged)
+
+    // Reassembly memory held by incomplete frames, and frames evicted to bound it
+    Q_PROPERTY(qint64 thermalReassemblyBytes READ thermalReassemblyBytes NOTIFY thermalReassemblyStatisticsChanged)
+    Q_PROPERTY(qint64 thermalReassemblyPeakBytes READ thermalReassemblyPeakBytes NOTIFY thermalReassemblyStatisticsChanged)
+    Q_PROPERTY(quint64 thermalReassemblyEvictedFrames READ thermalReassemblyEvictedFrames NOTIFY thermalReassemblyStatisticsChanged)
 
 public:
     explicit ThermalCameraViewModel(QObject *parent = nullptr);
@@ -37,18 +115,86 @@ public:
     QString thermalStreamButtonText() const { return m_thermalStreaming ? "Stop" : "Start"; }
     QString thermalStreamButtonColor() const { return m_thermalStreaming ? "#FF4444" : "#44BB44"; }
     QString thermalCameraStatus() const { return m_thermalCameraStatus; }
-    QString currentThermalFrameUrl() const { return m_currentThermalFrameUrl; }
     int thermalFrameCount() const { return m_thermalFrameCount; }
     double thermalFrameRate() const { return m_thermalFrameRate; }
+    bool thermalBatchedIngest() const { return m_thermalBatchedIngest; }
+    bool thermalReactorIngest() const { return m_thermalReactorIngest; }
+    bool thermalProgressiveDisplay() const { return m_thermalProgressiveDisplay; }
+    QString thermalMulticastGroup() const { return m_thermalMulticastGroup; }
+    QStringList thermalRelayDestinations() const { return m_thermalRelayDestinations; }
+    bool thermalRelayOnly() const { return m_thermalRelayOnly; }
+    quint64 thermalRelayedDatagrams() const { return m_thermalRelayedDatagrams; }
+    quint64 thermalRelayDroppedDatagrams() const { return m_thermalRelayDroppedDatagrams; }
+    QString thermalFrameExportName() const { return m_thermalFrameExportName; }
+    bool thermalDecodedFrameExport() const { return m_thermalDecodedFrameExport; }
+    quint64 thermalExportedFrames() const { return m_thermalExportedFrames; }
+    quint64 thermalExportOversizedFrames() const { return m_thermalExportOversizedFrames; }
+    VideoFrameSource *thermalFrameSource() const { return m_thermalFrameSource; }
+    quint64 thermalDisplayDroppedFrames() const { return m_thermalDisplayDroppedFrames; }
+    bool thermalVideoSinkOutput() const { return m_thermalVideoSinkOutput; }
+    QVideoSink *thermalVideoSink() const { return m_thermalVideoSink; }
+    bool thermalPrimaryDisplay() const { return m_thermalPrimaryDisplay; }
+    double thermalDecodeTimeMs() const { return m_thermalDecoderStatistics.decodeTimeMs; }
+    double thermalDecodeQueueWaitMs() const { return m_thermalDecoderStatistics.queueWaitMs; }
+    int thermalDecodeQueueDepth() const { return m_thermalDecoderStatistics.queueDepth; }
+    double thermalLatencyP50() const { return m_thermalLatency[LatencyStatistics::Total].p50; }
+    double thermalLatencyP95() const { return m_thermalLatency[LatencyStatistics::Total].p95; }
+    double thermalLatencyP99() const { return m_thermalLatency[LatencyStatistics::Total].p99; }
+    bool thermalLatencyIncludesCapture() const { return m_thermalLatencyIncludesCapture; }
+    QVariantList thermalLatencyStages() const;
+    quint64 thermalLinkFragments() const { return m_thermalLinkSnapshot.fragments; }
+    quint64 thermalLinkDuplicates() const { return m_thermalLinkSnapshot.duplicates; }
+    quint64 thermalLinkOutOfOrder() const { return m_thermalLinkSnapshot.outOfOrder; }
+    quint64 thermalLinkMalformed() const { return m_thermalLinkSnapshot.malformed; }
+    quint64 thermalLinkLateFragments() const { return m_thermalLinkSnapshot.late; }
+    quint64 thermalLinkFramesCompleted() const { return m_thermalLinkSnapshot.framesCompleted; }
+    quint64 thermalLinkFramesExpired() const { return m_thermalLinkSnapshot.framesExpired; }
+    double thermalLinkFragmentsPerSecond() const { return m_thermalLinkRates.fragmentsPerSecond; }
+    double thermalLinkBytesPerSecond() const { return m_thermalLinkRates.bytesPerSecond; }
+    double thermalLinkJitterMs() const { return m_thermalLinkSnapshot.jitterMs; }
+    QVariantMap thermalLinkRates() const;
+    bool thermalStreamRecording() const { return m_thermalStreamRecorder->isRecording(); }
+    QString thermalStreamRecordingPath() const { return m_thermalStreamRecordingPath; }
+    quint64 thermalStreamRecordedFrames() const { return m_thermalStreamRecordedFrames; }
+    quint64 thermalStreamRecordingDroppedFrames() const { return m_thermalStreamRecordingDroppedFrames; }
+    bool thermalPacketCapturing() const { return !m_thermalPacketCapturePath.isEmpty(); }
+    QString thermalPacketCapturePath() const { return m_thermalPacketCapturePath; }
+    quint64 thermalFecRecoveredFrames() const { return m_thermalFecRecoveredFrames; }
+    quint64 thermalFecUnrecoverableFrames() const { return m_thermalFecUnrecoverableFrames; }
+    qint64 thermalReassemblyBytes() const { return m_thermalReassemblyBytes; }
+    qint64 thermalReassemblyPeakBytes() const { return m_thermalReassemblyPeakBytes; }
+    quint64 thermalReassemblyEvictedFrames() const { return m_thermalReassemblyEvictedFrames; }
 
     // Property setters
     void setThermalIpAddress(const QString &ipAddress);
     void setThermalPort(int port);
+    void setThermalBatchedIngest(bool enabled);
+    void setThermalReactorIngest(bool enabled);
+    void setThermalProgressiveDisplay(bool enabled);
+    void setThermalMulticastGroup(const QString &group);
+    void setThermalRelayDestinations(const QStringList &destinations);
+    void setThermalRelayOnly(bool enabled);
+    void setThermalFrameExportName(const QString &name);
+    void setThermalDecodedFrameExport(bool enabled);
+    void setThermalVideoSinkOutput(bool enabled);
+    void setThermalVideoSink(QVideoSink *sink);
+    void setThermalPrimaryDisplay(bool primary);
 
     // QML-callable methods
     Q_INVOKABLE void toggleThermalStream();
     Q_INVOKABLE void startThermalStream();
     Q_INVOKABLE void stopThermalStream();
+    // folder defaults to the Movies location
+    Q_INVOKABLE void startThermalStreamRecording(const QString &folder = QString());
+    Q_INVOKABLE void stopThermalStreamRecording();
+    // Captures every received datagram to folder (Movies when empty), and replays a
+    // capture through the thermal model instead of the socket
+    Q_INVOKABLE void startThermalPacketCapture(const QString &folder = QString());
+    Q_INVOKABLE void stopThermalPacketCapture();
+    Q_INVOKABLE void replayThermalCapture(const QString &filePath, bool realTime = true);
+    // Frame on screen right now, -1 before the first one; see CameraViewModel::saveFrame
+    Q_INVOKABLE int thermalPresentedFrameId() const;
+    Q_INVOKABLE QString saveThermalFrame(const QString &folder = QString(), int frameId = -1);
 
 signals:
     void thermalIpAddressChanged();
@@ -58,16 +204,59 @@ signals:
     void thermalFrameChanged();
     void thermalFrameCountChanged();
     void thermalFrameRateChanged();
+    void thermalBatchedIngestChanged();
+    void thermalReactorIngestChanged();
+    void thermalProgressiveDisplayChanged();
+    void thermalMulticastGroupChanged();
+    void thermalRelayDestinationsChanged();
+    void thermalRelayOnlyChanged();
+    void thermalRelayStatisticsChanged();
+    void thermalFrameExportNameChanged();
+    void thermalDecodedFrameExportChanged();
+    void thermalFrameExportStatisticsChanged();
+    void thermalFecStatisticsChanged();
+    void thermalReassemblyStatisticsChanged();
+    void thermalVideoSinkOutputChanged();
+    void thermalVideoSinkChanged();
+    void thermalPrimaryDisplayChanged();
+    void thermalDecoderStatisticsChanged();
+    void thermalLatencyStatisticsChanged();
+    void thermalLinkStatisticsChanged();
+    void thermalStreamRecordingChanged();
+    void thermalStreamRecordingStatisticsChanged();
+    void thermalStreamRecordingError(const QString &error);
+    void thermalPacketCaptureChanged();
+    void thermalReplayFinished(quint64 datagrams);
 
     // Internal signals for thread communication
     void requestStartThermalStream(const QString &ipAddress, int port);
     void requestStopThermalStream();
+    void requestThermalBatchedIngest(bool enabled);
+    void requestThermalReactorIngest(bool enabled);
+    void requestThermalProgressiveDisplay(bool enabled);
+    void requestThermalMulticastGroup(const QString &group);
+    void requestThermalRelayDestinations(const QStringList &destinations);
+    void requestThermalRelayOnly(bool enabled);
+    void requestThermalFrameExport(const QString &name);
+    void requestThermalDecodedFrameExport(const QString &name);
+    void requestThermalVideoFrameOutput(bool enabled);
+    void requestStartThermalCapture(const QString &filePath);
+    void requestStopThermalCapture();
+    void requestStartThermalReplay(const QString &filePath, bool realTime);
 
 private slots:
     void onThermalStreamingStatusChanged(bool streaming);
-    void onThermalFrameReceived(const QByteArray &frameData);
+    void onThermalFramePending();
+    void onThermalFrameReceived(const LatestFrameMailbox::Frame &frame);
     void onThermalCameraError(const QString &error);
     void onThermalConnectionEstablished();
+    void onThermalFecStatisticsChanged(quint64 recoveredFrames, quint64 unrecoverableFrames);
+    void onThermalReassemblyStatisticsChanged(qint64 bytesInUse, qint64 peakBytes, quint64 evictedFrames);
+    void onThermalRelayStatisticsChanged(quint64 forwardedDatagrams, quint64 droppedDatagrams);
+    void onThermalFrameExportStatisticsChanged(quint64 exportedFrames, quint64 oversizedFrames);
+    void onThermalStreamRecordingStopped(const QString &filePath, quint64 frames);
+    void onThermalCaptureStatusChanged(bool capturing, const QString &filePath);
+    void onThermalStreamRecordingError(const QString &error);
     void calculateThermalFrameRate();
 
 private:
@@ -75,14 +264,55 @@ private:
     QThread *m_thermalCameraThread;
     ThermalCameraModel *m_thermalCameraModel;
 
+    // JPEG decoding on the shared decoder pool, fed by the thermal camera model
+    FrameDecoder *m_thermalFrameDecoder;
+
     // Properties
     QString m_thermalIpAddress;
     int m_thermalPort;
     bool m_thermalStreaming;
     QString m_thermalCameraStatus;
-    QString m_currentThermalFrameUrl;
     int m_thermalFrameCount;
     double m_thermalFrameRate;
+    bool m_thermalBatchedIngest;
+    bool m_thermalReactorIngest;
+    bool m_thermalProgressiveDisplay = false;
+    QString m_thermalMulticastGroup;
+    QStringList m_thermalRelayDestinations;
+    bool m_thermalRelayOnly = false;
+    quint64 m_thermalRelayedDatagrams = 0;
+    quint64 m_thermalRelayDroppedDatagrams = 0;
+
+    // Shared memory frame export
+    QString m_thermalFrameExportName;
+    bool m_thermalDecodedFrameExport = false;
+    quint64 m_thermalExportedFrames = 0;
+    quint64 m_thermalExportOversizedFrames = 0;
+    LatestFrameMailbox m_thermalFrameMailbox;       // encoded frames, thermal model -> decoder
+    LatestFrameMailbox m_thermalDecodedMailbox;     // decoded frames, decoder -> view model
+    VideoFrameSource *m_thermalFrameSource;
+    quint64 m_thermalDisplayDroppedFrames = 0;    // frames superseded in the mailboxes before display
+    bool m_thermalVideoSinkOutput = false;
+    QPointer<QVideoSink> m_thermalVideoSink;      // owned by the VideoOutput in QML
+    bool m_thermalPrimaryDisplay = false;         // shown in the picture-in-picture view by default
+    FrameDecoder::Statistics m_thermalDecoderStatistics;
+    std::array<LatencyStatistics::Percentiles, LatencyStatistics::StageCount> m_thermalLatency;
+    bool m_thermalLatencyIncludesCapture = false;
+    quint64 m_thermalSinkFrameSerial = 0;
+    LinkStatistics m_thermalLinkStatistics;           // written by the model under its buffer mutex, see setLinkStatistics()
+    LinkStatistics::Snapshot m_thermalLinkSnapshot;
+    LinkStatistics::Rates m_thermalLinkRates;
+    QElapsedTimer m_thermalLinkSampleTimer;
+    StreamRecorder *m_thermalStreamRecorder;    // fed by the model on its thread
+    QString m_thermalStreamRecordingPath;
+    quint64 m_thermalStreamRecordedFrames = 0;
+    quint64 m_thermalStreamRecordingDroppedFrames = 0;
+    QString m_thermalPacketCapturePath;     // empty unless capturing
+    quint64 m_thermalFecRecoveredFrames = 0;
+    quint64 m_thermalFecUnrecoverableFrames = 0;
+    qint64 m_thermalReassemblyBytes = 0;
+    qint64 m_thermalReassemblyPeakBytes = 0;
+    quint64 m_thermalReassemblyEvictedFrames = 0;
 
     // Frame rate calculation
     QTimer *m_thermalFrameRateTimer;
@@ -90,20 +320,6 @@ private:
     qint64 m_lastThermalFrameTime;
 
     void setupThermalThread();
-    void updateThermalFrameUrl(const QByteArray &frameData);
-};
-
-// Custom image provider for displaying thermal camera frames
-class ThermalImageProvider : public QQuickImageProvider
-{
-public:
-    ThermalImageProvider();
-    QPixmap requestPixmap(const QString &id, QSize *size, const QSize &requestedSize) override;
-    void updateFrame(const QString &id, const QByteArray &frameData);
-
-private:
-    QMap<QString, QByteArray> m_frameData;
-    QMutex m_mutex;
 };
 
 #endif // THERMALCAMERAVIEWMODEL_H
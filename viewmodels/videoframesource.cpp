@@ -0,0 +1,69 @@
+#include "videoframesource.h"
+
+VideoFrameSource::VideoFrameSource(QObject *parent)
+    : QObject(parent)
+    , m_frameId(-1)
+    , m_serial(0)
+    , m_latency(std::make_shared<LatencyStatistics>())
+    , m_history(std::make_shared<FrameHistory>())
+{
+}
+
+VideoFrameSource::VideoFrameSource(const VideoFrameSource *upstream, QObject *parent)
+    : QObject(parent)
+    , m_frameId(-1)
+    , m_serial(0)
+    , m_latency(upstream->latency())
+    , m_history(upstream->history())
+{
+}
+
+void VideoFrameSource::setFrame(const QImage &frame, const FrameTiming &timing, int frameId)
+{
+    const bool sizeChanged = frame.size() != m_frame.size();
+    const bool hadFrame = hasFrame();
+
+    m_frame = frame;
+    m_frameTiming = timing;
+    m_frameId = frameId;
+    m_serial++;
+
+    emit frameChanged();
+    if (sizeChanged) {
+        emit frameSizeChanged();
+    }
+    if (hadFrame != hasFrame()) {
+        emit hasFrameChanged();
+    }
+}
+
+void VideoFrameSource::addToHistory(const LatestFrameMailbox::Frame &frame)
+{
+    m_history->add(frame);
+    emit frameAdded(frame.frameId);
+}
+
+void VideoFrameSource::setConsumerSize(const QObject *consumer, const QSize &pixelSize)
+{
+    if (pixelSize.isEmpty()) {
+        m_consumerSizes.remove(consumer);
+    } else {
+        m_consumerSizes.insert(consumer, pixelSize);
+    }
+
+    QSize requested;
+    for (const QSize &size : std::as_const(m_consumerSizes)) {
+        requested = requested.expandedTo(size);
+    }
+    if (requested != m_requestedSize) {
+        m_requestedSize = requested;
+        emit requestedSizeChanged(m_requestedSize);
+    }
+}
+
+void VideoFrameSource::clear()
+{
+    if (!m_frame.isNull()) {
+        setFrame(QImage());
+    }
+}
@@ -0,0 +1,77 @@
+#ifndef VIDEOFRAMESOURCE_H
+#define VIDEOFRAMESOURCE_H
+
+#include <QObject>
+#include <QImage>
+#include <QSize>
+#include <QHash>
+#include <memory>
+#include "models/frametiming.h"
+#include "models/latencystatistics.h"
+#include "models/framehistory.h"
+
+// Latest decoded frame of a video stream, published by a camera view model on the GUI
+// thread and rendered by any number of VideoSurface items.
+//
+// Surfaces report the pixel size they display the stream at; requestedSize() is the
+// largest of them, so the decoder never produces more pixels than any view can show.
+//
+// Each frame carries its FrameTiming; surfaces complete it with the upload and
+// presentation times and record it in latency(), which the render thread may do.
+// Likewise they mark the frame presented in history(), filled by the view model.
+class VideoFrameSource : public QObject
+{
+    Q_OBJECT
+    Q_PROPERTY(QSize frameSize READ frameSize NOTIFY frameSizeChanged)
+    Q_PROPERTY(bool hasFrame READ hasFrame NOTIFY hasFrameChanged)
+
+public:
+    explicit VideoFrameSource(QObject *parent = nullptr);
+
+    // Republishes frames of upstream: shares its latency() and history(), so frames shown
+    // through this source are accounted to the stream they came from
+    explicit VideoFrameSource(const VideoFrameSource *upstream, QObject *parent = nullptr);
+
+    QImage frame() const { return m_frame; }
+    FrameTiming frameTiming() const { return m_frameTiming; }
+    int frameId() const { return m_frameId; }      // -1 when not in the history
+    QSize frameSize() const { return m_frame.size(); }
+    bool hasFrame() const { return !m_frame.isNull(); }
+
+    // Incremented with every frame, lets surfaces skip redundant texture uploads
+    quint64 serial() const { return m_serial; }
+
+    void setFrame(const QImage &frame, const FrameTiming &timing = FrameTiming(), int frameId = -1);
+
+    // Adds a complete frame to history(), whichever output displays it
+    void addToHistory(const LatestFrameMailbox::Frame &frame);
+
+    void clear();
+
+    // Display size of one consumer in device pixels, an empty size removes it
+    void setConsumerSize(const QObject *consumer, const QSize &pixelSize);
+    QSize requestedSize() const { return m_requestedSize; }
+
+    // Shared with the surfaces' render thread, outlives the source if needed
+    std::shared_ptr<LatencyStatistics> latency() const { return m_latency; }
+    std::shared_ptr<FrameHistory> history() const { return m_history; }
+
+signals:
+    void frameChanged();
+    void frameSizeChanged();
+    void hasFrameChanged();
+    void requestedSizeChanged(const QSize &size);
+    void frameAdded(quint16 frameId);
+
+private:
+    QImage m_frame;
+    FrameTiming m_frameTiming;
+    int m_frameId;
+    quint64 m_serial;
+    QHash<const QObject *, QSize> m_consumerSizes;
+    QSize m_requestedSize;
+    std::shared_ptr<LatencyStatistics> m_latency;
+    std::shared_ptr<FrameHistory> m_history;
+};
+
+#endif // VIDEOFRAMESOURCE_H